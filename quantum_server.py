@@ -1,8 +1,15 @@
 import http.server
 import socketserver
+import argparse
+import asyncio
 import json
+import math
+import base64
 import logging
+import socket
+from concurrent.futures import ThreadPoolExecutor
 from datetime import datetime
+from urllib.parse import urlsplit, parse_qs
 from qiskit import QuantumCircuit
 from qiskit_aer import AerSimulator
 
@@ -11,6 +18,20 @@ PORT = 8609
 IP = "91.99.90.39"
 LOG_FILE = "servidor_logs.txt"
 
+# Lotes de /generate_bits: qubits por circuito y límites de bits por petición
+BATCH_QUBITS = 16
+BATCH_DEFAULT_BITS = 4096
+BATCH_MAX_BITS = 1 << 16
+
+# Modo asíncrono (--async): reservorio de bits medidos por adelantado
+RESERVOIR_CAPACITY_BITS = 1 << 23       # 1 MiB de bits listos para servir
+RESERVOIR_LOW_WATER_BITS = 1 << 21      # Por debajo de esto se rellena
+RESERVOIR_CHUNK_BITS = 1 << 18          # Bits por trabajo de Aer (16384 shots)
+RESERVOIR_WORKERS = 2                   # Trabajos de Aer en paralelo
+RESERVOIR_TAKE_TIMEOUT_S = 5            # Espera máxima de una petición por bits
+RESERVOIR_MAX_FAILURES = 3              # Trabajos fallidos antes de responder 503
+STATS_INTERVAL_S = 60                   # Resumen periódico en el log
+
 # SIMULADOR CUÁNTICO GLOBAL
 QUANTUM_SIMULATOR = AerSimulator()
 
@@ -26,9 +47,150 @@ class ThreadedReusableServer(socketserver.ThreadingMixIn, socketserver.TCPServer
     allow_reuse_address = True
     daemon_threads = True
 
+def generate_bits(count):
+    """Mide `count` qubits en superposición con un único trabajo de Aer.
+
+    Un circuito de BATCH_QUBITS qubits con Hadamard en todos se ejecuta con
+    tantos shots como hagan falta; cada shot aporta BATCH_QUBITS bits.
+    Devuelve los bits empaquetados MSB primero (relleno con ceros al final).
+    """
+    circuit = QuantumCircuit(BATCH_QUBITS, BATCH_QUBITS)
+    circuit.h(range(BATCH_QUBITS))
+    circuit.measure(range(BATCH_QUBITS), range(BATCH_QUBITS))
+
+    shots = (count + BATCH_QUBITS - 1) // BATCH_QUBITS
+    result = QUANTUM_SIMULATOR.run(circuit, shots=shots, memory=True).result()
+    bits = "".join(result.get_memory(circuit))[:count]
+
+    bits += "0" * (-len(bits) % 8)
+    return int(bits, 2).to_bytes(len(bits) // 8, "big")
+
+
+def measure_with_probability(p):
+    """Prepara un qubit con RY(θ), θ = 2·asin(√p), y lo mide una vez.
+
+    RY(θ)|0> = cos(θ/2)|0> + sin(θ/2)|1>, así que P(1) = sin²(θ/2) = p.
+    """
+    if not 0.0 <= p <= 1.0:
+        raise ValueError("p debe estar en [0, 1]")
+
+    circuit = QuantumCircuit(1, 1)
+    circuit.ry(2.0 * math.asin(math.sqrt(p)), 0)
+    circuit.measure(0, 0)
+
+    result = QUANTUM_SIMULATOR.run(circuit, shots=1, memory=True).result()
+    return int(result.get_memory(circuit)[0])
+
+
+# --- CUERPOS DE RESPUESTA (compartidos por los dos modos) ---
+
+def parse_bit_count(query):
+    count = int(query.get("n", [BATCH_DEFAULT_BITS])[0])
+    return max(1, min(count, BATCH_MAX_BITS))
+
+
+def bits_body(payload, count, fmt):
+    """Devuelve (content_type, cuerpo) de /generate_bits."""
+    if fmt == "base64":
+        body = json.dumps({
+            "success": True,
+            "bits": count,
+            "data": base64.b64encode(payload).decode("ascii"),
+            "source": "quantum_simulation",
+        }).encode("utf-8")
+        return "application/json", body
+    return "application/octet-stream", payload
+
+
+def measure_body(p, value):
+    return json.dumps({
+        "success": True,
+        "value": value,
+        "p": p,
+        "source": "quantum_simulation",
+    }).encode("utf-8")
+
+
+def bit_body(value):
+    return json.dumps({
+        "success": True,
+        "value": value,
+        "source": "quantum_simulation",
+        "timestamp": datetime.now().strftime("%H:%M:%S")
+    }).encode("utf-8")
+
+
+INDEX_BODY = ("Servidor Cuántico Ejecutándose. Usa /generate_bit para obtener un bit aleatorio "
+              "o /generate_bits?n=N[&format=base64] para un lote de N bits, "
+              "o /measure?p=P para medir un qubit que vale 1 con probabilidad P.").encode("utf-8")
+
+
 class QuantumHandler(http.server.SimpleHTTPRequestHandler):
+    # HTTP/1.1: conexiones persistentes (keep-alive) y pipelining para el
+    # cliente nativo del juego. Toda respuesta debe llevar Content-Length.
+    protocol_version = "HTTP/1.1"
+    # Cabeceras y cuerpo salen en escrituras separadas: sin TCP_NODELAY cada
+    # respuesta pequeña espera al ACK retardado del cliente (~40 ms)
+    disable_nagle_algorithm = True
+
     def do_GET(self):
-        if self.path == "/generate_bit":
+        url = urlsplit(self.path)
+
+        if url.path == "/generate_bits":
+            try:
+                query = parse_qs(url.query)
+                count = parse_bit_count(query)
+                fmt = query.get("format", ["raw"])[0]
+
+                payload = generate_bits(count)
+                content_type, body = bits_body(payload, count, fmt)
+
+                self.send_response(200)
+                self.send_header("Content-type", content_type)
+                self.send_header("Content-Length", str(len(body)))
+                self.send_header("X-Bit-Count", str(count))
+                self.send_header("Access-Control-Allow-Origin", "*")
+                self.end_headers()
+                self.wfile.write(body)
+
+                logging.info(f"Lote Cuántico desde {self.client_address[0]} | {count} bits")
+                return
+
+            except ValueError as e:
+                self.send_error(400, str(e))
+                return
+            except Exception as e:
+                logging.error(f"Error Cuántico: {e}")
+                self.send_error(500, str(e))
+                return
+
+        if url.path == "/measure":
+            try:
+                query = parse_qs(url.query)
+                p = float(query["p"][0])
+                value = measure_with_probability(p)
+
+                body = measure_body(p, value)
+
+                self.send_response(200)
+                self.send_header("Content-type", "application/json")
+                self.send_header("Content-Length", str(len(body)))
+                self.send_header("Access-Control-Allow-Origin", "*")
+                self.end_headers()
+                self.wfile.write(body)
+
+                logging.info(f"Medida RY desde {self.client_address[0]} | p={p} | Resultado: {value}")
+                return
+
+            except (KeyError, ValueError) as e:
+                self.send_error(400, str(e))
+                return
+            except Exception as e:
+                logging.error(f"Error Cuántico: {e}")
+                self.send_error(500, str(e))
+                return
+
+        if url.path == "/generate_bit":
             try:
                 # Crear circuito cuántico (1 Qubit, 1 Bit Clásico)
                 circuit = QuantumCircuit(1, 1)
@@ -45,21 +207,17 @@ class QuantumHandler(http.server.SimpleHTTPRequestHandler):
                 quantum_bit = int(memory[0]) # Resultado: 0 o 1
 
                 # Preparar respuesta
-                response = {
-                    "success": True,
-                    "value": quantum_bit,
-                    "source": "quantum_simulation",
-                    "timestamp": datetime.now().strftime("%H:%M:%S")
-                }
+                body = bit_body(quantum_bit)
 
                 # Enviar cabeceras
                 self.send_response(200)
                 self.send_header("Content-type", "application/json")
+                self.send_header("Content-Length", str(len(body)))
                 self.send_header("Access-Control-Allow-Origin", "*")
                 self.end_headers()
 
                 # Enviar cuerpo
-                self.wfile.write(json.dumps(response).encode("utf-8"))
+                self.wfile.write(body)
 
                 logging.info(f"Petición Cuántica desde {self.client_address[0]} | Resultado: {quantum_bit}")
                 return
@@ -68,25 +226,287 @@ class QuantumHandler(http.server.SimpleHTTPRequestHandler):
                 logging.error(f"Error Cuántico: {e}")
                 self.send_error(500, str(e))
                 return
-        
+
         # Respuesta por defecto para raíz o rutas desconocidas
+        body = INDEX_BODY
         self.send_response(200)
         self.send_header("Content-type", "text/plain; charset=utf-8")
+        self.send_header("Content-Length", str(len(body)))
         self.end_headers()
-        self.wfile.write(b"Servidor Cuántico Ejecutándose. Usa /generate_bit para obtener un bit aleatorio.")
+        self.wfile.write(body)
 
     def log_message(self, format, *args):
         # Silenciar logging por defecto a consola, confiar en la configuración custom
         pass
 
+
+# --- MODO ASÍNCRONO ---
+
+class ReservoirUnavailable(Exception):
+    """El reservorio no ha podido reunir los bits pedidos a tiempo."""
+
+
+class BitReservoir:
+    """Bits medidos por adelantado con trabajos grandes de Aer.
+
+    Los trabajos de RESERVOIR_CHUNK_BITS bits se ejecutan en un pool de
+    hilos (Aer suelta el GIL mientras simula) y se añaden al final; las
+    peticiones consumen bits desde el principio sin lanzar ningún circuito.
+    Sólo se usa desde el bucle de asyncio, así que no necesita locks.
+    """
+
+    def __init__(self, executor):
+        self.executor = executor
+        self.data = bytearray()
+        self.pos = 0  # Bits ya servidos desde el inicio de `data`
+        self.jobs = 0  # Trabajos de Aer en vuelo
+        self.refilled = asyncio.Event()
+        self.bits_generated = 0
+        self.bits_served = 0
+        self.jobs_failed = 0
+
+    def available(self):
+        return len(self.data) * 8 - self.pos
+
+    def refill(self):
+        """Lanza trabajos hasta cubrir la capacidad (sin esperar)."""
+        loop = asyncio.get_running_loop()
+        while (self.jobs < RESERVOIR_WORKERS and
+               self.available() + self.jobs * RESERVOIR_CHUNK_BITS
+               < RESERVOIR_CAPACITY_BITS):
+            self.jobs += 1
+            job = loop.run_in_executor(self.executor, generate_bits,
+                                       RESERVOIR_CHUNK_BITS)
+            job.add_done_callback(self._job_done)
+
+    def _job_done(self, job):
+        self.jobs -= 1
+        try:
+            chunk = job.result()
+        except Exception as e:
+            # Sin relanzar aquí: si Aer sigue fallando no se entra en un bucle
+            # de trabajos; los relanzan las peticiones que esperan bits
+            self.jobs_failed += 1
+            logging.error(f"Error Cuántico rellenando el reservorio: {e}")
+            self.refilled.set()
+            return
+        self.data += chunk
+        self.bits_generated += len(chunk) * 8
+        self.refilled.set()
+        if self.available() < RESERVOIR_LOW_WATER_BITS:
+            self.refill()
+
+    async def take(self, count):
+        """Devuelve `count` bits empaquetados MSB primero (relleno con ceros).
+
+        Lanza ReservoirUnavailable si fallan RESERVOIR_MAX_FAILURES trabajos
+        o pasan RESERVOIR_TAKE_TIMEOUT_S segundos sin reunir los bits.
+        """
+        loop = asyncio.get_running_loop()
+        deadline = loop.time() + RESERVOIR_TAKE_TIMEOUT_S
+        failed = self.jobs_failed
+        while self.available() < count:
+            if self.jobs_failed - failed >= RESERVOIR_MAX_FAILURES:
+                raise ReservoirUnavailable(
+                    f"{self.jobs_failed - failed} trabajos de Aer fallidos")
+            remaining = deadline - loop.time()
+            if remaining <= 0:
+                raise ReservoirUnavailable(
+                    f"sin bits tras {RESERVOIR_TAKE_TIMEOUT_S} s")
+            self.refill()
+            self.refilled.clear()
+            try:
+                await asyncio.wait_for(self.refilled.wait(), remaining)
+            except asyncio.TimeoutError:
+                pass
+
+        start = self.pos
+        end = start + count
+        first, last = start // 8, (end + 7) // 8
+        value = int.from_bytes(self.data[first:last], "big")
+        value = (value >> (last * 8 - end)) & ((1 << count) - 1)
+        self.pos = end
+        self.bits_served += count
+
+        # Descartar los bytes ya servidos de vez en cuando, no en cada petición
+        if self.pos >= RESERVOIR_CHUNK_BITS:
+            del self.data[:self.pos // 8]
+            self.pos %= 8
+        if self.available() < RESERVOIR_LOW_WATER_BITS:
+            self.refill()
+
+        pad = -count % 8
+        return (value << pad).to_bytes((count + pad) // 8, "big")
+
+    async def take_bit(self):
+        return (await self.take(1))[0] >> 7
+
+    async def measure(self, p):
+        """Vale 1 con probabilidad p, con la misma distribución que RY(θ).
+
+        Compara bit a bit un uniforme U = 0.b1b2b3... del reservorio con la
+        expansión binaria de p (dos bits de media) en vez de lanzar un
+        circuito por petición.
+        """
+        if not 0.0 <= p <= 1.0:
+            raise ValueError("p debe estar en [0, 1]")
+        if p >= 1.0:
+            return 1
+        for _ in range(53):
+            if p <= 0.0:
+                break
+            p *= 2.0
+            p_bit = 1 if p >= 1.0 else 0
+            p -= p_bit
+            u_bit = await self.take_bit()
+            if u_bit != p_bit:
+                return 1 if u_bit < p_bit else 0
+        return 0
+
+
+def http_response(status, reason, content_type, body, keep_alive, extra=()):
+    head = [f"HTTP/1.1 {status} {reason}",
+            f"Content-Type: {content_type}",
+            f"Content-Length: {len(body)}",
+            "Access-Control-Allow-Origin: *"]
+    head.extend(extra)
+    if not keep_alive:
+        head.append("Connection: close")
+    return ("\r\n".join(head) + "\r\n\r\n").encode("latin-1") + body
+
+
+class AsyncQuantumServer:
+    def __init__(self, reservoir):
+        self.reservoir = reservoir
+        self.requests = 0
+        self.connections = 0
+
+    async def route(self, target):
+        """Devuelve (estado, motivo, content_type, cuerpo, cabeceras extra)."""
+        url = urlsplit(target)
+        query = parse_qs(url.query)
+        try:
+            if url.path == "/generate_bits":
+                count = parse_bit_count(query)
+                fmt = query.get("format", ["raw"])[0]
+                payload = await self.reservoir.take(count)
+                content_type, body = bits_body(payload, count, fmt)
+                return 200, "OK", content_type, body, (f"X-Bit-Count: {count}",)
+
+            if url.path == "/measure":
+                p = float(query["p"][0])
+                value = await self.reservoir.measure(p)
+                return 200, "OK", "application/json", measure_body(p, value), ()
+
+            if url.path == "/generate_bit":
+                value = await self.reservoir.take_bit()
+                return 200, "OK", "application/json", bit_body(value), ()
+
+        except (KeyError, ValueError) as e:
+            return 400, "Bad Request", "text/plain", str(e).encode("utf-8"), ()
+        except ReservoirUnavailable as e:
+            logging.error(f"Reservorio sin bits: {e}")
+            return (503, "Service Unavailable", "text/plain",
+                    str(e).encode("utf-8"), ("Retry-After: 1",))
+        except Exception as e:
+            logging.error(f"Error Cuántico: {e}")
+            return (500, "Internal Server Error", "text/plain",
+                    str(e).encode("utf-8"), ())
+
+        return 200, "OK", "text/plain; charset=utf-8", INDEX_BODY, ()
+
+    async def handle(self, reader, writer):
+        sock = writer.get_extra_info("socket")
+        if sock is not None:
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.connections += 1
+
+        try:
+            while True:
+                request_line = await reader.readline()
+                if not request_line:
+                    break
+
+                headers = {}
+                while True:
+                    line = await reader.readline()
+                    if line in (b"\r\n", b"\n", b""):
+                        break
+                    name, _, value = line.decode("latin-1").partition(":")
+                    headers[name.strip().lower()] = value.strip().lower()
+
+                # Cuerpos de petición: no se usan, pero hay que consumirlos
+                length = int(headers.get("content-length", "0") or 0)
+                if length > 0:
+                    await reader.readexactly(length)
+
+                parts = request_line.decode("latin-1").split()
+                if len(parts) != 3:
+                    writer.write(http_response(400, "Bad Request", "text/plain",
+                                               b"", False))
+                    break
+                _, target, version = parts
+                connection = headers.get("connection", "")
+                keep_alive = (connection != "close" if version == "HTTP/1.1"
+                              else connection == "keep-alive")
+
+                status, reason, content_type, body, extra = await self.route(target)
+                writer.write(http_response(status, reason, content_type, body,
+                                           keep_alive, extra))
+                self.requests += 1
+
+                await writer.drain()
+                if not keep_alive:
+                    break
+        except (ConnectionError, asyncio.IncompleteReadError, ValueError):
+            pass
+        finally:
+            self.connections -= 1
+            writer.close()
+
+    async def report(self):
+        while True:
+            await asyncio.sleep(STATS_INTERVAL_S)
+            logging.info(f"Reservorio: {self.reservoir.available()} bits | "
+                         f"{self.reservoir.jobs_failed} trabajos fallidos | "
+                         f"{self.requests} peticiones | "
+                         f"{self.connections} conexiones abiertas")
+
+
+async def serve_async(port):
+    executor = ThreadPoolExecutor(max_workers=RESERVOIR_WORKERS)
+    reservoir = BitReservoir(executor)
+    app = AsyncQuantumServer(reservoir)
+
+    reservoir.refill()
+    server = await asyncio.start_server(app.handle, "0.0.0.0", port,
+                                        reuse_address=True, backlog=1024)
+    asyncio.get_running_loop().create_task(app.report())
+    async with server:
+        await server.serve_forever()
+
+
 if __name__ == "__main__":
-    print(f"Servidor Cuántico corriendo en el puerto {PORT}...")
-    print(f"IP Configurada: {IP}") 
+    parser = argparse.ArgumentParser(description="Servidor cuántico de Phase Shift")
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--async", dest="use_async", action="store_true",
+                        help="bucle asyncio que sirve desde un reservorio de bits")
+    args = parser.parse_args()
+
+    print(f"Servidor Cuántico corriendo en el puerto {args.port}...")
+    print(f"IP Configurada: {IP}")
     print(f"Logs en {LOG_FILE}")
-    
-    # Se utiliza 0.0.0.0 para escuchar en todas las interfaces, usando el puerto definido
-    with ThreadedReusableServer(("0.0.0.0", PORT), QuantumHandler) as httpd:
+
+    if args.use_async:
+        print(f"Modo asíncrono: reservorio de {RESERVOIR_CAPACITY_BITS} bits")
         try:
-            httpd.serve_forever()
+            asyncio.run(serve_async(args.port))
         except KeyboardInterrupt:
             pass
+    else:
+        # Se utiliza 0.0.0.0 para escuchar en todas las interfaces, usando el puerto definido
+        with ThreadedReusableServer(("0.0.0.0", args.port), QuantumHandler) as httpd:
+            try:
+                httpd.serve_forever()
+            except KeyboardInterrupt:
+                pass
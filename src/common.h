@@ -1,10 +1,12 @@
 #ifndef COMMON_H
 #define COMMON_H
 
-#include "audio.h"
+#include "qiskit.h"
 #include "raylib.h"
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,6 +16,14 @@
 #define M_PI 3.14159265358979323846f
 #endif
 
+// Estático con una copia por hilo: el azar de la simulación, para que
+// varios hilos puedan jugar turnos a la vez (tools/level_solver.c)
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 #define SCREEN_WIDTH 1600
 #define SCREEN_HEIGHT 900
 // #define DEBUG_MODE
@@ -24,9 +34,11 @@
 #define MAX_ECHOS 3
 #define MAX_ENTANGLED 10
 #define MAX_DETECTORS 10
+#define MAX_BEAM_LENGTH 32 // Tope de view_distance de un detector
 #define MAX_TUNNELS 5
 #define MAX_PORTALS 10
 #define MAX_QUBITS 5
+#define QREG_MAX_STATES (1 << MAX_QUBITS)
 #define MAX_ORACLES 5
 #define MAX_ECHO_FRAMES 20
 #define SUPERPOSITION_DURATION 12
@@ -35,7 +47,9 @@
 #define EXPLOSION_LENGTH 10
 #define EYES_ANGULAR_VELOCITY 10.0f
 #define MAX_LEVELS 20
-#define MAX_BUTTONS 10
+#define MAX_BUTTONS 10 // Cabe en una máscara de 32 bits (buttons_pressed)
+#define MAX_TRIGGERS 8
+#define MAX_TRIGGER_CELLS 128
 #define MAX_DIALOG_PAGES 12
 #define MAX_DIALOG_TEXT 512
 
@@ -85,6 +99,7 @@ typedef enum {
 } EyesKind;
 
 typedef enum { PHASE_RED, PHASE_BLUE, PHASE_GREEN, PHASE_YELLOW } PhaseKind;
+#define PHASE_COUNT 4
 
 typedef enum { PHASE_STATE_STABLE, PHASE_STATE_SUPERPOSITION } PhaseState;
 
@@ -153,6 +168,14 @@ typedef struct {
     int current_length; // Actual beam length blocked by walls
     bool is_active;
     float beam_alpha;
+    // Recorrido del rayo (con reflejos) cacheado: sólo depende de los
+    // espejos, los límites del mapa y los oráculos, así que se recalcula
+    // cuando cambia GameState.beam_generation
+    IVector2 beam_cells[MAX_BEAM_LENGTH];
+    int beam_length;         // Casillas dentro del mapa
+    uint32_t beam_mirrors;   // Bit s: beam_cells[s] es un espejo
+    uint32_t beam_oracles;   // Bit s: hay un oráculo en beam_cells[s]
+    unsigned beam_generation;
 } QuantumDetector;
 
 typedef struct {
@@ -163,6 +186,25 @@ typedef struct {
     bool last_failed;
 } QuantumTunnel;
 
+// Índice espacial de entidades fijas (objetos, botones, portales y
+// oráculos): cada casilla guarda la cabeza de una lista intrusiva enlazada
+// por el campo next_at_cell de cada entidad. Una referencia empaqueta tipo e
+// índice del array; 0 marca el final de la lista.
+typedef enum {
+    ENTITY_NONE,
+    ENTITY_ITEM,
+    ENTITY_BUTTON,
+    ENTITY_PORTAL,
+    ENTITY_ORACLE
+} EntityKind;
+
+typedef uint16_t EntityRef;
+#define ENTITY_INDEX_BITS 12 // Hasta 4096 entidades de cada tipo
+#define ENTITY_REF(kind, index)                                                \
+    ((EntityRef)(((unsigned)(kind) << ENTITY_INDEX_BITS) | (unsigned)(index)))
+#define ENTITY_REF_KIND(ref) ((EntityKind)((ref) >> ENTITY_INDEX_BITS))
+#define ENTITY_REF_INDEX(ref) ((int)((ref) & ((1u << ENTITY_INDEX_BITS) - 1)))
+
 typedef struct {
     IVector2 position;
     int linked_portal_index;
@@ -170,11 +212,21 @@ typedef struct {
     bool requires_entanglement;
     float glow_intensity;
     bool active;
+    EntityRef next_at_cell;
 } QuantumPortal;
 
+// Registro cuántico: vector de estado de hasta MAX_QUBITS qubits.
+// Amplitudes complejas en dos arrays (re/im) alineados para SIMD; el índice
+// de cada amplitud es la base computacional (bit k = qubit k).
 typedef struct {
-    float alpha_real, alpha_imag; // Amplitude |0>
-    float beta_real, beta_imag;   // Amplitude |1>
+    float re[QREG_MAX_STATES] __attribute__((aligned(32)));
+    float im[QREG_MAX_STATES] __attribute__((aligned(32)));
+    int num_qubits;
+} QuantumRegister;
+
+typedef struct {
+    QuantumRegister *reg; // Registro que contiene su amplitud (NULL: libre)
+    int wire;             // Índice del qubit dentro del registro
     bool is_measured;
     int measured_value;
     bool active;
@@ -188,6 +240,7 @@ typedef struct {
     int query_count;
     bool inverts_phase;
     bool active;
+    EntityRef next_at_cell;
 } GroverOracle;
 
 typedef struct {
@@ -212,6 +265,7 @@ typedef struct {
     int stuck_turns;
     Qubit qubits[MAX_QUBITS];
     int qubit_count;
+    QuantumRegister qreg; // Estado conjunto (entrelazado) de qubits[]
     bool next_echo_permanent;
 
     // Statistics
@@ -240,9 +294,6 @@ typedef struct {
     EyesKind eyes;
     EyesKind prev_eyes;
     IVector2 size;
-    int **path;
-    int path_rows;
-    int path_cols;
     bool damaged;
     float health;
     int attack_cooldown;
@@ -278,14 +329,80 @@ typedef struct {
     ItemKind kind;
     IVector2 position;
     int cooldown;
+    EntityRef next_at_cell;
 } Item;
 
+// Mapa contiguo: un único bloque alineado de uint8_t por filas de `stride`
+// bytes (múltiplo de MAP_STRIDE_ALIGN), rodeado de MAP_BORDER casillas de
+// CELL_WALL como centinela. Leer hasta MAP_BORDER casillas fuera del mapa
+// es seguro y devuelve pared, así que los bucles que se paran en una pared
+// no necesitan within_map. Acceder siempre con MAP_AT.
+#define MAP_BORDER 2
+#define MAP_STRIDE_ALIGN 16
+
 typedef struct {
-    Cell **data;
+    uint8_t *cells; // Casilla (0, 0) dentro del bloque
+    uint8_t *block; // Reserva completa, borde incluido
     int rows;
     int cols;
+    int stride;
 } Map;
 
+#define MAP_AT(map, x, y)                                                      \
+    ((map)->cells[(ptrdiff_t)(y) * (map)->stride + (x)])
+
+// Bitboards de paso derivados del Map: cada fila ocupa `words` palabras de
+// 64 bits (bit x & 63 de la palabra x >> 6 = casilla x) más una palabra de
+// relleno a 0, para poder leer ventanas de 64 bits sin salirse de la fila.
+// Nunca escribir celdas a mano durante la partida: map_set_cell las mantiene
+// al día (la carga del nivel las reconstruye enteras al terminar).
+typedef struct {
+    int words;                        // palabras por fila, relleno incluido
+    uint64_t *passable[PHASE_COUNT];  // 1 = el jugador en esa fase estable
+                                      // puede entrar
+    uint64_t *passable_superposed;    // 1 = puede entrar en superposición
+    uint64_t *walkable;               // 1 = FLOOR o EXPLOSION (colapsores)
+    uint64_t *footprint;              // scratch: huellas que caben, por
+                                      // posición de la esquina superior
+    unsigned char cell_bits[CELL_EXIT + 1]; // bit por tablero de cada Cell
+} PassabilityBoards;
+
+// Campo de distancias (en movimientos de colapsor) hasta el jugador para
+// una huella dada. Se calcula una vez por turno sobre el terreno y lo leen
+// todos los colapsores del mismo tamaño; si otro colapsor corta el camino
+// de uno, ese turno usa su propio campo (GameState.colapsor_field).
+// Cada casilla es un uint16_t con generación << DISTANCE_FIELD_DIST_BITS |
+// distancia: recalcular sólo incrementa la generación, y las casillas con
+// otra generación cuentan como inalcanzables sin reescribir la rejilla.
+// order y pushed_by guardan el orden del BFS (ver
+// distance_field_reached_before) y sólo valen en casillas de la generación
+// vigente.
+#define MAX_DISTANCE_FIELDS 4
+#define DISTANCE_FIELD_MAX_DIST 10 // Debe caber en DISTANCE_FIELD_DIST_BITS
+#define DISTANCE_FIELD_DIST_BITS 4
+#define DISTANCE_FIELD_MAX_GENERATION 0x0FFF
+
+typedef struct {
+    IVector2 size;       // Huella: 1x1 gnomos, 3x3 guardias
+    bool valid;          // Calculado en el turno actual
+    uint16_t generation; // Generación vigente; 0 = rejilla recién puesta a 0
+    uint16_t *cells;     // rows*cols por filas; se reserva de la arena la
+                         // primera vez que un colapsor del nivel lo pide
+    uint32_t *order;     // rows*cols: posición de la casilla en la cola
+    uint32_t *pushed_by; // rows*cols: casillas ya sacadas al encolarla
+} DistanceField;
+
+// Arena por nivel: un único bloque reservado al cargar el nivel y liberado
+// con él. Todo el scratch de la simulación (colas de BFS...) sale de aquí
+// para que un turno no toque el heap.
+#define ARENA_ALIGNMENT 64
+
+typedef struct {
+    unsigned char *base;
+    size_t size;
+    size_t used;
+} Arena;
+
 typedef struct {
     char title[64];
     char text[MAX_DIALOG_TEXT];
@@ -303,8 +420,34 @@ typedef struct {
     PhaseKind phase;
     bool is_pressed;
     bool is_active;
+    EntityRef next_at_cell;
 } PressureButton;
 
+// Disparadores de nivel: se construyen al cargar el nivel y sólo se evalúan
+// cuando cambia alguno de los botones a los que están suscritos
+typedef enum {
+    TRIGGER_ALL_BUTTONS, // Todos los botones de la máscara pulsados
+    TRIGGER_ANY_BUTTON   // Alguno de los botones de la máscara pulsado
+} TriggerCondition;
+
+typedef enum {
+    TRIGGER_OPEN_CELLS,     // Las casillas del rango que sigan siendo `from`
+                            // pasan a CELL_FLOOR
+    TRIGGER_ACTIVATE_PORTAL // Activa los portales de portal_pos
+} TriggerAction;
+
+typedef struct {
+    TriggerCondition condition;
+    uint32_t buttons; // Bit i: game->buttons[i]
+    TriggerAction action;
+    Cell from;
+    int cell_start; // Rango en GameState.trigger_cells
+    int cell_count;
+    IVector2 portal_pos;
+    bool sound_every_press; // Si no, sólo suena cuando abre algo
+    bool was_met;
+} LevelTrigger;
+
 typedef enum {
     GAME_STATE_MAIN_MENU,
     GAME_STATE_DIALOG,
@@ -347,6 +490,50 @@ typedef struct {
     float electron_angle;
 } Atom;
 
+// Eventos de la simulación: el núcleo (logic/levels/quantum/utils) no toca
+// audio ni partículas; avisa a quien esté escuchando y el front-end decide
+// cómo presentarlo. Sin sink instalado los eventos se descartan (headless).
+typedef enum {
+    SOUND_FOOTSTEP,
+    SOUND_BLAST,
+    SOUND_KEY_PICKUP,
+    SOUND_BOMB_PICKUP,
+    SOUND_CHECKPOINT,
+    SOUND_PHASE_SHIFT,
+    SOUND_TELEPORT,
+    SOUND_MEASUREMENT,
+    SOUND_ENTANGLE,
+    SOUND_QUBIT_ROTATE,
+    SOUND_ORACLE,
+    SOUND_ICE_SLIDE,
+    SOUND_MIRROR_REFLECT,
+    SOUND_DECOHERENCE,
+    SOUND_GUARD_STEP,
+    SOUND_OPEN_DOOR,
+    SOUND_PLANT_BOMB,
+    SOUND_COUNT
+} GameSound;
+
+typedef enum {
+    EVENT_SOUND,         // sound (+ variant, pitch)
+    EVENT_SPARKS,        // cell, color
+    EVENT_FLOATING_TEXT, // cell, text, color
+    EVENT_CENTERED_TEXT, // text, color
+    EVENT_PLAYER_DIED
+} GameEventKind;
+
+typedef struct {
+    GameEventKind kind;
+    GameSound sound;
+    int variant;  // Para sonidos con varias muestras (pasos)
+    float pitch;  // 0 = no cambiar el pitch del sonido
+    IVector2 cell;
+    Color color;
+    const char *text;
+} GameEvent;
+
+typedef void (*GameEventSink)(const GameEvent *event, void *user);
+
 typedef struct {
     Map *map;
     PlayerState player;
@@ -362,6 +549,12 @@ typedef struct {
     QuantumPortal portals[MAX_PORTALS];
     GroverOracle oracles[MAX_ORACLES];
     PressureButton buttons[MAX_BUTTONS];
+    uint32_t buttons_pressed; // Bit i: buttons[i].is_pressed
+    LevelTrigger triggers[MAX_TRIGGERS];
+    int trigger_count;
+    IVector2 trigger_cells[MAX_TRIGGER_CELLS];
+    int trigger_cell_count;
+    uint32_t trigger_buttons_seen; // Botones de la última evaluación
     float glitch_intensity;
     bool game_over;
     int turn_count;
@@ -372,6 +565,7 @@ typedef struct {
     DialogSystem dialog;
     float level_transition_timer;
     char level_name[64];
+    char level_dialog[MAX_DIALOG_TEXT]; // Texto del nivel cargado de .psl
     IVector2 checkpoint_pos;
     bool has_checkpoint;
     bool shown_level_intro; /* Flag to prevent dialog loop */
@@ -411,35 +605,51 @@ typedef struct {
         float velocity_y;
         bool active;
     } floating_texts[20];
+
+    // Memoria del nivel actual (ver init_game_state/free_level_state)
+    Arena level_arena;
+    IVector2 *bfs_queue; // rows*cols casillas: cada BFS visita cada una
+                         // como mucho una vez
+    int bfs_capacity;
+    DistanceField distance_fields[MAX_DISTANCE_FIELDS];
+    DistanceField colapsor_field; // Campo de un solo colapsor, con los
+                                  // demás como obstáculos
+    unsigned char *occupancy; // rows*cols: huellas de colapsores por casilla
+    PassabilityBoards passability;
+    EntityRef *entity_heads; // rows*cols: índice espacial de entidades
+    // Rayos de detectores: beam_generation sube al cambiar un espejo o al
+    // aparecer un detector u oráculo; beam_coverage[f] marca (con el formato
+    // de PassabilityBoards) las casillas que cubre algún rayo de fase f
+    unsigned beam_generation;
+    unsigned beam_coverage_generation;
+    uint64_t *beam_coverage[PHASE_COUNT];
+    // Casillas que map_set_cell pasó a CELL_EXPLOSION desde el último
+    // game_explosions_turn: la limpieza sólo recorre esta lista
+    IVector2 *explosion_cells;
+    int explosion_count;
+    int explosion_capacity;
+    bool explosion_overflow; // Lista llena: la limpieza recorre el mapa
+    // Hash Zobrist de las casillas (lo mantiene map_set_cell desde que
+    // alguien lo pide) y de los objetos (allocate_item y despawn_item): la
+    // parte de game_state_hash que no se recalcula en cada llamada
+    uint64_t cell_hash;
+    bool cell_hash_valid;
+    uint64_t item_hash;
+    // Medida para el próximo intento de túnel: se pide al acabar un turno
+    // y se usa en el siguiente, así la petición a /measure tiene todo el
+    // tiempo entre turnos para volver (execute_turn)
+    QiskitMeasureTicket tunnel_ticket;
+
+    // Destino de los eventos de la simulación (NULL = descartar)
+    GameEventSink event_sink;
+    void *event_user;
 } GameState;
 
 // Global Externs
 extern Color PALETTE[25];
 extern const IVector2 DIRECTION_VECTORS[];
-extern AudioSound footstep_sounds[4];
-extern AudioSound blast_sound;
-extern AudioSound key_pickup_sound;
-extern AudioSound bomb_pickup_sound;
-extern AudioSound checkpoint_sound;
-extern AudioSound phase_shift_sound;
-extern AudioMusic ambient_music;
 extern Font game_font;
 
-// New sound externs
-extern AudioSound teleport_sound;
-extern AudioSound measurement_sound;
-extern AudioSound entangle_sound;
-extern AudioSound qubit_rotate_sound;
-extern AudioSound oracle_sound;
-extern AudioSound ice_slide_sound;
-extern AudioSound mirror_reflect_sound;
-extern AudioSound decoherence_sound;
-extern AudioSound portal_activate_sound;
-extern AudioSound level_complete_sound;
-extern AudioSound guard_step_sound;
-extern AudioSound open_door_sound;
-extern AudioSound plant_bomb_sound;
-
 extern Texture2D title_icon;
 
 #endif
\ No newline at end of file
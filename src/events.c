@@ -0,0 +1,73 @@
+#include "events.h"
+#include "utils.h"
+
+/* ===== EVENTOS DE LA SIMULACIÓN ===== */
+
+void game_set_event_sink(GameState *game, GameEventSink sink, void *user) {
+    game->event_sink = sink;
+    game->event_user = user;
+}
+
+void emit_event(GameState *game, const GameEvent *event) {
+    if (game->event_sink)
+        game->event_sink(event, game->event_user);
+}
+
+void emit_sound(GameState *game, GameSound sound) {
+    emit_sound_pitch(game, sound, 0.0f);
+}
+
+void emit_sound_pitch(GameState *game, GameSound sound, float pitch) {
+    if (!game->event_sink)
+        return;
+    GameEvent e = {0};
+    e.kind = EVENT_SOUND;
+    e.sound = sound;
+    e.pitch = pitch;
+    game->event_sink(&e, game->event_user);
+}
+
+// La variante se sortea aunque no haya sink para que la secuencia de
+// game_rand() de la simulación sea la misma con y sin front-end.
+void emit_footstep(GameState *game) {
+    int variant = game_rand() % 4;
+    if (!game->event_sink)
+        return;
+    GameEvent e = {0};
+    e.kind = EVENT_SOUND;
+    e.sound = SOUND_FOOTSTEP;
+    e.variant = variant;
+    game->event_sink(&e, game->event_user);
+}
+
+void emit_sparks(GameState *game, IVector2 cell, Color color) {
+    if (!game->event_sink)
+        return;
+    GameEvent e = {0};
+    e.kind = EVENT_SPARKS;
+    e.cell = cell;
+    e.color = color;
+    game->event_sink(&e, game->event_user);
+}
+
+void emit_floating_text(GameState *game, IVector2 cell, const char *text,
+                        Color color) {
+    if (!game->event_sink)
+        return;
+    GameEvent e = {0};
+    e.kind = EVENT_FLOATING_TEXT;
+    e.cell = cell;
+    e.text = text;
+    e.color = color;
+    game->event_sink(&e, game->event_user);
+}
+
+void emit_centered_text(GameState *game, const char *text, Color color) {
+    if (!game->event_sink)
+        return;
+    GameEvent e = {0};
+    e.kind = EVENT_CENTERED_TEXT;
+    e.text = text;
+    e.color = color;
+    game->event_sink(&e, game->event_user);
+}
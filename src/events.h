@@ -0,0 +1,18 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "common.h"
+
+// Instala el receptor de eventos (NULL = simulación muda)
+void game_set_event_sink(GameState *game, GameEventSink sink, void *user);
+
+void emit_event(GameState *game, const GameEvent *event);
+void emit_sound(GameState *game, GameSound sound);
+void emit_sound_pitch(GameState *game, GameSound sound, float pitch);
+void emit_footstep(GameState *game);
+void emit_sparks(GameState *game, IVector2 cell, Color color);
+void emit_floating_text(GameState *game, IVector2 cell, const char *text,
+                        Color color);
+void emit_centered_text(GameState *game, const char *text, Color color);
+
+#endif
@@ -0,0 +1,656 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "level_file.h"
+#include "levels.h"
+#include "logic.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* El formato depende del tamaño exacto de estas estructuras */
+#define LEVEL_FILE_SIZE_CHECK(name, type, size)                                \
+    typedef char name[sizeof(type) == (size) ? 1 : -1]
+LEVEL_FILE_SIZE_CHECK(level_file_header_size, LevelFileHeader, 144);
+LEVEL_FILE_SIZE_CHECK(level_file_entity_size, LevelFileEntity, 20);
+LEVEL_FILE_SIZE_CHECK(level_file_trigger_size, LevelFileTrigger, 16);
+
+/* ===== ACCESO AL FICHERO ===== */
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    bool mapped; /* mmap (POSIX, ficheros grandes); si no, copia en el heap */
+} LevelFileView;
+
+static bool level_file_open(const char *path, LevelFileView *view) {
+    memset(view, 0, sizeof(*view));
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    /* Los niveles pequeños salen más baratos con un read que con
+     * mmap + munmap */
+    if (size >= LEVEL_FILE_MMAP_MIN) {
+        void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            view->data = data;
+            view->size = size;
+            view->mapped = true;
+            return true;
+        }
+    }
+    unsigned char *data = malloc(size);
+    size_t done = 0;
+    while (data && done < size) {
+        ssize_t n = read(fd, data + done, size - done);
+        if (n <= 0)
+            break;
+        done += (size_t)n;
+    }
+    close(fd);
+#else
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        length = ftell(file);
+    size_t size = length > 0 ? (size_t)length : 0;
+    unsigned char *data = size ? malloc(size) : NULL;
+    size_t done = 0;
+    if (data && fseek(file, 0, SEEK_SET) == 0)
+        done = fread(data, 1, size, file);
+    fclose(file);
+#endif
+    if (!data || done != size) {
+        free(data);
+        return false;
+    }
+    view->data = data;
+    view->size = size;
+    return true;
+}
+
+static void level_file_close(LevelFileView *view) {
+#ifndef _WIN32
+    if (view->mapped) {
+        munmap((void *)view->data, view->size);
+        view->data = NULL;
+        return;
+    }
+#endif
+    free((void *)view->data);
+    view->data = NULL;
+}
+
+/* ===== VALIDACIÓN ===== */
+
+/* Los enteros del fichero se leen tal cual: sólo valen en little-endian */
+static bool host_little_endian(void) {
+    const uint16_t one = 1;
+    return *(const uint8_t *)&one == 1;
+}
+
+static bool section_fits(const LevelFileView *view, LevelFileSection section,
+                         size_t element_size) {
+    if (section.offset % 4 != 0 || section.offset > view->size)
+        return false;
+    return (uint64_t)section.count * element_size <=
+           view->size - section.offset;
+}
+
+static bool cell_in_level(const LevelFileHeader *h, int x, int y) {
+    return x >= 0 && x < h->cols && y >= 0 && y < h->rows;
+}
+
+static bool entity_valid(const LevelFileHeader *h, const LevelFileEntity *e) {
+    if (e->kind >= LEVEL_ENTITY_KIND_COUNT || !cell_in_level(h, e->x, e->y))
+        return false;
+    switch (e->kind) {
+    case LEVEL_ENTITY_ITEM:
+        return e->param > ITEM_NONE && e->param <= ITEM_CNOT_GATE;
+    case LEVEL_ENTITY_BUTTON:
+    case LEVEL_ENTITY_ORACLE:
+        return e->phase < PHASE_COUNT;
+    case LEVEL_ENTITY_PORTAL:
+        return e->phase < PHASE_COUNT && e->a_x >= -1 &&
+               e->a_x < MAX_PORTALS;
+    case LEVEL_ENTITY_DETECTOR:
+        return e->phase < PHASE_COUNT && e->param <= DIR_DOWN;
+    case LEVEL_ENTITY_TUNNEL:
+        /* El área entera y el destino del salto dentro del mapa */
+        return e->a_x > 0 && e->a_y > 0 &&
+               cell_in_level(h, e->x + e->a_x - 1, e->y + e->a_y - 1) &&
+               cell_in_level(h, e->x + e->b_x, e->y + e->b_y);
+    default:
+        return true;
+    }
+}
+
+/* Comprueba todo lo que la carga va a leer, antes de tocar el GameState */
+static const LevelFileHeader *level_file_check(const LevelFileView *view,
+                                               const char **error) {
+    const LevelFileHeader *h = (const LevelFileHeader *)view->data;
+    if (!host_little_endian()) {
+        *error = "el formato es little-endian y esta máquina no";
+        return NULL;
+    }
+    if (view->size < sizeof(*h) ||
+        memcmp(h->magic, LEVEL_FILE_MAGIC, sizeof(h->magic)) != 0) {
+        *error = "no es un nivel .psl";
+        return NULL;
+    }
+    if (h->version != LEVEL_FILE_VERSION) {
+        *error = "versión del formato distinta";
+        return NULL;
+    }
+    if (h->file_size != view->size) {
+        *error = "tamaño incorrecto";
+        return NULL;
+    }
+    if (h->source_hash && level_source_hash &&
+        h->source_hash != level_source_hash) {
+        *error = "generado con otra versión de src/levels.c (make levels)";
+        return NULL;
+    }
+    if (h->rows < 3 || h->cols < 3 || h->rows > LEVEL_FILE_MAX_SIDE ||
+        h->cols > LEVEL_FILE_MAX_SIDE ||
+        !memchr(h->name, '\0', sizeof(h->name))) {
+        *error = "cabecera inválida";
+        return NULL;
+    }
+    if (h->cells.count != (uint32_t)h->rows * (uint32_t)h->cols ||
+        !section_fits(view, h->cells, 1) ||
+        !section_fits(view, h->entities, sizeof(LevelFileEntity)) ||
+        !section_fits(view, h->triggers, sizeof(LevelFileTrigger)) ||
+        !section_fits(view, h->trigger_cells, sizeof(LevelFileCell)) ||
+        !section_fits(view, h->dialog, 1) ||
+        h->triggers.count > MAX_TRIGGERS ||
+        h->trigger_cells.count > MAX_TRIGGER_CELLS ||
+        h->dialog.count >= MAX_DIALOG_TEXT) {
+        *error = "secciones fuera del fichero";
+        return NULL;
+    }
+    if (!cell_in_level(h, h->player_x, h->player_y) ||
+        h->start_phase >= PHASE_COUNT) {
+        *error = "jugador fuera del mapa";
+        return NULL;
+    }
+    if (!cell_in_level(h, h->exit_x, h->exit_y)) {
+        *error = "salida fuera del mapa";
+        return NULL;
+    }
+
+    /* Las tablas indexadas por Cell (passability, render) no admiten
+     * valores fuera del enum */
+    const uint8_t *cells = view->data + h->cells.offset;
+    uint8_t max_cell = 0;
+    for (uint32_t i = 0; i < h->cells.count; i++)
+        max_cell = cells[i] > max_cell ? cells[i] : max_cell;
+    if (max_cell > CELL_EXIT) {
+        *error = "casilla desconocida";
+        return NULL;
+    }
+
+    const LevelFileEntity *entities =
+        (const LevelFileEntity *)(view->data + h->entities.offset);
+    for (uint32_t i = 0; i < h->entities.count; i++) {
+        if (!entity_valid(h, &entities[i])) {
+            *error = "entidad inválida";
+            return NULL;
+        }
+    }
+
+    const LevelFileTrigger *triggers =
+        (const LevelFileTrigger *)(view->data + h->triggers.offset);
+    for (uint32_t i = 0; i < h->triggers.count; i++) {
+        const LevelFileTrigger *t = &triggers[i];
+        if (t->condition > TRIGGER_ANY_BUTTON ||
+            t->action > TRIGGER_ACTIVATE_PORTAL || t->from > CELL_EXIT ||
+            (uint32_t)t->cell_start + t->cell_count > h->trigger_cells.count) {
+            *error = "disparador inválido";
+            return NULL;
+        }
+    }
+    const LevelFileCell *trigger_cells =
+        (const LevelFileCell *)(view->data + h->trigger_cells.offset);
+    for (uint32_t i = 0; i < h->trigger_cells.count; i++) {
+        if (!cell_in_level(h, trigger_cells[i].x, trigger_cells[i].y)) {
+            *error = "disparador fuera del mapa";
+            return NULL;
+        }
+    }
+    return h;
+}
+
+/* ===== CARGA ===== */
+
+static void spawn_level_entity(GameState *game, const LevelFileEntity *e) {
+    IVector2 pos = ivec2(e->x, e->y);
+    switch (e->kind) {
+    case LEVEL_ENTITY_ITEM:
+        allocate_item(game, pos, (ItemKind)e->param);
+        break;
+    case LEVEL_ENTITY_BUTTON:
+        spawn_button(game, pos, (PhaseKind)e->phase);
+        break;
+    case LEVEL_ENTITY_PORTAL:
+        spawn_portal(game, pos, e->a_x, (PhaseKind)e->phase);
+        break;
+    case LEVEL_ENTITY_ORACLE:
+        spawn_oracle(game, pos, (PhaseKind)e->phase,
+                     (e->flags & LEVEL_ENTITY_MARKED) != 0);
+        break;
+    case LEVEL_ENTITY_DETECTOR:
+        spawn_detector(game, pos, (Direction)e->param, (PhaseKind)e->phase);
+        break;
+    case LEVEL_ENTITY_TUNNEL:
+        spawn_tunnel(game, pos, ivec2(e->a_x, e->a_y), ivec2(e->b_x, e->b_y));
+        break;
+    case LEVEL_ENTITY_GUARD:
+        spawn_guard(game, pos);
+        break;
+    case LEVEL_ENTITY_GNOME:
+        spawn_gnome(game, pos);
+        break;
+    default:
+        break;
+    }
+}
+
+static void load_level_triggers(GameState *game, const unsigned char *data,
+                                const LevelFileHeader *h) {
+    const LevelFileTrigger *triggers =
+        (const LevelFileTrigger *)(data + h->triggers.offset);
+    for (uint32_t i = 0; i < h->triggers.count; i++) {
+        LevelTrigger *t = &game->triggers[i];
+        t->condition = (TriggerCondition)triggers[i].condition;
+        t->buttons = triggers[i].buttons;
+        t->action = (TriggerAction)triggers[i].action;
+        t->from = (Cell)triggers[i].from;
+        t->cell_start = triggers[i].cell_start;
+        t->cell_count = triggers[i].cell_count;
+        t->portal_pos = ivec2(triggers[i].portal_x, triggers[i].portal_y);
+        t->sound_every_press = triggers[i].sound_every_press != 0;
+        t->was_met = false;
+    }
+    game->trigger_count = (int)h->triggers.count;
+    const LevelFileCell *trigger_cells =
+        (const LevelFileCell *)(data + h->trigger_cells.offset);
+    for (uint32_t i = 0; i < h->trigger_cells.count; i++)
+        game->trigger_cells[i] = ivec2(trigger_cells[i].x, trigger_cells[i].y);
+    game->trigger_cell_count = (int)h->trigger_cells.count;
+}
+
+static void load_level_texts(GameState *game, const unsigned char *data,
+                             const LevelFileHeader *h) {
+    memcpy(game->level_name, h->name, sizeof(game->level_name));
+    memcpy(game->level_dialog, data + h->dialog.offset, h->dialog.count);
+    game->level_dialog[h->dialog.count] = '\0';
+}
+
+bool level_file_load(GameState *game, const char *path) {
+    LevelFileView view;
+    if (!level_file_open(path, &view))
+        return false; /* Sin fichero: el nivel se construye en C */
+
+    const char *error = NULL;
+    const LevelFileHeader *h = level_file_check(&view, &error);
+    if (!h) {
+        fprintf(stderr, "Nivel %s descartado: %s\n", path, error);
+        level_file_close(&view);
+        return false;
+    }
+
+    init_game_state(game, h->rows, h->cols);
+    game->current_level = h->level_index;
+
+    const uint8_t *cells = view.data + h->cells.offset;
+    for (int y = 0; y < h->rows; y++)
+        memcpy(&MAP_AT(game->map, 0, y), cells + (size_t)y * h->cols,
+               (size_t)h->cols);
+
+    /* Mismo orden de creación que el load_level_N original: mismos huecos.
+     * Los portales desactivados se crean y luego se apagan, como allí */
+    const LevelFileEntity *entities =
+        (const LevelFileEntity *)(view.data + h->entities.offset);
+    for (uint32_t i = 0; i < h->entities.count; i++)
+        spawn_level_entity(game, &entities[i]);
+    int portal = 0;
+    for (uint32_t i = 0; i < h->entities.count; i++) {
+        if (entities[i].kind != LEVEL_ENTITY_PORTAL)
+            continue;
+        if ((entities[i].flags & LEVEL_ENTITY_INACTIVE) && portal < MAX_PORTALS)
+            game->portals[portal].active = false;
+        portal++;
+    }
+
+    game->player.position = ivec2(h->player_x, h->player_y);
+    game->player.phase_system.current_phase = (PhaseKind)h->start_phase;
+    game->player.phase_system.green_unlocked = h->green_unlocked != 0;
+    game->player.bombs = h->bombs;
+    game->player.bomb_slots = h->bomb_slots;
+    game->exit_position = ivec2(h->exit_x, h->exit_y);
+
+    load_level_triggers(game, view.data, h);
+    load_level_texts(game, view.data, h);
+
+    level_file_close(&view);
+    map_rebuild_passability(game);
+    return true;
+}
+
+void level_file_path(char *out, size_t size, int level_index) {
+    snprintf(out, size, LEVEL_FILE_DIR "/level_%02d.psl", level_index + 1);
+}
+
+/* ===== RECARGA EN CALIENTE ===== */
+
+bool level_file_snapshot(LevelFileSnapshot *snapshot, const char *path) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    LevelFileView view;
+    if (!level_file_open(path, &view))
+        return false;
+    const char *error = NULL;
+    if (!level_file_check(&view, &error)) {
+        fprintf(stderr, "Nivel %s descartado: %s\n", path, error);
+        level_file_close(&view);
+        return false;
+    }
+    if (view.mapped) {
+        snapshot->data = malloc(view.size);
+        if (snapshot->data)
+            memcpy(snapshot->data, view.data, view.size);
+        level_file_close(&view);
+    } else {
+        snapshot->data = (unsigned char *)view.data;
+    }
+    snapshot->size = snapshot->data ? view.size : 0;
+    return snapshot->data != NULL;
+}
+
+void level_file_snapshot_free(LevelFileSnapshot *snapshot) {
+    free(snapshot->data);
+    snapshot->data = NULL;
+    snapshot->size = 0;
+}
+
+static bool same_section(const LevelFileSnapshot *a, LevelFileSection sa,
+                         const LevelFileSnapshot *b, LevelFileSection sb,
+                         size_t element_size) {
+    return sa.count == sb.count &&
+           memcmp(a->data + sa.offset, b->data + sb.offset,
+                  sa.count * element_size) == 0;
+}
+
+int level_file_patch(GameState *game, const LevelFileSnapshot *from,
+                     const LevelFileSnapshot *to) {
+    const LevelFileHeader *a = (const LevelFileHeader *)from->data;
+    const LevelFileHeader *b = (const LevelFileHeader *)to->data;
+    if (a->rows != b->rows || a->cols != b->cols ||
+        game->map->rows != b->rows || game->map->cols != b->cols ||
+        !same_section(from, a->entities, to, b->entities,
+                      sizeof(LevelFileEntity)))
+        return -1;
+
+    /* Sólo las casillas que ha cambiado el editor: lo que haya cambiado el
+     * juego (barricadas abiertas, muros volados) en el resto se conserva.
+     * map_set_cell mantiene al día tableros, explosiones y rayos */
+    int changed = 0;
+    const uint8_t *old_cells = from->data + a->cells.offset;
+    const uint8_t *new_cells = to->data + b->cells.offset;
+    for (int y = 0; y < b->rows; y++) {
+        const uint8_t *old_row = old_cells + (size_t)y * b->cols;
+        const uint8_t *new_row = new_cells + (size_t)y * b->cols;
+        if (memcmp(old_row, new_row, (size_t)b->cols) == 0)
+            continue;
+        for (int x = 0; x < b->cols; x++) {
+            if (old_row[x] != new_row[x]) {
+                map_set_cell(game, ivec2(x, y), (Cell)new_row[x]);
+                changed++;
+            }
+        }
+    }
+
+    if (!same_section(from, a->triggers, to, b->triggers,
+                      sizeof(LevelFileTrigger)) ||
+        !same_section(from, a->trigger_cells, to, b->trigger_cells,
+                      sizeof(LevelFileCell))) {
+        load_level_triggers(game, to->data, b);
+        /* Todos los botones cuentan como cambiados en el próximo turno */
+        game->trigger_buttons_seen = ~game->buttons_pressed;
+    }
+    game->exit_position = ivec2(b->exit_x, b->exit_y);
+    load_level_texts(game, to->data, b);
+    return changed;
+}
+
+/* ===== ESCRITURA ===== */
+
+static size_t section_align(size_t offset) {
+    return (offset + LEVEL_FILE_SECTION_ALIGN - 1) &
+           ~(size_t)(LEVEL_FILE_SECTION_ALIGN - 1);
+}
+
+static bool portal_spawned(GameState *game, int index) {
+    for (EntityRef ref = entity_index_at(game, game->portals[index].position);
+         ref; ref = entity_index_next(game, ref)) {
+        if (ref == ENTITY_REF(ENTITY_PORTAL, index))
+            return true;
+    }
+    return false;
+}
+
+static LevelFileEntity level_entity(LevelEntityKind kind, IVector2 pos) {
+    LevelFileEntity e;
+    memset(&e, 0, sizeof(e));
+    e.kind = (uint8_t)kind;
+    e.x = (int16_t)pos.x;
+    e.y = (int16_t)pos.y;
+    return e;
+}
+
+static bool slot_used(bool used, bool *gap, const char **error) {
+    if (!used) {
+        *gap = true;
+        return false;
+    }
+    if (*gap)
+        *error = "hueco en un array de entidades";
+    return true;
+}
+
+/* Recorre los arrays de entidades en orden de hueco. Al recargarlas con
+ * spawn_* cada tipo vuelve a llenar los huecos desde el 0, así que los
+ * ocupados tienen que ser un prefijo del array */
+static int collect_level_entities(GameState *game, LevelFileEntity *out,
+                                  const char **error) {
+    int count = 0;
+    bool gap = false;
+
+    for (int i = 0; i < MAX_ITEMS; i++) {
+        if (!slot_used(game->items[i].kind != ITEM_NONE, &gap, error))
+            continue;
+        out[count] = level_entity(LEVEL_ENTITY_ITEM, game->items[i].position);
+        out[count++].param = (uint8_t)game->items[i].kind;
+    }
+    gap = false;
+    for (int i = 0; i < MAX_BUTTONS; i++) {
+        if (!slot_used(game->buttons[i].is_active, &gap, error))
+            continue;
+        out[count] =
+            level_entity(LEVEL_ENTITY_BUTTON, game->buttons[i].position);
+        out[count++].phase = (uint8_t)game->buttons[i].phase;
+    }
+    gap = false;
+    for (int i = 0; i < MAX_PORTALS; i++) {
+        QuantumPortal *p = &game->portals[i];
+        if (!slot_used(portal_spawned(game, i), &gap, error))
+            continue;
+        out[count] = level_entity(LEVEL_ENTITY_PORTAL, p->position);
+        out[count].phase = (uint8_t)p->phase;
+        out[count].a_x = (int16_t)p->linked_portal_index;
+        out[count++].flags = p->active ? 0 : LEVEL_ENTITY_INACTIVE;
+    }
+    gap = false;
+    for (int i = 0; i < MAX_ORACLES; i++) {
+        GroverOracle *o = &game->oracles[i];
+        if (!slot_used(o->active, &gap, error))
+            continue;
+        out[count] = level_entity(LEVEL_ENTITY_ORACLE, o->position);
+        out[count].phase = (uint8_t)o->marked_phase;
+        out[count++].flags = o->is_marked_state ? LEVEL_ENTITY_MARKED : 0;
+    }
+    gap = false;
+    for (int i = 0; i < MAX_DETECTORS; i++) {
+        QuantumDetector *d = &game->detectors[i];
+        if (!slot_used(d->is_active, &gap, error))
+            continue;
+        out[count] = level_entity(LEVEL_ENTITY_DETECTOR, d->position);
+        out[count].phase = (uint8_t)d->detects_phase;
+        out[count++].param = (uint8_t)d->direction;
+    }
+    gap = false;
+    for (int i = 0; i < MAX_TUNNELS; i++) {
+        QuantumTunnel *t = &game->tunnels[i];
+        if (!slot_used(t->position.x != 0 || t->position.y != 0, &gap, error))
+            continue;
+        out[count] = level_entity(LEVEL_ENTITY_TUNNEL, t->position);
+        out[count].a_x = (int16_t)t->size.x;
+        out[count].a_y = (int16_t)t->size.y;
+        out[count].b_x = (int16_t)t->target_offset.x;
+        out[count++].b_y = (int16_t)t->target_offset.y;
+    }
+    gap = false;
+    for (int i = 0; i < MAX_COLAPSORES; i++) {
+        ColapsarState *c = &game->colapsores[i];
+        if (!slot_used(!c->dead, &gap, error))
+            continue;
+        if (c->kind != COLAPSOR_GUARD && c->kind != COLAPSOR_GNOME) {
+            *error = "colapsor sin spawn_*";
+            return -1;
+        }
+        out[count++] = level_entity(c->kind == COLAPSOR_GUARD
+                                        ? LEVEL_ENTITY_GUARD
+                                        : LEVEL_ENTITY_GNOME,
+                                    c->position);
+    }
+    return *error ? -1 : count;
+}
+
+#define LEVEL_FILE_MAX_ENTITIES                                                \
+    (MAX_ITEMS + MAX_BUTTONS + MAX_PORTALS + MAX_ORACLES + MAX_DETECTORS +     \
+     MAX_TUNNELS + MAX_COLAPSORES)
+
+bool level_file_write(GameState *game, const char *dialog, const char *path) {
+    int rows = game->map->rows;
+    int cols = game->map->cols;
+    const char *error = NULL;
+    static LevelFileEntity entities[LEVEL_FILE_MAX_ENTITIES];
+
+    int entity_count = collect_level_entities(game, entities, &error);
+    if (rows > LEVEL_FILE_MAX_SIDE || cols > LEVEL_FILE_MAX_SIDE)
+        error = "mapa demasiado grande";
+    size_t dialog_length = dialog ? strlen(dialog) : 0;
+    if (dialog_length >= MAX_DIALOG_TEXT)
+        error = "diálogo demasiado largo";
+    if (!host_little_endian())
+        error = "el formato es little-endian y esta máquina no";
+    if (error) {
+        fprintf(stderr, "No se puede escribir %s: %s\n", path, error);
+        return false;
+    }
+
+    LevelFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, LEVEL_FILE_MAGIC, sizeof(h.magic));
+    h.version = LEVEL_FILE_VERSION;
+    h.source_hash = level_source_hash;
+    h.level_index = game->current_level;
+    h.rows = rows;
+    h.cols = cols;
+    snprintf(h.name, sizeof(h.name), "%s", game->level_name);
+    h.player_x = (int16_t)game->player.position.x;
+    h.player_y = (int16_t)game->player.position.y;
+    h.exit_x = (int16_t)game->exit_position.x;
+    h.exit_y = (int16_t)game->exit_position.y;
+    h.start_phase = (uint8_t)game->player.phase_system.current_phase;
+    h.green_unlocked = game->player.phase_system.green_unlocked;
+    h.bombs = (uint8_t)game->player.bombs;
+    h.bomb_slots = (uint8_t)game->player.bomb_slots;
+
+    size_t offset = section_align(sizeof(h));
+    h.cells = (LevelFileSection){(uint32_t)offset, (uint32_t)(rows * cols)};
+    offset = section_align(offset + (size_t)rows * cols);
+    h.entities = (LevelFileSection){(uint32_t)offset, (uint32_t)entity_count};
+    offset = section_align(offset + entity_count * sizeof(LevelFileEntity));
+    h.triggers =
+        (LevelFileSection){(uint32_t)offset, (uint32_t)game->trigger_count};
+    offset = section_align(offset +
+                           game->trigger_count * sizeof(LevelFileTrigger));
+    h.trigger_cells = (LevelFileSection){(uint32_t)offset,
+                                         (uint32_t)game->trigger_cell_count};
+    offset = section_align(offset +
+                           game->trigger_cell_count * sizeof(LevelFileCell));
+    h.dialog = (LevelFileSection){(uint32_t)offset, (uint32_t)dialog_length};
+    offset += dialog_length;
+    h.file_size = (uint32_t)offset;
+
+    unsigned char *data = calloc(1, offset);
+    if (!data)
+        return false;
+    memcpy(data, &h, sizeof(h));
+    for (int y = 0; y < rows; y++)
+        memcpy(data + h.cells.offset + (size_t)y * cols,
+               &MAP_AT(game->map, 0, y), (size_t)cols);
+    memcpy(data + h.entities.offset, entities,
+           entity_count * sizeof(LevelFileEntity));
+    LevelFileTrigger *triggers = (LevelFileTrigger *)(data + h.triggers.offset);
+    for (int i = 0; i < game->trigger_count; i++) {
+        const LevelTrigger *t = &game->triggers[i];
+        triggers[i].condition = (uint8_t)t->condition;
+        triggers[i].action = (uint8_t)t->action;
+        triggers[i].from = (uint8_t)t->from;
+        triggers[i].sound_every_press = t->sound_every_press;
+        triggers[i].buttons = t->buttons;
+        triggers[i].portal_x = (int16_t)t->portal_pos.x;
+        triggers[i].portal_y = (int16_t)t->portal_pos.y;
+        triggers[i].cell_start = (uint16_t)t->cell_start;
+        triggers[i].cell_count = (uint16_t)t->cell_count;
+    }
+    LevelFileCell *trigger_cells =
+        (LevelFileCell *)(data + h.trigger_cells.offset);
+    for (int i = 0; i < game->trigger_cell_count; i++) {
+        trigger_cells[i].x = (int16_t)game->trigger_cells[i].x;
+        trigger_cells[i].y = (int16_t)game->trigger_cells[i].y;
+    }
+    if (dialog_length)
+        memcpy(data + h.dialog.offset, dialog, dialog_length);
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file && fwrite(data, 1, offset, file) == offset;
+    if (file)
+        ok = fclose(file) == 0 && ok;
+    free(data);
+    if (!ok)
+        fprintf(stderr, "No se puede escribir %s\n", path);
+    return ok;
+}
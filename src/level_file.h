@@ -0,0 +1,123 @@
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+
+#include "common.h"
+
+// Formato binario de nivel (.psl). Lo genera tools/level_compiler.c a partir
+// de los load_level_N y lo carga load_level si existe el fichero; si no (o
+// está corrupto) se construye el nivel con el código C de siempre.
+//
+// Todo son enteros de ancho fijo en little-endian con alineación natural,
+// así que el fichero se mapea en memoria y se lee sin parsear (en una
+// máquina big-endian no se usan los .psl). Las casillas van fila a fila
+// (cols bytes por fila, un Cell por byte) y se copian con un memcpy por fila
+// al Map.
+//
+// La cabecera lleva la huella de src/levels.c con la que se generó
+// (level_source_hash): si el código de los niveles cambia, los .psl viejos
+// se descartan hasta volver a pasar make levels.
+#define LEVEL_FILE_DIR "assets/levels"
+#define LEVEL_FILE_MAGIC "PSL1"
+#define LEVEL_FILE_VERSION 3
+#define LEVEL_FILE_MAX_SIDE 4096
+#define LEVEL_FILE_SECTION_ALIGN 64
+#define LEVEL_FILE_MMAP_MIN (64 * 1024) // Por debajo se lee con read()
+
+typedef struct {
+    uint32_t offset; // Desde el principio del fichero
+    uint32_t count;  // En elementos de la sección
+} LevelFileSection;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t file_size;
+    uint32_t source_hash; // level_source_hash del compilador, 0 si no se sabe
+    int32_t level_index; // GameState.current_level
+    int32_t rows;
+    int32_t cols;
+    char name[64];
+    int16_t player_x, player_y;
+    int16_t exit_x, exit_y;
+    uint8_t start_phase; // PhaseKind
+    uint8_t green_unlocked;
+    uint8_t bombs;
+    uint8_t bomb_slots;
+    LevelFileSection cells;         // uint8_t, rows*cols
+    LevelFileSection entities;      // LevelFileEntity
+    LevelFileSection triggers;      // LevelFileTrigger
+    LevelFileSection trigger_cells; // LevelFileCell
+    LevelFileSection dialog;        // char, sin terminador
+} LevelFileHeader;
+
+typedef enum {
+    LEVEL_ENTITY_ITEM,     // param: ItemKind
+    LEVEL_ENTITY_BUTTON,   // phase
+    LEVEL_ENTITY_PORTAL,   // phase, a.x: portal enlazado
+    LEVEL_ENTITY_ORACLE,   // phase: fase marcada
+    LEVEL_ENTITY_DETECTOR, // phase: fase detectada, param: Direction
+    LEVEL_ENTITY_TUNNEL,   // a: tamaño, b: desplazamiento del destino
+    LEVEL_ENTITY_GUARD,
+    LEVEL_ENTITY_GNOME,
+    LEVEL_ENTITY_KIND_COUNT
+} LevelEntityKind;
+
+#define LEVEL_ENTITY_INACTIVE 0x01 // Portal creado pero desactivado
+#define LEVEL_ENTITY_MARKED 0x02   // Oráculo en estado marcado
+
+// Las entidades se guardan en el orden en que se crearon: al cargarlas con
+// las mismas funciones spawn_* cada una acaba en el mismo hueco del array
+typedef struct {
+    uint8_t kind; // LevelEntityKind
+    uint8_t flags;
+    uint8_t phase;
+    uint8_t param;
+    int16_t x, y;
+    int16_t a_x, a_y;
+    int16_t b_x, b_y;
+    int16_t reserved[2];
+} LevelFileEntity;
+
+typedef struct {
+    uint8_t condition; // TriggerCondition
+    uint8_t action;    // TriggerAction
+    uint8_t from;      // Cell
+    uint8_t sound_every_press;
+    uint32_t buttons;
+    int16_t portal_x, portal_y;
+    uint16_t cell_start;
+    uint16_t cell_count;
+} LevelFileTrigger;
+
+typedef struct {
+    int16_t x, y;
+} LevelFileCell;
+
+// Carga el nivel del fichero sobre game (init_game_state incluido). Devuelve
+// false sin tocar game si el fichero no existe o no es válido.
+bool level_file_load(GameState *game, const char *path);
+
+// Ruta del .psl de un nivel (índice desde 0, ficheros desde level_01)
+void level_file_path(char *out, size_t size, int level_index);
+
+// Copia validada de un .psl, para comparar con la siguiente versión al
+// recargar en caliente
+typedef struct {
+    unsigned char *data;
+    size_t size;
+} LevelFileSnapshot;
+
+bool level_file_snapshot(LevelFileSnapshot *snapshot, const char *path);
+void level_file_snapshot_free(LevelFileSnapshot *snapshot);
+
+// Aplica sobre el nivel en juego lo que cambió de `from` a `to`: casillas
+// (vía map_set_cell), disparadores, salida y textos. Devuelve cuántas
+// casillas cambió, o -1 si cambió el tamaño o las entidades y hay que
+// cargar el nivel entero.
+int level_file_patch(GameState *game, const LevelFileSnapshot *from,
+                     const LevelFileSnapshot *to);
+
+// Escribe el nivel tal y como está en game justo después de construirlo
+bool level_file_write(GameState *game, const char *dialog, const char *path);
+
+#endif
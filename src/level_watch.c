@@ -0,0 +1,104 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "level_watch.h"
+#include "levels.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static long long level_watch_mtime(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long long)st.st_mtime : -1;
+}
+
+void level_watch_start(LevelWatch *watch) {
+    memset(watch, 0, sizeof(*watch));
+    watch->fd = -1;
+    watch->level = -1;
+#ifdef __linux__
+    /* Se vigila el directorio: el compilador y los editores suelen
+     * reescribir o renombrar el fichero, y eso rompe un watch sobre él */
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 &&
+        inotify_add_watch(fd, LEVEL_FILE_DIR, IN_CLOSE_WRITE | IN_MOVED_TO) >=
+            0) {
+        watch->fd = fd;
+    } else if (fd >= 0) {
+        close(fd);
+    }
+#endif
+    if (watch->fd < 0)
+        TraceLog(LOG_INFO, "LEVELS: Sin inotify en %s: se sondea cada %d "
+                           "frames",
+                 LEVEL_FILE_DIR, LEVEL_WATCH_POLL_FRAMES);
+}
+
+/* Devuelve si desde la última llamada ha cambiado el .psl de `path` */
+static bool level_watch_changed(LevelWatch *watch, const char *path) {
+#ifdef __linux__
+    if (watch->fd >= 0) {
+        const char *name = strrchr(path, '/');
+        name = name ? name + 1 : path;
+        bool changed = false;
+        union {
+            struct inotify_event event; /* Sólo por la alineación */
+            char bytes[4096];
+        } buffer;
+        ssize_t length;
+        while ((length = read(watch->fd, buffer.bytes, sizeof(buffer))) > 0) {
+            for (char *p = buffer.bytes; p < buffer.bytes + length;) {
+                const struct inotify_event *event =
+                    (const struct inotify_event *)p;
+                if (event->len && strcmp(event->name, name) == 0)
+                    changed = true;
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+    if (--watch->poll_countdown > 0)
+        return false;
+    watch->poll_countdown = LEVEL_WATCH_POLL_FRAMES;
+    long long mtime = level_watch_mtime(path);
+    if (mtime == watch->mtime)
+        return false;
+    watch->mtime = mtime;
+    return mtime >= 0;
+}
+
+bool level_watch_update(LevelWatch *watch, GameState *game) {
+    char path[64];
+    level_file_path(path, sizeof(path), game->current_level);
+
+    /* Al cambiar de nivel, la versión de referencia es la que hay ahora en
+     * disco (la que acaba de cargar load_level) */
+    if (watch->level != game->current_level) {
+        level_file_snapshot_free(&watch->applied);
+        level_file_snapshot(&watch->applied, path);
+        watch->level = game->current_level;
+        watch->mtime = level_watch_mtime(path);
+        level_watch_changed(watch, path); /* Descarta lo ya pendiente */
+        return false;
+    }
+
+    if (!level_watch_changed(watch, path))
+        return false;
+    return reload_level_in_place(game, &watch->applied);
+}
+
+void level_watch_stop(LevelWatch *watch) {
+#ifdef __linux__
+    if (watch->fd >= 0)
+        close(watch->fd);
+#endif
+    watch->fd = -1;
+    level_file_snapshot_free(&watch->applied);
+}
@@ -0,0 +1,28 @@
+#ifndef LEVEL_WATCH_H
+#define LEVEL_WATCH_H
+
+#include "common.h"
+#include "level_file.h"
+
+// Recarga en caliente de niveles: vigila LEVEL_FILE_DIR y, si cambia el .psl
+// del nivel en juego, lo vuelve a aplicar sin reiniciar el juego
+// (reload_level_in_place). En Linux usa inotify; en el resto se consulta la
+// fecha de modificación del fichero cada LEVEL_WATCH_POLL_FRAMES llamadas.
+// Sólo se enlaza en el juego en modo debug (no está en libphaseshift_core.a)
+// y avisa con TraceLog, como el resto del frontend.
+#define LEVEL_WATCH_POLL_FRAMES 15
+
+typedef struct {
+    int fd;    // inotify, -1 si se sondea
+    int level; // Nivel de `applied`, -1 = ninguno
+    LevelFileSnapshot applied;
+    long long mtime;
+    int poll_countdown;
+} LevelWatch;
+
+void level_watch_start(LevelWatch *watch);
+// Una vez por frame. Devuelve true si ha recargado el nivel
+bool level_watch_update(LevelWatch *watch, GameState *game);
+void level_watch_stop(LevelWatch *watch);
+
+#endif
@@ -1,9 +1,17 @@
 #include "levels.h"
+#include "events.h"
+#include "level_file.h"
 #include "logic.h"
+#include "quantum.h"
 
 #include <stdio.h>
 #include <string.h>
 
+#ifndef LEVEL_SOURCE_HASH
+#define LEVEL_SOURCE_HASH 0
+#endif
+const uint32_t level_source_hash = LEVEL_SOURCE_HASH;
+
 void init_encyclopedia(GameState *game) {
     game->encyclopedia_count = 8;
     game->encyclopedia_page = 0;
@@ -81,33 +89,33 @@ void load_level_1(GameState *game) {
     for (int x = 6; x <= 14; x++) {
         for (int y = 2; y < rows - 2; y++) {
             if ((x + y) % 2 == 0) {
-                game->map->data[y][x] = CELL_WALL_RED;
+                MAP_AT(game->map, x, y) = CELL_WALL_RED;
             } else {
-                game->map->data[y][x] = CELL_WALL_BLUE;
+                MAP_AT(game->map, x, y) = CELL_WALL_BLUE;
             }
         }
     }
 
     /* Crear "caminos" específicos para cada fase */
     for (int y = 3; y < rows - 3; y += 3) {
-        game->map->data[y][8] = CELL_FLOOR;
-        game->map->data[y][12] = CELL_FLOOR;
+        MAP_AT(game->map, 8, y) = CELL_FLOOR;
+        MAP_AT(game->map, 12, y) = CELL_FLOOR;
     }
 
     /* Llave en el centro del patrón */
     allocate_item(game, ivec2(10, rows / 2), ITEM_KEY);
 
     /* Puerta y salida */
-    game->map->data[rows / 2][17] = CELL_DOOR;
+    MAP_AT(game->map, 17, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(18, rows / 2);
-    game->map->data[rows / 2][18] = CELL_EXIT;
+    MAP_AT(game->map, 18, rows / 2) = CELL_EXIT;
 
     /* Muros alrededor de la salida para forzar paso por la puerta */
     for (int y = 1; y < rows - 1; y++) {
         if (y != rows / 2) {
-            game->map->data[y][16] = CELL_WALL;
-            game->map->data[y][17] = CELL_WALL;
-            game->map->data[y][18] = CELL_WALL;
+            MAP_AT(game->map, 16, y) = CELL_WALL;
+            MAP_AT(game->map, 17, y) = CELL_WALL;
+            MAP_AT(game->map, 18, y) = CELL_WALL;
         }
     }
 
@@ -127,34 +135,34 @@ void load_level_2(GameState *game) {
     /* Corredor zigzag que FUERZA cambio de fase */
     /* Sección 1: bloqueada por muros ROJOS (necesitas fase AZUL para pasar) */
     for (int y = 1; y < rows - 1; y++) {
-        game->map->data[y][5] = CELL_WALL_RED;
+        MAP_AT(game->map, 5, y) = CELL_WALL_RED;
     }
     /* Apertura solo abajo */
-    game->map->data[rows - 3][5] = CELL_FLOOR;
+    MAP_AT(game->map, 5, rows - 3) = CELL_FLOOR;
 
     /* Sección 2: bloqueada por muros AZULES (necesitas fase ROJA) */
     for (int y = 1; y < rows - 1; y++) {
-        game->map->data[y][10] = CELL_WALL_BLUE;
+        MAP_AT(game->map, 10, y) = CELL_WALL_BLUE;
     }
     /* Apertura solo arriba */
-    game->map->data[2][10] = CELL_FLOOR;
+    MAP_AT(game->map, 10, 2) = CELL_FLOOR;
 
     /* Sección 3: bloqueada por muros ROJOS de nuevo */
     for (int y = 1; y < rows - 1; y++) {
-        game->map->data[y][15] = CELL_WALL_RED;
+        MAP_AT(game->map, 15, y) = CELL_WALL_RED;
     }
     /* Apertura solo abajo */
-    game->map->data[rows - 3][15] = CELL_FLOOR;
+    MAP_AT(game->map, 15, rows - 3) = CELL_FLOOR;
 
     /* Muros horizontales para forzar el zigzag */
     for (int x = 1; x < 5; x++) {
-        game->map->data[rows / 2][x] = CELL_WALL;
+        MAP_AT(game->map, x, rows / 2) = CELL_WALL;
     }
     for (int x = 6; x < 10; x++) {
-        game->map->data[rows / 2 - 2][x] = CELL_WALL;
+        MAP_AT(game->map, x, rows / 2 - 2) = CELL_WALL;
     }
     for (int x = 11; x < 15; x++) {
-        game->map->data[rows / 2][x] = CELL_WALL;
+        MAP_AT(game->map, x, rows / 2) = CELL_WALL;
     }
 
     /* Llave detrás de la segunda barrera de fase */
@@ -163,15 +171,15 @@ void load_level_2(GameState *game) {
     /* Muros azules alrededor de la salida para forzar paso por la puerta */
     for (int y = 1; y < rows - 1; y++) {
         if (y != rows / 2) {
-            game->map->data[y][19] = CELL_WALL_BLUE;
-            game->map->data[y][20] = CELL_WALL_BLUE;
+            MAP_AT(game->map, 19, y) = CELL_WALL_BLUE;
+            MAP_AT(game->map, 20, y) = CELL_WALL_BLUE;
         }
     }
 
     /* Puerta y salida */
-    game->map->data[rows / 2][19] = CELL_DOOR;
+    MAP_AT(game->map, 19, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(20, rows / 2);
-    game->map->data[rows / 2][20] = CELL_EXIT;
+    MAP_AT(game->map, 20, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, 2);
 }
@@ -195,14 +203,14 @@ void load_level_3(GameState *game) {
 
     /* Barricada vertical antes de la salida */
     for (int y = 1; y < rows - 1; y++) {
-        game->map->data[y][12] = CELL_BARRICADE;
+        MAP_AT(game->map, 12, y) = CELL_BARRICADE;
     }
 
     /* Muros decorativos para guiar al jugador */
     for (int x = 3; x <= 9; x++) {
-        game->map->data[6][x] = CELL_WALL;
+        MAP_AT(game->map, x, 6) = CELL_WALL;
     }
-    game->map->data[6][6] = CELL_FLOOR; /* Paso central entre botones */
+    MAP_AT(game->map, 6, 6) = CELL_FLOOR; /* Paso central entre botones */
 
     /* Recarga de bomba como alternativa */
     allocate_item(game, ivec2(3, rows - 3), ITEM_BOMB_REFILL);
@@ -211,7 +219,7 @@ void load_level_3(GameState *game) {
 
     /* Salida detrás de la barricada */
     game->exit_position = ivec2(17, rows / 2);
-    game->map->data[rows / 2][17] = CELL_EXIT;
+    MAP_AT(game->map, 17, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -229,19 +237,19 @@ void load_level_4(GameState *game) {
     /* Forma de "H" — la puerta Hadamard crea superposición */
     /* Pilar izquierdo de la H (rojo) */
     for (int y = 2; y < rows - 2; y++) {
-        game->map->data[y][6] = CELL_WALL_RED;
+        MAP_AT(game->map, 6, y) = CELL_WALL_RED;
     }
     /* Pilar derecho de la H (azul) */
     for (int y = 2; y < rows - 2; y++) {
-        game->map->data[y][13] = CELL_WALL_BLUE;
+        MAP_AT(game->map, 13, y) = CELL_WALL_BLUE;
     }
     /* Puente horizontal de la H */
     for (int x = 6; x <= 13; x++) {
-        game->map->data[rows / 2][x] = CELL_WALL;
+        MAP_AT(game->map, x, rows / 2) = CELL_WALL;
     }
     /* Aperturas fase en el puente */
-    game->map->data[rows / 2][8] = CELL_WALL_RED;
-    game->map->data[rows / 2][11] = CELL_WALL_BLUE;
+    MAP_AT(game->map, 8, rows / 2) = CELL_WALL_RED;
+    MAP_AT(game->map, 11, rows / 2) = CELL_WALL_BLUE;
 
     /*
      * REDESIGN:
@@ -256,7 +264,7 @@ void load_level_4(GameState *game) {
 
     /* Barrera (Muro Rojo) que bloquea el paso, se abre con botones */
     for (int y = 0; y < rows; y++) {
-        game->map->data[y][14] = CELL_BARRICADE;
+        MAP_AT(game->map, 14, y) = CELL_BARRICADE;
     }
     /* Apertura central en barricada (opcional, si es muro completo, botones lo
      * borran) */
@@ -268,14 +276,14 @@ void load_level_4(GameState *game) {
 
     /* Salida rodeada de puertas */
     game->exit_position = ivec2(18, rows / 2);
-    game->map->data[rows / 2][18] = CELL_EXIT;
+    MAP_AT(game->map, 18, rows / 2) = CELL_EXIT;
 
     // Surround Exit
-    game->map->data[rows / 2][17] = CELL_DOOR;     // Left
-    game->map->data[rows / 2 - 1][18] = CELL_DOOR; // Top
-    game->map->data[rows / 2 + 1][18] = CELL_DOOR; // Bottom
+    MAP_AT(game->map, 17, rows / 2) = CELL_DOOR;     // Left
+    MAP_AT(game->map, 18, rows / 2 - 1) = CELL_DOOR; // Top
+    MAP_AT(game->map, 18, rows / 2 + 1) = CELL_DOOR; // Bottom
     if (19 < cols)
-        game->map->data[rows / 2][19] = CELL_DOOR; // Right
+        MAP_AT(game->map, 19, rows / 2) = CELL_DOOR; // Right
 
     /* Coherencia */
     allocate_item(game, ivec2(3, 3), ITEM_COHERENCE_PICKUP);
@@ -298,22 +306,22 @@ void load_level_5(GameState *game) {
     /* Laberinto denso y claustrofóbico */
     /* Muros verticales */
     for (int y = 2; y < rows - 2; y++) {
-        game->map->data[y][5] = CELL_WALL;
-        game->map->data[y][10] = CELL_WALL;
-        game->map->data[y][15] = CELL_WALL;
-        game->map->data[y][19] = CELL_WALL;
+        MAP_AT(game->map, 5, y) = CELL_WALL;
+        MAP_AT(game->map, 10, y) = CELL_WALL;
+        MAP_AT(game->map, 15, y) = CELL_WALL;
+        MAP_AT(game->map, 19, y) = CELL_WALL;
     }
     /* Muros horizontales para cortar visión */
     for (int x = 2; x < 5; x++)
-        game->map->data[5][x] = CELL_WALL;
+        MAP_AT(game->map, x, 5) = CELL_WALL;
     for (int x = 11; x < 15; x++)
-        game->map->data[rows - 5][x] = CELL_WALL;
+        MAP_AT(game->map, x, rows - 5) = CELL_WALL;
 
     /* Aperturas estrechas y trampas de fase */
-    game->map->data[4][5] = CELL_WALL_RED;    /* Solo cruza en ROJO */
-    game->map->data[12][10] = CELL_WALL_BLUE; /* Solo cruza en AZUL */
-    game->map->data[6][15] = CELL_WALL_RED;
-    game->map->data[10][19] = CELL_WALL_BLUE;
+    MAP_AT(game->map, 5, 4) = CELL_WALL_RED;    /* Solo cruza en ROJO */
+    MAP_AT(game->map, 10, 12) = CELL_WALL_BLUE; /* Solo cruza en AZUL */
+    MAP_AT(game->map, 15, 6) = CELL_WALL_RED;
+    MAP_AT(game->map, 19, 10) = CELL_WALL_BLUE;
 
     /* Grid de detectores (Oráculos) */
     spawn_detector(game, ivec2(3, 3), DIR_DOWN, PHASE_RED);
@@ -338,14 +346,14 @@ void load_level_5(GameState *game) {
 
     /* Salida */
     game->exit_position = ivec2(22, rows / 2);
-    game->map->data[rows / 2][22] = CELL_EXIT;
+    MAP_AT(game->map, 22, rows / 2) = CELL_EXIT;
 
     // Surround with Doors
-    game->map->data[rows / 2][21] = CELL_DOOR;     // Left
-    game->map->data[rows / 2 - 1][22] = CELL_DOOR; // Top
-    game->map->data[rows / 2 + 1][22] = CELL_DOOR; // Bottom
+    MAP_AT(game->map, 21, rows / 2) = CELL_DOOR;     // Left
+    MAP_AT(game->map, 22, rows / 2 - 1) = CELL_DOOR; // Top
+    MAP_AT(game->map, 22, rows / 2 + 1) = CELL_DOOR; // Bottom
     if (23 < cols)
-        game->map->data[rows / 2][23] = CELL_DOOR; // Right
+        MAP_AT(game->map, 23, rows / 2) = CELL_DOOR; // Right
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -363,10 +371,10 @@ void load_level_6(GameState *game) {
 
     /* Tres zonas aisladas */
     for (int y = 1; y < rows - 1; y++) {
-        game->map->data[y][9] = CELL_WALL;
-        game->map->data[y][10] = CELL_WALL;
-        game->map->data[y][18] = CELL_WALL;
-        game->map->data[y][19] = CELL_WALL;
+        MAP_AT(game->map, 9, y) = CELL_WALL;
+        MAP_AT(game->map, 10, y) = CELL_WALL;
+        MAP_AT(game->map, 18, y) = CELL_WALL;
+        MAP_AT(game->map, 19, y) = CELL_WALL;
     }
 
     /* Túnel 1: (7,4) -> (11,7) [Zona 2] - EMBOSCADA */
@@ -383,12 +391,12 @@ void load_level_6(GameState *game) {
 
     /* Botón alternativo protegido por muros de fase */
     spawn_button(game, ivec2(14, 2), PHASE_RED);
-    game->map->data[3][14] = CELL_WALL_BLUE; /* Bloquea acceso directo */
+    MAP_AT(game->map, 14, 3) = CELL_WALL_BLUE; /* Bloquea acceso directo */
 
     /* Barricadas */
     for (int y = rows / 2 - 1; y <= rows / 2 + 1; y++) {
-        game->map->data[y][18] = CELL_BARRICADE;
-        game->map->data[y][19] = CELL_BARRICADE;
+        MAP_AT(game->map, 18, y) = CELL_BARRICADE;
+        MAP_AT(game->map, 19, y) = CELL_BARRICADE;
     }
 
     /* Items escasos */
@@ -399,13 +407,13 @@ void load_level_6(GameState *game) {
                   ITEM_COHERENCE_PICKUP); /* Uno en salida */
 
     game->exit_position = ivec2(26, rows / 2);
-    game->map->data[rows / 2][26] = CELL_EXIT;
+    MAP_AT(game->map, 26, rows / 2) = CELL_EXIT;
     // Surround with Doors
-    game->map->data[rows / 2][25] = CELL_DOOR;     // Left
-    game->map->data[rows / 2 - 1][26] = CELL_DOOR; // Top
-    game->map->data[rows / 2 + 1][26] = CELL_DOOR; // Bottom
+    MAP_AT(game->map, 25, rows / 2) = CELL_DOOR;     // Left
+    MAP_AT(game->map, 26, rows / 2 - 1) = CELL_DOOR; // Top
+    MAP_AT(game->map, 26, rows / 2 + 1) = CELL_DOOR; // Bottom
     if (27 < cols)
-        game->map->data[rows / 2][27] = CELL_DOOR; // Right
+        MAP_AT(game->map, 27, rows / 2) = CELL_DOOR; // Right
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -423,21 +431,21 @@ void load_level_7(GameState *game) {
 
     /* Tres corredores */
     for (int x = 4; x < cols - 4; x++) {
-        game->map->data[5][x] = CELL_WALL;
-        game->map->data[12][x] = CELL_WALL;
+        MAP_AT(game->map, x, 5) = CELL_WALL;
+        MAP_AT(game->map, x, 12) = CELL_WALL;
     }
     /* Aperturas */
-    game->map->data[5][4] = CELL_FLOOR;
-    game->map->data[12][4] = CELL_FLOOR;
-    game->map->data[5][cols - 5] = CELL_FLOOR;
-    game->map->data[12][cols - 5] = CELL_FLOOR;
+    MAP_AT(game->map, 4, 5) = CELL_FLOOR;
+    MAP_AT(game->map, 4, 12) = CELL_FLOOR;
+    MAP_AT(game->map, cols - 5, 5) = CELL_FLOOR;
+    MAP_AT(game->map, cols - 5, 12) = CELL_FLOOR;
 
     /* Corredor SUPERIOR: Muros de fase + GUARDIA */
     for (int x = 7; x < cols - 5; x += 3)
-        game->map->data[3][x] = CELL_WALL_RED;
+        MAP_AT(game->map, x, 3) = CELL_WALL_RED;
 
     // FIX: Remove wall at 16 to give guard space
-    game->map->data[3][16] = CELL_FLOOR;
+    MAP_AT(game->map, 16, 3) = CELL_FLOOR;
 
     spawn_guard(game, ivec2(16, 3)); /* Guardia con espacio (15-17 libre) */
 
@@ -455,7 +463,7 @@ void load_level_7(GameState *game) {
 
     /* Barrera final */
     for (int y = 0; y < rows; y++)
-        game->map->data[y][cols - 3] = CELL_BARRICADE;
+        MAP_AT(game->map, cols - 3, y) = CELL_BARRICADE;
 
     /* Coherencia mínima */
     allocate_item(game, ivec2(6, 8), ITEM_COHERENCE_PICKUP); /* Uno al inicio */
@@ -467,7 +475,7 @@ void load_level_7(GameState *game) {
     game->player.bombs = 1;
 
     game->exit_position = ivec2(cols - 2, rows / 2);
-    game->map->data[rows / 2][cols - 2] = CELL_EXIT;
+    MAP_AT(game->map, cols - 2, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -488,22 +496,22 @@ void load_level_8(GameState *game) {
     for (int y = 3; y < 9; y++) {
         for (int x = 4; x < 10; x++) {
             if ((x + y) % 3 == 0)
-                game->map->data[y][x] = CELL_WALL_RED;
+                MAP_AT(game->map, x, y) = CELL_WALL_RED;
             else if ((x + y) % 3 == 1)
-                game->map->data[y][x] = CELL_WALL_BLUE;
+                MAP_AT(game->map, x, y) = CELL_WALL_BLUE;
         }
     }
     /* Pasillo libre mínimo */
-    game->map->data[4][6] = CELL_FLOOR;
-    game->map->data[7][6] = CELL_FLOOR;
+    MAP_AT(game->map, 6, 4) = CELL_FLOOR;
+    MAP_AT(game->map, 6, 7) = CELL_FLOOR;
 
     /* Guardia patrullando Zona 1 */
     spawn_guard(game, ivec2(8, 8));
 
     /* Muro Zona 1->2 */
     for (int y = 1; y < rows - 1; y++)
-        game->map->data[y][11] = CELL_WALL;
-    game->map->data[6][11] = CELL_FLOOR; /* Apertura vigilada */
+        MAP_AT(game->map, 11, y) = CELL_WALL;
+    MAP_AT(game->map, 11, 6) = CELL_FLOOR; /* Apertura vigilada */
 
     /* ZONA 2: The Kill Box */
     /* 4 DETECTORES cubriendo el área central */
@@ -521,7 +529,7 @@ void load_level_8(GameState *game) {
 
     /* Muro Zona 2->3 (Barricada) */
     for (int y = 1; y < rows - 1; y++)
-        game->map->data[y][21] = CELL_BARRICADE;
+        MAP_AT(game->map, 21, y) = CELL_BARRICADE;
 
     /* ZONA 3: The Escape */
     /* Tunel para atravesar muro final */
@@ -530,7 +538,7 @@ void load_level_8(GameState *game) {
 
     /* Muro final */
     for (int y = 5; y < 10; y++)
-        game->map->data[y][27] = CELL_WALL;
+        MAP_AT(game->map, 27, y) = CELL_WALL;
 
     /* Llave y Salida */
     allocate_item(game, ivec2(28, 7), ITEM_KEY);
@@ -547,14 +555,14 @@ void load_level_8(GameState *game) {
     game->player.bombs = 2;
 
     game->exit_position = ivec2(28, rows / 2);
-    game->map->data[rows / 2][28] = CELL_EXIT;
+    MAP_AT(game->map, 28, rows / 2) = CELL_EXIT;
 
     // Surround with Doors
-    game->map->data[rows / 2][27] = CELL_DOOR;     // Left
-    game->map->data[rows / 2 - 1][28] = CELL_DOOR; // Top
-    game->map->data[rows / 2 + 1][28] = CELL_DOOR; // Bottom
+    MAP_AT(game->map, 27, rows / 2) = CELL_DOOR;     // Left
+    MAP_AT(game->map, 28, rows / 2 - 1) = CELL_DOOR; // Top
+    MAP_AT(game->map, 28, rows / 2 + 1) = CELL_DOOR; // Bottom
     if (29 < cols)
-        game->map->data[rows / 2][29] = CELL_DOOR; // Right
+        MAP_AT(game->map, 29, rows / 2) = CELL_DOOR; // Right
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -574,8 +582,8 @@ void load_level_9(GameState *game) {
 
     // Zone 1: Red/Blue Puzzle to get Unlocker
     for (int x = 8; x < 16; x++) {
-        game->map->data[5][x] = CELL_WALL_RED;
-        game->map->data[10][x] = CELL_WALL_BLUE;
+        MAP_AT(game->map, x, 5) = CELL_WALL_RED;
+        MAP_AT(game->map, x, 10) = CELL_WALL_BLUE;
     }
 
     // Item to unlock Green
@@ -583,9 +591,9 @@ void load_level_9(GameState *game) {
 
     // Exit Zone protected by Green Walls
     for (int y = 0; y < rows; y++) {
-        game->map->data[y][18] = CELL_WALL_GREEN;
+        MAP_AT(game->map, 18, y) = CELL_WALL_GREEN;
     }
-    game->map->data[rows / 2][18] =
+    MAP_AT(game->map, 18, rows / 2) =
         CELL_WALL_GREEN; // Make sure it's blocked by green
 
     // Use a button mechanism?
@@ -598,7 +606,7 @@ void load_level_9(GameState *game) {
     // If player gets unlocker, they can switch to Green and pass.
 
     game->exit_position = ivec2(22, rows / 2);
-    game->map->data[rows / 2][22] = CELL_EXIT;
+    MAP_AT(game->map, 22, rows / 2) = CELL_EXIT;
     game->player.position = ivec2(2, rows / 2);
 }
 
@@ -614,7 +622,7 @@ void load_level_10(GameState *game) {
 
     /* Dos islas separadas por un muro */
     for (int y = 0; y < rows; y++)
-        game->map->data[y][10] = CELL_WALL;
+        MAP_AT(game->map, 10, y) = CELL_WALL;
 
     /* Portal ROJO en isla 1 (izquierda) -> lleva a isla 2 */
     spawn_portal(game, ivec2(7, rows / 2), 1, PHASE_RED);
@@ -626,11 +634,11 @@ void load_level_10(GameState *game) {
     allocate_item(game, ivec2(15, 3), ITEM_KEY);
 
     /* Puerta y salida en isla 1 */
-    game->map->data[rows / 2][18] = CELL_DOOR;
+    MAP_AT(game->map, 18, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(18, rows / 2);
-    game->map->data[rows / 2][18] = CELL_DOOR;
+    MAP_AT(game->map, 18, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(19, rows / 2);
-    game->map->data[rows / 2][19] = CELL_EXIT;
+    MAP_AT(game->map, 19, rows / 2) = CELL_EXIT;
 
     /* Jugador empieza en isla 1 */
     game->player.position = ivec2(2, rows / 2);
@@ -653,9 +661,48 @@ void load_level(GameState *game, int level_index) {
     // game->player.phase_shifts // MANTENER
     // game->player.deaths // MANTENER
     game->player.qubit_count = 0; // Items reiniciados
+    init_quantum_register(&game->player.qreg);
     game->player.keys = 0;        // Items reiniciados
     game->player.bombs = 0;       // Items reiniciados
 
+    /* Si está compilado (tools/level_compiler.c) se mapea el .psl */
+    char path[64];
+    level_file_path(path, sizeof(path), level_index);
+    if (!level_file_load(game, path))
+        build_level(game, level_index);
+}
+
+/* Recarga en caliente del .psl del nivel en juego. Si el tamaño y las
+ * entidades no cambiaron se parchea lo que tocó el editor; si no, se carga
+ * entero con load_level. El jugador se queda donde estaba si puede */
+bool reload_level_in_place(GameState *game, LevelFileSnapshot *applied) {
+    char path[64];
+    level_file_path(path, sizeof(path), game->current_level);
+    LevelFileSnapshot next;
+    if (!level_file_snapshot(&next, path))
+        return false;
+
+    int changed = applied->data ? level_file_patch(game, applied, &next) : -1;
+    IVector2 pos = game->player.position;
+    if (changed < 0) {
+        load_level(game, game->current_level);
+    } else {
+        const LevelFileHeader *h = (const LevelFileHeader *)next.data;
+        game->player.position = ivec2(h->player_x, h->player_y);
+    }
+    if (within_map(game, pos) &&
+        BOARD_BIT(player_passability(game), game->passability.words, pos.x,
+                  pos.y))
+        game->player.position = pos;
+    /* Sin animar el salto, se quede o vuelva al inicio */
+    game->player.prev_position = game->player.position;
+
+    level_file_snapshot_free(applied);
+    *applied = next;
+    return true;
+}
+
+void build_level(GameState *game, int level_index) {
     switch (level_index) {
     case 0:
         load_level_1(game);
@@ -721,6 +768,8 @@ void load_level(GameState *game, int level_index) {
         load_level_1(game);
         break;
     }
+    map_rebuild_passability(game);
+    build_level_triggers(game);
 }
 
 void init_intro_dialogs(GameState *game) {
@@ -786,6 +835,11 @@ void show_level_dialog(GameState *game) {
 
     snprintf(d->pages[0].title, 64, "%s", game->level_name);
 
+    if (game->level_dialog[0]) {
+        snprintf(d->pages[0].text, MAX_DIALOG_TEXT, "%s", game->level_dialog);
+        return;
+    }
+
     switch (game->current_level) {
     case 0:
         strncpy(d->pages[0].text,
@@ -1050,304 +1104,182 @@ void show_level_dialog(GameState *game) {
     }
 }
 
-void check_level_events(GameState *game) {
-    /* NIVEL 3: Ambos botones deben estar pulsados para abrir barricada col 12
-     */
-    if (game->current_level == 2) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
-
-        if (active_count > 0 && all_pressed) {
-            int gate_col = 12;
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][gate_col] == CELL_BARRICADE) {
-                    game->map->data[y][gate_col] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed) {
-                PlayAudioSound(phase_shift_sound);
-            }
-        }
-    }
-
-    /* NIVEL 4 (HADAMARD): Ambos botones abren barrera col 21 */
-    if (game->current_level == 3) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
-
-        if (active_count > 0 && all_pressed) {
-            int gate_col = 14; /* FIXED: Was 17, now bar is at 14 */
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][gate_col] == CELL_BARRICADE) {
-                    game->map->data[y][gate_col] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed) {
-                PlayAudioSound(phase_shift_sound);
-            }
-        }
-    }
-
-    /* NIVEL 6 (TELETRANSPORTE): Botón abre barricadas en muros zona 2→3 */
-    if (game->current_level == 5) {
-        bool button_pressed = false;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active && game->buttons[i].is_pressed) {
-                button_pressed = true;
-                break;
-            }
-        }
-
-        if (button_pressed) {
-            for (int y = game->map->rows / 2 - 1; y <= game->map->rows / 2 + 1;
-                 y++) {
-                if (game->map->data[y][18] == CELL_BARRICADE) {
-                    game->map->data[y][18] = CELL_FLOOR;
-                }
-                if (game->map->data[y][19] == CELL_BARRICADE) {
-                    game->map->data[y][19] = CELL_FLOOR;
-                }
-            }
-            PlayAudioSound(phase_shift_sound);
-        }
+/* ===== DISPARADORES DE NIVEL ===== */
+
+static LevelTrigger *add_trigger(GameState *game, TriggerCondition condition,
+                                 bool sound_every_press) {
+    if (game->trigger_count >= MAX_TRIGGERS)
+        return NULL;
+    LevelTrigger *t = &game->triggers[game->trigger_count++];
+    memset(t, 0, sizeof(*t));
+    t->condition = condition;
+    t->sound_every_press = sound_every_press;
+    t->cell_start = game->trigger_cell_count;
+    for (int i = 0; i < MAX_BUTTONS; i++) {
+        if (game->buttons[i].is_active)
+            t->buttons |= 1u << i;
     }
+    return t;
+}
 
-    /* NIVEL 7 (CORRECCIÓN ERRORES): Botón abre barrera col (cols-3) */
-    if (game->current_level == 6) {
-        bool button_pressed = false;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active && game->buttons[i].is_pressed) {
-                button_pressed = true;
-                break;
-            }
-        }
-
-        if (button_pressed) {
-            int gate_col = game->map->cols - 3;
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][gate_col] == CELL_BARRICADE) {
-                    game->map->data[y][gate_col] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed) {
-                PlayAudioSound(phase_shift_sound);
-            }
-        }
+/* Apunta las casillas de la columna col (filas y0..y1) que ahora son
+ * `from`: al dispararse sólo se tocan ésas, sin barrer el mapa */
+static void trigger_open_column(GameState *game, LevelTrigger *t, int col,
+                                int y0, int y1, Cell from) {
+    if (!t)
+        return;
+    t->action = TRIGGER_OPEN_CELLS;
+    t->from = from;
+    for (int y = y0; y <= y1; y++) {
+        IVector2 pos = ivec2(col, y);
+        if (!within_map(game, pos) || MAP_AT(game->map, col, y) != from)
+            continue;
+        if (game->trigger_cell_count >= MAX_TRIGGER_CELLS)
+            break;
+        game->trigger_cells[game->trigger_cell_count++] = pos;
+        t->cell_count++;
     }
+}
 
-    /* NIVEL 9 (TOFFOLI): Ambos botones abren muro verde col 18 */
-    if (game->current_level == 8) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
-
-        if (active_count > 0 && all_pressed) {
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][18] == CELL_WALL_GREEN) {
-                    game->map->data[y][18] = CELL_FLOOR;
-                }
-            }
-            PlayAudioSound(phase_shift_sound);
-        }
-    }
+static void trigger_activate_portal(LevelTrigger *t, IVector2 pos) {
+    if (!t)
+        return;
+    t->action = TRIGGER_ACTIVATE_PORTAL;
+    t->portal_pos = pos;
+}
 
-    /* NIVEL 8 (SUPREMACÍA): Ambos botones abren barrera col 21 */
-    if (game->current_level == 7) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
+/* Se llama al final de load_level, con el nivel ya construido */
+void build_level_triggers(GameState *game) {
+    int rows = game->map->rows;
+    int cols = game->map->cols;
+    LevelTrigger *t;
 
-        if (active_count > 0 && all_pressed) {
-            int gate_col = 21;
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][gate_col] == CELL_BARRICADE) {
-                    game->map->data[y][gate_col] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed) {
-                PlayAudioSound(phase_shift_sound);
-            }
-        }
-    }
+    game->trigger_count = 0;
+    game->trigger_cell_count = 0;
+    game->buttons_pressed = 0;
+    game->trigger_buttons_seen = 0;
 
+    switch (game->current_level) {
+    case 2: /* NIVEL 3: Ambos botones deben estar pulsados para abrir
+             * barricada col 12 */
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, false);
+        trigger_open_column(game, t, 12, 0, rows - 1, CELL_BARRICADE);
+        break;
+    case 3: /* NIVEL 4 (HADAMARD): Ambos botones abren barrera col 14 */
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, false);
+        trigger_open_column(game, t, 14, 0, rows - 1, CELL_BARRICADE);
+        break;
+    case 5: /* NIVEL 6 (TELETRANSPORTE): Botón abre barricadas en muros zona
+             * 2→3 */
+        t = add_trigger(game, TRIGGER_ANY_BUTTON, true);
+        trigger_open_column(game, t, 18, rows / 2 - 1, rows / 2 + 1,
+                            CELL_BARRICADE);
+        trigger_open_column(game, t, 19, rows / 2 - 1, rows / 2 + 1,
+                            CELL_BARRICADE);
+        break;
+    case 6: /* NIVEL 7 (CORRECCIÓN ERRORES): Botón abre barrera col (cols-3) */
+        t = add_trigger(game, TRIGGER_ANY_BUTTON, false);
+        trigger_open_column(game, t, cols - 3, 0, rows - 1, CELL_BARRICADE);
+        break;
+    case 7: /* NIVEL 8 (SUPREMACÍA): Ambos botones abren barrera col 21 */
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, false);
+        trigger_open_column(game, t, 21, 0, rows - 1, CELL_BARRICADE);
+        break;
+    case 8: /* NIVEL 9 (TOFFOLI): Ambos botones abren muro verde col 18 */
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, true);
+        trigger_open_column(game, t, 18, 0, rows - 1, CELL_WALL_GREEN);
+        break;
     /* NIVEL 11 (LABERINTO DE FASE): No button events - key+door only */
-
-    /* NIVEL 12 (ECO Y GUARDIA): Button opens barricade wall col 9 */
-    if (game->current_level == 11) {
-        bool button_pressed = false;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active && game->buttons[i].is_pressed) {
-                button_pressed = true;
-                break;
-            }
-        }
-        if (button_pressed) {
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][9] == CELL_BARRICADE) {
-                    game->map->data[y][9] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed)
-                PlayAudioSound(phase_shift_sound);
-        }
-    }
-
-    /* NIVEL 13 (DOS BOTONES): Both buttons open barricade col 14 */
-    if (game->current_level == 12) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
-        if (active_count > 0 && all_pressed) {
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][14] == CELL_BARRICADE) {
-                    game->map->data[y][14] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed)
-                PlayAudioSound(phase_shift_sound);
-        }
-    }
-
+    case 11: /* NIVEL 12 (ECO Y GUARDIA): Button opens barricade wall col 9 */
+        t = add_trigger(game, TRIGGER_ANY_BUTTON, false);
+        trigger_open_column(game, t, 9, 0, rows - 1, CELL_BARRICADE);
+        break;
+    case 12: /* NIVEL 13 (DOS BOTONES): Both buttons open barricade col 14 */
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, false);
+        trigger_open_column(game, t, 14, 0, rows - 1, CELL_BARRICADE);
+        break;
     /* NIVEL 14 (PORTALES Y FASE): No button events - portals+key only */
-
-    /* NIVEL 15 (PRUEBA FINAL): Both buttons open barricade col 17 */
-    if (game->current_level == 14) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
-        if (active_count > 0 && all_pressed) {
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][17] == CELL_BARRICADE) {
-                    game->map->data[y][17] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed)
-                PlayAudioSound(phase_shift_sound);
-        }
+    case 14: /* NIVEL 15 (PRUEBA FINAL): Both buttons open barricade col 17
+              * y la salida */
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, false);
+        trigger_open_column(game, t, 17, 0, rows - 1, CELL_BARRICADE);
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, false);
+        trigger_open_column(game, t, cols - 2, 0, rows - 1, CELL_BARRICADE);
+        break;
+    case 16: /* NIVEL 17 (ENTRELAZAMIENTO): Boton abre salida (portal de la
+              * jaula del guardia) */
+        t = add_trigger(game, TRIGGER_ANY_BUTTON, true);
+        trigger_activate_portal(t, ivec2(17, 7));
+        break;
+    case 18: /* NIVEL 19 (EJECUCION FINAL): 3 botones abren la compuerta
+              * final */
+        t = add_trigger(game, TRIGGER_ALL_BUTTONS, false);
+        trigger_open_column(game, t, cols - 4, 0, rows - 1, CELL_BARRICADE);
+        break;
+    default:
+        break;
     }
+}
 
-    /* NIVEL 15 (PRUEBA FINAL): Dos botones abren la salida */
-    if (game->current_level == 14) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
-        if (active_count > 0 && all_pressed) {
-            int gate_col = game->map->cols - 2;
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][gate_col] == CELL_BARRICADE) {
-                    game->map->data[y][gate_col] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed)
-                PlayAudioSound(phase_shift_sound);
-        }
+static bool trigger_condition_met(GameState *game, const LevelTrigger *t) {
+    switch (t->condition) {
+    case TRIGGER_ALL_BUTTONS:
+        return t->buttons != 0 &&
+               (game->buttons_pressed & t->buttons) == t->buttons;
+    case TRIGGER_ANY_BUTTON:
+        return (game->buttons_pressed & t->buttons) != 0;
+    default:
+        return false;
     }
+}
 
-    /* NIVEL 17 (ENTRELAZAMIENTO): Boton abre salida */
-    if (game->current_level == 16) {
-        bool any_pressed = false;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active && game->buttons[i].is_pressed) {
-                any_pressed = true;
-                break;
+static void trigger_fire(GameState *game, const LevelTrigger *t) {
+    bool changed = false;
+    switch (t->action) {
+    case TRIGGER_OPEN_CELLS:
+        for (int i = 0; i < t->cell_count; i++) {
+            IVector2 pos = game->trigger_cells[t->cell_start + i];
+            if (MAP_AT(game->map, pos.x, pos.y) == t->from) {
+                map_set_cell(game, pos, CELL_FLOOR);
+                changed = true;
             }
         }
-        if (any_pressed) {
-            // Activate Portal in Guard Cage
-            for (int i = 0; i < MAX_PORTALS; i++) {
-                if (game->portals[i].position.x == 17 &&
-                    game->portals[i].position.y == 7) {
-                    game->portals[i].active = true;
-                    game->portals[i].glow_intensity = 2.0f;
-                }
-            }
-            PlayAudioSound(phase_shift_sound);
+        break;
+    case TRIGGER_ACTIVATE_PORTAL:
+        for (EntityRef ref = entity_index_at(game, t->portal_pos); ref;
+             ref = entity_index_next(game, ref)) {
+            if (ENTITY_REF_KIND(ref) != ENTITY_PORTAL)
+                continue;
+            QuantumPortal *portal = &game->portals[ENTITY_REF_INDEX(ref)];
+            changed |= !portal->active;
+            portal->active = true;
+            portal->glow_intensity = 2.0f;
         }
+        break;
     }
+    if (changed || t->sound_every_press)
+        emit_sound(game, SOUND_PHASE_SHIFT);
+}
 
-    /* NIVEL 19 (EJECUCION FINAL): 3 botones abren la compuerta final */
-    if (game->current_level == 18) {
-        bool all_pressed = true;
-        int active_count = 0;
-        for (int i = 0; i < MAX_BUTTONS; i++) {
-            if (game->buttons[i].is_active) {
-                active_count++;
-                if (!game->buttons[i].is_pressed)
-                    all_pressed = false;
-            }
-        }
-        if (active_count > 0 && all_pressed) {
-            int gate_col = game->map->cols - 4;
-            bool was_closed = false;
-            for (int y = 0; y < game->map->rows; y++) {
-                if (game->map->data[y][gate_col] == CELL_BARRICADE) {
-                    game->map->data[y][gate_col] = CELL_FLOOR;
-                    was_closed = true;
-                }
-            }
-            if (was_closed)
-                PlayAudioSound(phase_shift_sound);
-        }
+/* Sin cambios en los botones no hay nada que evaluar; si no, sólo los
+ * disparadores suscritos a alguno de los que cambiaron, y actúan al
+ * cumplirse */
+void check_level_events(GameState *game) {
+    uint32_t changed_buttons =
+        game->buttons_pressed ^ game->trigger_buttons_seen;
+    if (!changed_buttons)
+        return;
+    game->trigger_buttons_seen = game->buttons_pressed;
+
+    for (int i = 0; i < game->trigger_count; i++) {
+        LevelTrigger *t = &game->triggers[i];
+        if (!(t->buttons & changed_buttons))
+            continue;
+
+        bool met = trigger_condition_met(game, t);
+        if (met && !t->was_met)
+            trigger_fire(game, t);
+        t->was_met = met;
     }
 }
 
@@ -1361,14 +1293,14 @@ void load_level_11(GameState *game) {
 
     /* Laberinto con muros alternados rojo/azul */
     for (int y = 2; y < rows - 2; y++) {
-        game->map->data[y][5] = CELL_WALL_RED;
-        game->map->data[y][10] = CELL_WALL_BLUE;
-        game->map->data[y][15] = CELL_WALL_RED;
+        MAP_AT(game->map, 5, y) = CELL_WALL_RED;
+        MAP_AT(game->map, 10, y) = CELL_WALL_BLUE;
+        MAP_AT(game->map, 15, y) = CELL_WALL_RED;
     }
     /* Aperturas en posiciones alternas */
-    game->map->data[3][5] = CELL_FLOOR;
-    game->map->data[rows - 4][10] = CELL_FLOOR;
-    game->map->data[5][15] = CELL_FLOOR;
+    MAP_AT(game->map, 5, 3) = CELL_FLOOR;
+    MAP_AT(game->map, 10, rows - 4) = CELL_FLOOR;
+    MAP_AT(game->map, 15, 5) = CELL_FLOOR;
 
     /* Guardia patrullando la zona central */
     spawn_guard(game, ivec2(8, rows / 2));
@@ -1380,11 +1312,11 @@ void load_level_11(GameState *game) {
     allocate_item(game, ivec2(7, rows - 3), ITEM_COHERENCE_PICKUP);
 
     /* Puerta y salida */
-    game->map->data[rows / 2][18] = CELL_DOOR;
+    MAP_AT(game->map, 18, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(18, rows / 2);
-    game->map->data[rows / 2][18] = CELL_DOOR;
+    MAP_AT(game->map, 18, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(19, rows / 2);
-    game->map->data[rows / 2][19] = CELL_EXIT;
+    MAP_AT(game->map, 19, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -1399,7 +1331,7 @@ void load_level_12(GameState *game) {
 
     /* Muro central con barricada */
     for (int y = 0; y < rows; y++)
-        game->map->data[y][9] = CELL_BARRICADE;
+        MAP_AT(game->map, 9, y) = CELL_BARRICADE;
 
     /* Boton que abre la barricada (ROJO) */
     spawn_button(game, ivec2(4, rows / 2), PHASE_RED);
@@ -1416,9 +1348,9 @@ void load_level_12(GameState *game) {
     allocate_item(game, ivec2(15, 3), ITEM_KEY);
 
     /* Puerta y salida */
-    game->map->data[rows / 2][16] = CELL_DOOR;
+    MAP_AT(game->map, 16, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(17, rows / 2);
-    game->map->data[rows / 2][17] = CELL_EXIT;
+    MAP_AT(game->map, 17, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -1437,12 +1369,12 @@ void load_level_13(GameState *game) {
 
     /* Barricada que bloquea salida */
     for (int y = 0; y < rows; y++)
-        game->map->data[y][14] = CELL_BARRICADE;
+        MAP_AT(game->map, 14, y) = CELL_BARRICADE;
 
     /* Muros de fase para complicar acceso */
     for (int y = 2; y < rows - 2; y++)
-        game->map->data[y][7] = CELL_WALL_RED;
-    game->map->data[rows / 2][7] = CELL_FLOOR;
+        MAP_AT(game->map, 7, y) = CELL_WALL_RED;
+    MAP_AT(game->map, 7, rows / 2) = CELL_FLOOR;
 
     /* Llave */
     allocate_item(game, ivec2(12, rows / 2), ITEM_KEY);
@@ -1451,9 +1383,9 @@ void load_level_13(GameState *game) {
     allocate_item(game, ivec2(4, 3), ITEM_COHERENCE_PICKUP);
 
     /* Puerta y salida */
-    game->map->data[rows / 2][16] = CELL_DOOR;
+    MAP_AT(game->map, 16, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(17, rows / 2);
-    game->map->data[rows / 2][17] = CELL_EXIT;
+    MAP_AT(game->map, 17, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -1468,8 +1400,8 @@ void load_level_14(GameState *game) {
 
     /* Tres secciones separadas por muros */
     for (int y = 0; y < rows; y++) {
-        game->map->data[y][7] = CELL_WALL;
-        game->map->data[y][14] = CELL_WALL;
+        MAP_AT(game->map, 7, y) = CELL_WALL;
+        MAP_AT(game->map, 14, y) = CELL_WALL;
     }
 
     /* Portal ROJO en seccion 1 -> seccion 2 */
@@ -1481,8 +1413,8 @@ void load_level_14(GameState *game) {
 
     /* Muros de fase en seccion 2 */
     for (int y = 3; y < rows - 3; y++)
-        game->map->data[y][10] = CELL_WALL_BLUE;
-    game->map->data[rows / 2 + 1][10] = CELL_FLOOR;
+        MAP_AT(game->map, 10, y) = CELL_WALL_BLUE;
+    MAP_AT(game->map, 10, rows / 2 + 1) = CELL_FLOOR;
 
     /* Guardia en seccion 2 */
     spawn_guard(game, ivec2(11, 4));
@@ -1494,9 +1426,9 @@ void load_level_14(GameState *game) {
     allocate_item(game, ivec2(10, rows - 3), ITEM_COHERENCE_PICKUP);
 
     /* Puerta y salida en seccion 3 */
-    game->map->data[rows / 2][20] = CELL_DOOR;
+    MAP_AT(game->map, 20, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(21, rows / 2);
-    game->map->data[rows / 2][21] = CELL_EXIT;
+    MAP_AT(game->map, 21, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -1511,11 +1443,11 @@ void load_level_15(GameState *game) {
 
     /* ZONA 1: Laberinto de fase (izquierda) */
     for (int y = 2; y < rows - 2; y++) {
-        game->map->data[y][5] = CELL_WALL_RED;
-        game->map->data[y][8] = CELL_WALL_BLUE;
+        MAP_AT(game->map, 5, y) = CELL_WALL_RED;
+        MAP_AT(game->map, 8, y) = CELL_WALL_BLUE;
     }
-    game->map->data[4][5] = CELL_FLOOR;
-    game->map->data[rows - 4][8] = CELL_FLOOR;
+    MAP_AT(game->map, 5, 4) = CELL_FLOOR;
+    MAP_AT(game->map, 8, rows - 4) = CELL_FLOOR;
 
     /* ZONA 2: Dos botones cercanos (distancia 5) */
     spawn_button(game, ivec2(12, rows / 2 - 2), PHASE_RED);
@@ -1526,14 +1458,14 @@ void load_level_15(GameState *game) {
     /* Barricade blocking exit, opened by button */
     /* FULLY BLOCK the exit area */
     for (int y = 0; y < rows; y++) {
-        game->map->data[y][cols - 2] = CELL_WALL; // Solid wall at x=20
+        MAP_AT(game->map, cols - 2, y) = CELL_WALL; // Solid wall at x=20
     }
-    game->map->data[6][cols - 2] = CELL_BARRICADE; // The only way through
-    game->map->data[5][cols - 2] = CELL_BARRICADE; // Wider opening
-    game->map->data[7][cols - 2] = CELL_BARRICADE;
+    MAP_AT(game->map, cols - 2, 6) = CELL_BARRICADE; // The only way through
+    MAP_AT(game->map, cols - 2, 5) = CELL_BARRICADE; // Wider opening
+    MAP_AT(game->map, cols - 2, 7) = CELL_BARRICADE;
 
     game->exit_position = ivec2(cols - 1, 6);
-    game->map->data[6][cols - 1] = CELL_EXIT;
+    MAP_AT(game->map, cols - 1, 6) = CELL_EXIT;
 
     game->player.position = ivec2(1, rows / 2);
 }
@@ -1549,10 +1481,10 @@ void load_level_16(GameState *game) {
     /* Central Chamber (Accessible only via Tunnel) */
     for (int x = 10; x <= 14; x++) {
         for (int y = 6; y <= 10; y++) {
-            game->map->data[y][x] = CELL_WALL;
+            MAP_AT(game->map, x, y) = CELL_WALL;
         }
     }
-    game->map->data[8][12] = CELL_FLOOR; // Inside chamber
+    MAP_AT(game->map, 12, 8) = CELL_FLOOR; // Inside chamber
 
     // Tunnel 1: Outside (4,4) -> Inside (12,8)
     spawn_tunnel(game, ivec2(4, 4), ivec2(1, 1), ivec2(8, 4));
@@ -1564,8 +1496,8 @@ void load_level_16(GameState *game) {
 
     /* Maze layout */
     for (int x = 6; x < 20; x += 4) {
-        game->map->data[4][x] = CELL_WALL_RED;
-        game->map->data[rows - 4][x] = CELL_WALL_BLUE;
+        MAP_AT(game->map, x, 4) = CELL_WALL_RED;
+        MAP_AT(game->map, x, rows - 4) = CELL_WALL_BLUE;
     }
 
     /* Detectors */
@@ -1576,10 +1508,10 @@ void load_level_16(GameState *game) {
     allocate_item(game, ivec2(22, 2), ITEM_KEY);
 
     /* Exit - Double Door */
-    game->map->data[rows / 2][cols - 3] = CELL_DOOR;
-    game->map->data[rows / 2][cols - 2] = CELL_DOOR;
+    MAP_AT(game->map, cols - 3, rows / 2) = CELL_DOOR;
+    MAP_AT(game->map, cols - 2, rows / 2) = CELL_DOOR;
     game->exit_position = ivec2(cols - 1, rows / 2);
-    game->map->data[rows / 2][cols - 1] = CELL_EXIT;
+    MAP_AT(game->map, cols - 1, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
 }
@@ -1594,8 +1526,8 @@ void load_level_17(GameState *game) {
 
     /* Exit ISOLATED by Barricades */
     for (int y = 0; y < rows; y++)
-        game->map->data[y][cols - 4] = CELL_WALL;
-    game->map->data[rows / 2][cols - 4] = CELL_BARRICADE;
+        MAP_AT(game->map, cols - 4, y) = CELL_WALL;
+    MAP_AT(game->map, cols - 4, rows / 2) = CELL_BARRICADE;
 
     /* Portal: Guard Cage -> Exit (Inactive initially) */
     spawn_portal(game, ivec2(17, 7), 1, PHASE_RED);
@@ -1605,18 +1537,18 @@ void load_level_17(GameState *game) {
     spawn_portal(game, ivec2(cols - 3, rows / 2), 0, PHASE_RED);
 
     game->exit_position = ivec2(cols - 2, rows / 2);
-    game->map->data[rows / 2][cols - 2] = CELL_EXIT;
+    MAP_AT(game->map, cols - 2, rows / 2) = CELL_EXIT;
 
     /* Guard Cage (Expanded for maneuvering) */
     for (int x = 15; x <= 21; x++) {
-        game->map->data[3][x] = CELL_WALL;  // Top
-        game->map->data[11][x] = CELL_WALL; // Bottom
+        MAP_AT(game->map, x, 3) = CELL_WALL;  // Top
+        MAP_AT(game->map, x, 11) = CELL_WALL; // Bottom
     }
     for (int y = 3; y <= 11; y++) {
-        game->map->data[y][15] = CELL_WALL; // Left
-        game->map->data[y][21] = CELL_WALL; // Right
+        MAP_AT(game->map, 15, y) = CELL_WALL; // Left
+        MAP_AT(game->map, 21, y) = CELL_WALL; // Right
     }
-    game->map->data[7][15] = CELL_WALL_RED; // Viewport (Left side)
+    MAP_AT(game->map, 15, 7) = CELL_WALL_RED; // Viewport (Left side)
 
     /* Button inside cage */
     spawn_button(game, ivec2(18, 7), PHASE_RED);
@@ -1643,22 +1575,22 @@ void load_level_18(GameState *game) {
 
     /* Oracle Search: 4 Chambers */
     for (int x = 2; x < 12; x++)
-        game->map->data[8][x] = CELL_WALL;
+        MAP_AT(game->map, x, 8) = CELL_WALL;
     for (int y = 2; y < 8; y++)
-        game->map->data[y][12] = CELL_WALL;
+        MAP_AT(game->map, 12, y) = CELL_WALL;
 
     for (int x = 14; x < 24; x++)
-        game->map->data[8][x] = CELL_WALL;
+        MAP_AT(game->map, x, 8) = CELL_WALL;
     for (int y = 2; y < 8; y++)
-        game->map->data[y][14] = CELL_WALL;
+        MAP_AT(game->map, 14, y) = CELL_WALL;
 
     for (int y = 10; y < 16; y++)
-        game->map->data[y][12] = CELL_WALL;
+        MAP_AT(game->map, 12, y) = CELL_WALL;
     for (int y = 10; y < 16; y++)
-        game->map->data[y][14] = CELL_WALL;
+        MAP_AT(game->map, 14, y) = CELL_WALL;
 
-    game->map->data[8][12] = CELL_FLOOR;
-    game->map->data[8][14] = CELL_FLOOR;
+    MAP_AT(game->map, 12, 8) = CELL_FLOOR;
+    MAP_AT(game->map, 14, 8) = CELL_FLOOR;
 
     spawn_detector(game, ivec2(13, 2), DIR_DOWN, PHASE_RED);
     spawn_detector(game, ivec2(13, 15), DIR_UP, PHASE_BLUE);
@@ -1671,8 +1603,8 @@ void load_level_18(GameState *game) {
     spawn_guard(game, ivec2(18, 5));
 
     game->exit_position = ivec2(13, 17);
-    game->map->data[17][13] = CELL_EXIT;
-    game->map->data[16][13] = CELL_DOOR;
+    MAP_AT(game->map, 13, 17) = CELL_EXIT;
+    MAP_AT(game->map, 13, 16) = CELL_DOOR;
     game->player.position = ivec2(13, 9);
 }
 
@@ -1687,9 +1619,9 @@ void load_level_19(GameState *game) {
     /* Complex architecture */
     for (int x = 0; x < cols; x++) {
         if (x % 4 == 0)
-            game->map->data[6][x] = CELL_WALL_RED;
+            MAP_AT(game->map, x, 6) = CELL_WALL_RED;
         if (x % 4 == 2)
-            game->map->data[12][x] = CELL_WALL_BLUE;
+            MAP_AT(game->map, x, 12) = CELL_WALL_BLUE;
     }
 
     /* RE-REDESIGN: 2 Buttons (Player + Echo) but HARDER */
@@ -1717,16 +1649,16 @@ void load_level_19(GameState *game) {
     spawn_guard(game, ivec2(15, 14));
 
     /* Final gate: Button Barricade -> Key Door -> Exit */
-    game->map->data[rows / 2][cols - 2] = CELL_DOOR; // Needs Blue Key
+    MAP_AT(game->map, cols - 2, rows / 2) = CELL_DOOR; // Needs Blue Key
     for (int y = 0; y < rows; y++) {
         if (y != rows / 2)
-            game->map->data[y][cols - 4] = CELL_BARRICADE; // Outer ring
+            MAP_AT(game->map, cols - 4, y) = CELL_BARRICADE; // Outer ring
     }
 
-    game->map->data[rows / 2][cols - 4] = CELL_BARRICADE;
+    MAP_AT(game->map, cols - 4, rows / 2) = CELL_BARRICADE;
 
     game->exit_position = ivec2(cols - 1, rows / 2);
-    game->map->data[rows / 2][cols - 1] = CELL_EXIT;
+    MAP_AT(game->map, cols - 1, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
     game->player.bombs = 2;
@@ -1745,28 +1677,28 @@ void load_level_20(GameState *game) {
     for (int x = 4; x < 12; x++) {
         for (int y = 2; y < rows - 2; y += 2) {
             if ((x + y) % 2 == 0)
-                game->map->data[y][x] = CELL_WALL_RED;
+                MAP_AT(game->map, x, y) = CELL_WALL_RED;
             else
-                game->map->data[y][x] = CELL_WALL_BLUE;
+                MAP_AT(game->map, x, y) = CELL_WALL_BLUE;
         }
     }
 
     /* SECTION 2: The Void (Islands & Tunnels) */
     /* Wall separating Sec 1 & 2 */
     for (int y = 0; y < rows; y++)
-        game->map->data[y][12] = CELL_WALL;
+        MAP_AT(game->map, 12, y) = CELL_WALL;
 
-    game->map->data[rows / 2][12] =
+    MAP_AT(game->map, 12, rows / 2) =
         CELL_DOOR; // Door 1 (Mandatory to enter Void)
 
     /* Island 2 (Central) - STRICTLY ENCLOSED */
     for (int x = 16; x < 24; x++) {
         for (int y = 4; y < rows - 4; y++) {
             if (x == 16 || x == 23 || y == 4 || y == rows - 5)
-                game->map->data[y][x] =
+                MAP_AT(game->map, x, y) =
                     CELL_WALL; // Solid walls around Island 2
             else
-                game->map->data[y][x] = CELL_FLOOR;
+                MAP_AT(game->map, x, y) = CELL_FLOOR;
         }
     }
 
@@ -1777,34 +1709,34 @@ void load_level_20(GameState *game) {
     /* SECTION 3: The Collapse (Final Gauntlet) */
     /* Wall separating Sec 2 & 3 - SOLID (Forces Portal) */
     for (int y = 0; y < rows; y++)
-        game->map->data[y][24] = CELL_WALL;
+        MAP_AT(game->map, 24, y) = CELL_WALL;
 
     /* Walls inside Sec 3 to force pathing (Top vs Bottom) */
     for (int x = 24; x < cols; x++) {
-        game->map->data[12][x] = CELL_WALL; // Split Sec 3 into Top/Bottom
+        MAP_AT(game->map, x, 12) = CELL_WALL; // Split Sec 3 into Top/Bottom
     }
 
     // Door connecting Top Sec 3 to Bottom Sec 3 (Requires Key 2)
-    game->map->data[12][26] = CELL_DOOR;
+    MAP_AT(game->map, 26, 12) = CELL_DOOR;
 
     // Final Door blocking Exit (Requires Key 3)
-    // game->map->data[12][30] = CELL_DOOR; // OLD
-    game->map->data[12][30] = CELL_WALL; // Blocked
+    // MAP_AT(game->map, 30, 12) = CELL_DOOR; // OLD
+    MAP_AT(game->map, 30, 12) = CELL_WALL; // Blocked
 
     // Make Exit accessible behind Final Door
-    // game->map->data[12][31] = CELL_EXIT; // OLD
-    game->map->data[12][31] = CELL_WALL; // Blocked
+    // MAP_AT(game->map, 31, 12) = CELL_EXIT; // OLD
+    MAP_AT(game->map, 31, 12) = CELL_WALL; // Blocked
     // game->exit_position = ivec2(31, 12); // OLD
 
     // NEW EXIT: Bottom Row Vertical (29, 23)
     // Approach from Top
-    game->map->data[21][29] = CELL_FLOOR;
-    game->map->data[22][29] = CELL_DOOR; // Final Door
-    game->map->data[23][29] = CELL_EXIT; // Exit (Overwrites bottom wall)
+    MAP_AT(game->map, 29, 21) = CELL_FLOOR;
+    MAP_AT(game->map, 29, 22) = CELL_DOOR; // Final Door
+    MAP_AT(game->map, 29, 23) = CELL_EXIT; // Exit (Overwrites bottom wall)
     game->exit_position = ivec2(29, 23);
 
     // Clean up previous attempt pos
-    game->map->data[22][30] = CELL_FLOOR; // Just floor next to it
+    MAP_AT(game->map, 30, 22) = CELL_FLOOR; // Just floor next to it
 
     /* Portals: Island 2 -> Sec 3 */
     // Portal 0 (Source) links to 1.
@@ -1843,7 +1775,7 @@ void load_level_20(GameState *game) {
 
     /* EXIT is set above */
     // game->exit_position = ivec2(cols - 1, rows / 2);
-    // game->map->data[rows / 2][cols - 1] = CELL_EXIT;
+    // MAP_AT(game->map, cols - 1, rows / 2) = CELL_EXIT;
 
     game->player.position = ivec2(2, rows / 2);
     game->player.bombs = 3;
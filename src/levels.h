@@ -2,9 +2,19 @@
 #define LEVELS_H
 
 #include "common.h"
+#include "level_file.h"
 #include "logic.h"
 
+// Huella de este código (cksum de src/levels.c, la pasa el Makefile con
+// -DLEVEL_SOURCE_HASH). 0 si se compiló sin ella: entonces no se comprueba
+extern const uint32_t level_source_hash;
+
 void load_level(GameState *game, int level_index);
+// Construye el nivel con el código C (load_level_N), sin mirar los .psl
+void build_level(GameState *game, int level_index);
+// Aplica los cambios del .psl del nivel en juego respecto a `applied` (que
+// pasa a ser la versión nueva). Ver level_watch.h
+bool reload_level_in_place(GameState *game, LevelFileSnapshot *applied);
 
 void load_level_1(GameState *game);
 void load_level_2(GameState *game);
@@ -30,6 +40,7 @@ void init_encyclopedia(GameState *game);
 
 void init_intro_dialogs(GameState *game);
 void show_level_dialog(GameState *game);
+void build_level_triggers(GameState *game);
 void check_level_events(GameState *game);
 
 #endif
\ No newline at end of file
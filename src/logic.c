@@ -1,22 +1,12 @@
 #include "logic.h"
 #include "levels.h"
+#include "events.h"
 #include "qiskit.h"
 #include "quantum.h"
-#include "render.h"
 #include <string.h>
 
 /* ===== SPAWNING ===== */
 
-static void spawn_spark_effect(GameState *game, IVector2 pos, Color col) {
-    Vector2 center = {pos.x * CELL_SIZE + CELL_SIZE / 2.0f,
-                      pos.y * CELL_SIZE + CELL_SIZE / 2.0f};
-    for (int i = 0; i < 10; i++) {
-        Vector2 vel = {(float)(rand() % 200 - 100),
-                       (float)(rand() % 200 - 100)};
-        spawn_particle(game, center, vel, col, 4.0f, 0.5f);
-    }
-}
-
 void spawn_guard(GameState *game, IVector2 pos) {
     for (int i = 0; i < MAX_COLAPSORES; i++) {
         if (game->colapsores[i].dead) {
@@ -31,6 +21,7 @@ void spawn_guard(GameState *game, IVector2 pos) {
             game->colapsores[i].eyes_target = ivec2_add(pos, ivec2(1, 3));
             game->colapsores[i].health = 1.0f;
             game->colapsores[i].attack_cooldown = GUARD_ATTACK_COOLDOWN;
+            colapsor_occupy(game, i);
             return;
         }
     }
@@ -49,22 +40,43 @@ void spawn_gnome(GameState *game, IVector2 pos) {
             game->colapsores[i].eyes_angle = M_PI * 0.5f;
             game->colapsores[i].eyes_target = ivec2_add(pos, ivec2(0, 1));
             game->colapsores[i].health = 1.0f;
+            colapsor_occupy(game, i);
             return;
         }
     }
 }
 
+/* Clave Zobrist de un objeto: hueco, casilla y tipo */
+static uint64_t item_key(GameState *game, int item_idx) {
+    const Item *item = &game->items[item_idx];
+    uint64_t cell = (uint64_t)item->position.y * game->map->cols +
+                    (uint64_t)item->position.x;
+    return zobrist_key((uint64_t)item_idx << 32 | cell, item->kind);
+}
+
 void allocate_item(GameState *game, IVector2 pos, ItemKind kind) {
     for (int i = 0; i < MAX_ITEMS; i++) {
         if (game->items[i].kind == ITEM_NONE) {
             game->items[i].kind = kind;
             game->items[i].position = pos;
             game->items[i].cooldown = 0;
+            game->item_hash ^= item_key(game, i);
+            entity_index_insert(game, ENTITY_REF(ENTITY_ITEM, i), pos);
             return;
         }
     }
 }
 
+void despawn_item(GameState *game, int item_idx) {
+    Item *item = &game->items[item_idx];
+    if (item->kind == ITEM_NONE)
+        return;
+    entity_index_remove(game, ENTITY_REF(ENTITY_ITEM, item_idx),
+                        item->position);
+    game->item_hash ^= item_key(game, item_idx);
+    item->kind = ITEM_NONE;
+}
+
 void spawn_detector(GameState *game, IVector2 pos, Direction dir,
                     PhaseKind phase) {
     for (int i = 0; i < MAX_DETECTORS; i++) {
@@ -76,6 +88,8 @@ void spawn_detector(GameState *game, IVector2 pos, Direction dir,
             game->detectors[i].view_distance = 5;
             game->detectors[i].current_length = 0;
             game->detectors[i].beam_alpha = 0.0f;
+            game->detectors[i].beam_generation = 0;
+            game->beam_generation++;
             return;
         }
     }
@@ -104,6 +118,7 @@ void spawn_button(GameState *game, IVector2 pos, PhaseKind phase) {
             game->buttons[i].position = pos;
             game->buttons[i].phase = phase;
             game->buttons[i].is_pressed = false;
+            entity_index_insert(game, ENTITY_REF(ENTITY_BUTTON, i), pos);
             return;
         }
     }
@@ -119,6 +134,7 @@ void spawn_portal(GameState *game, IVector2 pos, int linked_idx,
             game->portals[i].phase = phase;
             game->portals[i].glow_intensity = 1.0f;
             game->portals[i].requires_entanglement = false;
+            entity_index_insert(game, ENTITY_REF(ENTITY_PORTAL, i), pos);
             return;
         }
     }
@@ -132,6 +148,8 @@ void spawn_oracle(GameState *game, IVector2 pos, PhaseKind phase, bool marked) {
             game->oracles[i].marked_phase = phase;
             game->oracles[i].is_marked_state = marked;
             game->oracles[i].query_count = 0;
+            entity_index_insert(game, ENTITY_REF(ENTITY_ORACLE, i), pos);
+            game->beam_generation++; // Los rayos marcan dónde hay oráculos
             return;
         }
     }
@@ -142,9 +160,9 @@ void make_room(GameState *game) {
         for (int x = 0; x < game->map->cols; x++) {
             if (x == 0 || x == game->map->cols - 1 || y == 0 ||
                 y == game->map->rows - 1) {
-                game->map->data[y][x] = CELL_WALL;
+                MAP_AT(game->map, x, y) = CELL_WALL;
             } else {
-                game->map->data[y][x] = CELL_FLOOR;
+                MAP_AT(game->map, x, y) = CELL_FLOOR;
             }
         }
     }
@@ -152,49 +170,114 @@ void make_room(GameState *game) {
 
 /* ===== QUEUE & HELPERS ===== */
 
+/* Cola circular sobre el scratch del nivel (game->bfs_queue). Cada BFS
+ * encola cada casilla como mucho una vez, así que rows*cols huecos bastan y
+ * ni push ni pop reservan memoria. */
 typedef struct {
     IVector2 *items;
+    int head;
     int size;
     int capacity;
 } Queue;
 
-static void queue_init(Queue *q) {
-    q->capacity = 256;
+static void queue_init(Queue *q, GameState *game) {
+    q->items = game->bfs_queue;
+    q->head = 0;
     q->size = 0;
-    q->items = malloc(q->capacity * sizeof(IVector2));
+    q->capacity = game->bfs_capacity;
 }
 
-static void queue_push(Queue *q, IVector2 item) {
-    if (q->size >= q->capacity) {
-        q->capacity *= 2;
-        q->items = realloc(q->items, q->capacity * sizeof(IVector2));
-    }
-    q->items[q->size++] = item;
+static bool queue_push(Queue *q, IVector2 item) {
+    if (q->size >= q->capacity)
+        return false;
+    int tail = q->head + q->size;
+    if (tail >= q->capacity)
+        tail -= q->capacity;
+    q->items[tail] = item;
+    q->size++;
+    return true;
 }
 
 static IVector2 queue_pop(Queue *q) {
-    IVector2 result = q->items[0];
+    IVector2 result = q->items[q->head];
+    if (++q->head == q->capacity)
+        q->head = 0;
     q->size--;
-    for (int i = 0; i < q->size; i++) {
-        q->items[i] = q->items[i + 1];
-    }
     return result;
 }
 
-static void queue_free(Queue *q) { free(q->items); }
+/* ===== CAMPOS DE DISTANCIA ===== */
+
+/* Marca en passability.footprint las esquinas en las que una huella de
+ * size cabe sobre el terreno: AND de ventanas desplazadas del tablero
+ * walkable, 64 columnas por operación. Los demás colapsores no cuentan aquí
+ * (cambian durante el turno); ver colapsor_path_field. */
+static void build_footprint_board(GameState *game, IVector2 size) {
+    const PassabilityBoards *boards = &game->passability;
+    int rows = game->map->rows, words = boards->words;
+
+    for (int y = 0; y < rows; y++) {
+        uint64_t *out = boards->footprint + (size_t)y * words;
+        out[words - 1] = 0;
+        for (int w = 0; w < words - 1; w++) {
+            uint64_t fits = y + size.y <= rows ? ~(uint64_t)0 : 0;
+            for (int dy = 0; dy < size.y && fits; dy++) {
+                const uint64_t *row =
+                    boards->walkable + (size_t)(y + dy) * words;
+                for (int dx = 0; dx < size.x; dx++)
+                    fits &= board_window(row, w * 64 + dx);
+            }
+            out[w] = fits;
+        }
+    }
+}
 
-void recompute_path_for_colapsor(GameState *game, int colapsor_idx) {
-    ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+/* Con colapsor_idx < 0 sólo cuenta el terreno (la huella de field->size);
+ * si no, las reglas de colapsor_can_stand_here para ese colapsor */
+static bool footprint_fits(GameState *game, IVector2 start,
+                           int colapsor_idx) {
+    if (colapsor_idx >= 0)
+        return colapsor_can_stand_here(game, start, colapsor_idx);
+    if (start.x < 0 || start.y < 0 || start.x >= game->map->cols ||
+        start.y >= game->map->rows)
+        return false;
+    return BOARD_BIT(game->passability.footprint, game->passability.words,
+                     start.x, start.y);
+}
+
+/* BFS desde todas las posiciones en las que la huella cubre al jugador.
+ * Un movimiento es un deslizamiento en línea recta de hasta 100 casillas,
+ * y la búsqueda se corta a DISTANCE_FIELD_MAX_DIST movimientos.
+ * Con colapsor_idx >= 0 es la búsqueda de ese colapsor: los demás son
+ * obstáculos y se para al sacar de la cola su posición. */
+static void compute_distance_field(GameState *game, DistanceField *field,
+                                   int colapsor_idx) {
+    int cols = game->map->cols;
+    uint16_t *cells = field->cells;
+    IVector2 size = field->size;
+    uint32_t pushed = 0, popped = 0;
     Queue q;
-    queue_init(&q);
+    queue_init(&q, game);
 
-    path_reset(colapsor->path, colapsor->path_rows, colapsor->path_cols);
+    /* Nueva generación en vez de reescribir la rejilla; sólo al dar la
+     * vuelta el contador hay que ponerla a 0 */
+    if (field->generation >= DISTANCE_FIELD_MAX_GENERATION) {
+        memset(cells, 0, (size_t)game->map->rows * cols * sizeof(uint16_t));
+        field->generation = 0;
+    }
+    uint16_t stamp =
+        (uint16_t)(++field->generation << DISTANCE_FIELD_DIST_BITS);
+    if (colapsor_idx < 0)
+        build_footprint_board(game, size);
 
-    for (int dy = 0; dy < colapsor->size.y; dy++) {
-        for (int dx = 0; dx < colapsor->size.x; dx++) {
+    for (int dy = 0; dy < size.y; dy++) {
+        for (int dx = 0; dx < size.x; dx++) {
             IVector2 pos = ivec2_sub(game->player.position, ivec2(dx, dy));
-            if (colapsor_can_stand_here(game, pos, colapsor_idx)) {
-                colapsor->path[pos.y][pos.x] = 0;
+            if (footprint_fits(game, pos, colapsor_idx)) {
+                int index = pos.y * cols + pos.x;
+                cells[index] = stamp;
+                field->order[index] = pushed++;
+                field->pushed_by[index] = 0;
                 queue_push(&q, pos);
             }
         }
@@ -202,12 +285,15 @@ void recompute_path_for_colapsor(GameState *game, int colapsor_idx) {
 
     while (q.size > 0) {
         IVector2 pos = queue_pop(&q);
+        int d = distance_field_at(field, pos.y * cols + pos.x);
+        popped++;
 
-        if (ivec2_eq(pos, colapsor->position)) {
+        if (colapsor_idx >= 0 &&
+            ivec2_eq(pos, game->colapsores[colapsor_idx].position)) {
             break;
         }
 
-        if (colapsor->path[pos.y][pos.x] >= 10) {
+        if (d >= DISTANCE_FIELD_MAX_DIST) {
             break;
         }
 
@@ -215,40 +301,158 @@ void recompute_path_for_colapsor(GameState *game, int colapsor_idx) {
             IVector2 new_pos = ivec2_add(pos, DIRECTION_VECTORS[dir]);
 
             for (int step = 1; step <= 100; step++) {
-                if (!colapsor_can_stand_here(game, new_pos, colapsor_idx))
+                if (!footprint_fits(game, new_pos, colapsor_idx))
                     break;
-                if (colapsor->path[new_pos.y][new_pos.x] >= 0)
+                int index = new_pos.y * cols + new_pos.x;
+                if (distance_field_at(field, index) >= 0)
                     break;
 
-                colapsor->path[new_pos.y][new_pos.x] =
-                    colapsor->path[pos.y][pos.x] + 1;
+                cells[index] = stamp | (uint16_t)(d + 1);
+                field->order[index] = pushed++;
+                field->pushed_by[index] = popped;
                 queue_push(&q, new_pos);
 
                 new_pos = ivec2_add(new_pos, DIRECTION_VECTORS[dir]);
             }
         }
     }
+    field->valid = true;
+}
+
+void invalidate_distance_fields(GameState *game) {
+    for (int i = 0; i < MAX_DISTANCE_FIELDS; i++)
+        game->distance_fields[i].valid = false;
+}
+
+int distance_field_at(const DistanceField *field, int index) {
+    uint16_t cell = field->cells[index];
+    if ((cell >> DISTANCE_FIELD_DIST_BITS) != field->generation)
+        return -1;
+    return cell & ((1u << DISTANCE_FIELD_DIST_BITS) - 1);
+}
+
+/* La casilla que encoló a index salió de la cola antes que stop_index */
+bool distance_field_reached_before(const DistanceField *field, int index,
+                                   int stop_index) {
+    return distance_field_at(field, index) >= 0 &&
+           field->pushed_by[index] <= field->order[stop_index];
+}
+
+/* Primer uso desde que se cargó un mapa de este tamaño: niveles sin
+ * colapsores no reservan ni limpian rejillas, y al reiniciar el nivel se
+ * siguen usando las mismas (init_game_state) */
+static bool distance_field_reserve(GameState *game, DistanceField *field) {
+    if (field->cells)
+        return true;
+    size_t cells = (size_t)game->map->rows * game->map->cols;
+    field->cells = arena_alloc(&game->level_arena, cells * sizeof(uint16_t),
+                               ARENA_ALIGNMENT);
+    field->order = arena_alloc(&game->level_arena, cells * sizeof(uint32_t),
+                               ARENA_ALIGNMENT);
+    field->pushed_by = arena_alloc(&game->level_arena,
+                                   cells * sizeof(uint32_t), ARENA_ALIGNMENT);
+    if (!field->cells || !field->order || !field->pushed_by) {
+        field->cells = NULL;
+        return false;
+    }
+    memset(field->cells, 0, cells * sizeof(uint16_t));
+    field->generation = 0;
+    return true;
+}
+
+const DistanceField *colapsor_distance_field(GameState *game, IVector2 size) {
+    DistanceField *slot = NULL;
+    for (int i = 0; i < MAX_DISTANCE_FIELDS; i++) {
+        DistanceField *field = &game->distance_fields[i];
+        if (field->valid && field->size.x == size.x &&
+            field->size.y == size.y)
+            return field;
+        if (!field->valid && !slot)
+            slot = field;
+    }
+    /* Más huellas distintas que huecos: se recicla el último */
+    if (!slot)
+        slot = &game->distance_fields[MAX_DISTANCE_FIELDS - 1];
+    if (!distance_field_reserve(game, slot))
+        return NULL;
+
+    slot->size = size;
+    compute_distance_field(game, slot, -1);
+    return slot;
+}
+
+/* Algún otro colapsor vivo tapa una posición del campo a distancia <=
+ * dist + 1. Hasta sacar de la cola la posición del colapsor (a distancia
+ * dist) el BFS no pasa de dist + 1, así que si no hay ninguna tapada su
+ * búsqueda propia habría hecho lo mismo que la del terreno */
+static bool colapsor_path_blocked(GameState *game, const DistanceField *field,
+                                  int colapsor_idx, int dist) {
+    const ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    int cols = game->map->cols, rows = game->map->rows;
+
+    for (int i = 0; i < MAX_COLAPSORES; i++) {
+        const ColapsarState *other = &game->colapsores[i];
+        if (i == colapsor_idx || other->dead)
+            continue;
+        /* Esquinas en las que la huella pisaría la del otro */
+        int x0 = other->position.x - colapsor->size.x + 1;
+        int y0 = other->position.y - colapsor->size.y + 1;
+        int x1 = other->position.x + other->size.x - 1;
+        int y1 = other->position.y + other->size.y - 1;
+        for (int y = y0 < 0 ? 0 : y0; y <= y1 && y < rows; y++) {
+            for (int x = x0 < 0 ? 0 : x0; x <= x1 && x < cols; x++) {
+                int d = distance_field_at(field, y * cols + x);
+                if (d >= 0 && d <= dist + 1)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
 
-    queue_free(&q);
+const DistanceField *colapsor_path_field(GameState *game, int colapsor_idx) {
+    ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    const DistanceField *shared = colapsor_distance_field(game, colapsor->size);
+    if (!shared)
+        return NULL;
+
+    int dist = distance_field_at(shared, colapsor->position.y * game->map->cols +
+                                             colapsor->position.x);
+    if (dist < 0 || !colapsor_path_blocked(game, shared, colapsor_idx, dist))
+        return shared;
+
+    DistanceField *own = &game->colapsor_field;
+    if (!distance_field_reserve(game, own))
+        return NULL;
+    own->size = colapsor->size;
+    compute_distance_field(game, own, colapsor_idx);
+    return own;
 }
 
 void kill_player(GameState *game) {
     game->player.dead = true;
-    game->player.death_time = GetTime();
     game->screen_shake = 2.0f;
     game->flash_intensity = 1.0f;
-    PlayAudioSound(blast_sound);
+    emit_sound(game, SOUND_BLAST);
+
+    GameEvent died = {0};
+    died.kind = EVENT_PLAYER_DIED;
+    emit_event(game, &died);
 }
 
 void flood_fill(GameState *game, IVector2 start, Cell fill) {
     if (!within_map(game, start))
         return;
 
-    Cell background = game->map->data[start.y][start.x];
-    game->map->data[start.y][start.x] = fill;
+    Cell background = MAP_AT(game->map, start.x, start.y);
+    if (background == fill)
+        return; // Nada que rellenar (y la BFS no terminaría)
+    if (background == CELL_WALL)
+        return; // Se saldría por el borde centinela
+    map_set_cell(game, start, fill);
 
     Queue q;
-    queue_init(&q);
+    queue_init(&q, game);
     queue_push(&q, start);
 
     while (q.size > 0) {
@@ -257,28 +461,25 @@ void flood_fill(GameState *game, IVector2 start, Cell fill) {
         for (int dir = 0; dir < 4; dir++) {
             IVector2 new_pos = ivec2_add(pos, DIRECTION_VECTORS[dir]);
 
-            if (within_map(game, new_pos) &&
-                game->map->data[new_pos.y][new_pos.x] == background) {
-                game->map->data[new_pos.y][new_pos.x] = fill;
+            /* El borde centinela es pared: nunca coincide con background */
+            if (MAP_AT(game->map, new_pos.x, new_pos.y) == background) {
+                map_set_cell(game, new_pos, fill);
                 queue_push(&q, new_pos);
             }
         }
     }
-
-    queue_free(&q);
 }
 
 void explode_line(GameState *game, IVector2 position, Direction dir) {
     IVector2 new_pos = position;
 
+    /* Sin within_map: la línea se corta en la primera casilla que no es
+     * suelo, como muy tarde en el borde centinela */
     for (int i = 0; i < EXPLOSION_LENGTH; i++) {
-        if (!within_map(game, new_pos))
-            return;
-
-        Cell cell = game->map->data[new_pos.y][new_pos.x];
+        Cell cell = MAP_AT(game->map, new_pos.x, new_pos.y);
 
         if (cell == CELL_FLOOR || cell == CELL_EXPLOSION) {
-            game->map->data[new_pos.y][new_pos.x] = CELL_EXPLOSION;
+            map_set_cell(game, new_pos, CELL_EXPLOSION);
 
             if (ivec2_eq(new_pos, game->player.position)) {
                 game->player.deaths++;
@@ -296,7 +497,7 @@ void explode_line(GameState *game, IVector2 position, Direction dir) {
             new_pos = ivec2_add(new_pos, DIRECTION_VECTORS[dir]);
         } else if (cell == CELL_BARRICADE) {
             flood_fill(game, new_pos, CELL_EXPLOSION);
-            game->map->data[new_pos.y][new_pos.x] = CELL_EXPLOSION;
+            map_set_cell(game, new_pos, CELL_EXPLOSION);
             return;
         } else {
             return;
@@ -376,7 +577,7 @@ void handle_phase_change(GameState *game) {
 
     phase->current_phase = next;
     game->player.phase_shifts++;
-    PlayAudioSound(phase_shift_sound);
+    emit_sound(game, SOUND_PHASE_SHIFT);
 }
 
 void handle_superposition(GameState *game) {
@@ -408,7 +609,7 @@ void handle_superposition(GameState *game) {
 void update_coherence(GameState *game) {
     CoherenceSystem *coh = &game->player.coherence;
     Cell cell =
-        game->map->data[game->player.position.y][game->player.position.x];
+        MAP_AT(game->map, game->player.position.x, game->player.position.y);
 
     // Base decay
     coh->decay_counter++;
@@ -417,14 +618,11 @@ void update_coherence(GameState *game) {
         coh->decay_counter = 0;
     }
 
-    game->player.level_time += GetFrameTime();
-
     // Decoherence Zone: Rapid decay
     if (cell == CELL_DECOHERENCE_ZONE) {
         coh->current -= 2.0f; // Extra penalty per turn
-        if (IsAudioSoundValid(decoherence_sound) &&
-            ((int)coh->current % 10 == 0)) {
-            PlayAudioSound(decoherence_sound);
+        if ((int)coh->current % 10 == 0) {
+            emit_sound(game, SOUND_DECOHERENCE);
         }
     }
 
@@ -434,7 +632,7 @@ void update_coherence(GameState *game) {
             game->player.phase_system.state = PHASE_STATE_STABLE;
             game->player.phase_system.superposition_turns_left = 0;
             game->player.measurements_made++;
-            PlayAudioSound(measurement_sound);
+            emit_sound(game, SOUND_MEASUREMENT);
             // Collapse to... random? Or current?
             // Superposition usually means we are in both.
             // Let's say we collapse to the phase we initiated it from, or
@@ -493,67 +691,141 @@ void update_quantum_echos(GameState *game) {
     }
 }
 
-void update_quantum_detectors(GameState *game) {
-    PlayerState *player = &game->player;
+/* ===== DETECTORES ===== */
+
+static Direction mirror_reflect(Direction dir) {
+    switch (dir) {
+    case DIR_RIGHT:
+        return DIR_DOWN;
+    case DIR_DOWN:
+        return DIR_LEFT;
+    case DIR_LEFT:
+        return DIR_UP;
+    case DIR_UP:
+        return DIR_RIGHT;
+    default:
+        return dir;
+    }
+}
+
+/* Recorre el rayo completo, como si nadie lo cortara, y guarda sus
+ * casillas. User Request: Lasers penetrate walls (sólo los espejos y el
+ * borde del mapa cambian el recorrido). */
+static void detector_trace_beam(GameState *game, QuantumDetector *det) {
+    IVector2 ray_pos = det->position;
+    Direction current_dir = det->direction;
+    int max_length = det->view_distance < MAX_BEAM_LENGTH
+                         ? det->view_distance
+                         : MAX_BEAM_LENGTH;
+
+    det->beam_length = 0;
+    det->beam_mirrors = 0;
+    det->beam_oracles = 0;
+    for (int step = 0; step < max_length; step++) {
+        ray_pos = ivec2_add(ray_pos, DIRECTION_VECTORS[current_dir]);
+        if (!within_map(game, ray_pos))
+            break;
+
+        det->beam_cells[step] = ray_pos;
+        det->beam_length = step + 1;
+        for (EntityRef ref = entity_index_at(game, ray_pos); ref;
+             ref = entity_index_next(game, ref)) {
+            if (ENTITY_REF_KIND(ref) == ENTITY_ORACLE)
+                det->beam_oracles |= 1u << step;
+        }
+        if (MAP_AT(game->map, ray_pos.x, ray_pos.y) == CELL_MIRROR) {
+            det->beam_mirrors |= 1u << step;
+            current_dir = mirror_reflect(current_dir);
+        }
+    }
+    det->beam_generation = game->beam_generation;
+}
+
+/* Vuelve a trazar los rayos y la cobertura por fase sólo si cambió algún
+ * espejo, detector u oráculo desde la última vez */
+static void refresh_detector_beams(GameState *game) {
+    if (game->beam_coverage_generation == game->beam_generation)
+        return;
+
+    int words = game->passability.words;
+    size_t bytes = (size_t)game->map->rows * words * sizeof(uint64_t);
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        memset(game->beam_coverage[phase], 0, bytes);
 
     for (int i = 0; i < MAX_DETECTORS; i++) {
         QuantumDetector *det = &game->detectors[i];
         if (!det->is_active)
             continue;
+        if (det->beam_generation != game->beam_generation)
+            detector_trace_beam(game, det);
+        uint64_t *coverage = game->beam_coverage[det->detects_phase];
+        for (int s = 0; s < det->beam_length; s++) {
+            IVector2 cell = det->beam_cells[s];
+            coverage[(size_t)cell.y * words + (cell.x >> 6)] |=
+                (uint64_t)1 << (cell.x & 63);
+        }
+    }
+    game->beam_coverage_generation = game->beam_generation;
+}
 
-        IVector2 ray_pos = det->position;
-        bool detected = false;
-        Direction current_dir = det->direction;
-        det->current_length = 0; // Reiniciar longitud cada frame
+static void detector_query_oracles(GameState *game, QuantumDetector *det,
+                                   IVector2 pos) {
+    for (EntityRef ref = entity_index_at(game, pos); ref;
+         ref = entity_index_next(game, ref)) {
+        if (ENTITY_REF_KIND(ref) != ENTITY_ORACLE)
+            continue;
+        GroverOracle *oracle = &game->oracles[ENTITY_REF_INDEX(ref)];
+        if (oracle->marked_phase == det->detects_phase) {
+            if (!oracle->active) {
+                oracle->active = true;
+                oracle->query_count++;
+                emit_sound(game, SOUND_ORACLE);
+            }
+        }
+    }
+}
 
-        for (int dist = 1; dist <= det->view_distance; dist++) {
-            ray_pos = ivec2_add(ray_pos, DIRECTION_VECTORS[current_dir]);
+void update_quantum_detectors(GameState *game) {
+    PlayerState *player = &game->player;
+    int words = game->passability.words;
+    IVector2 player_pos = player->position;
+    bool player_in_map = within_map(game, player_pos);
 
-            if (!within_map(game, ray_pos))
-                break;
+    refresh_detector_beams(game);
 
-            det->current_length = dist;
-
-            // Comprobar interacción con Oráculo
-            for (int o = 0; o < MAX_ORACLES; o++) {
-                GroverOracle *oracle = &game->oracles[o];
-                if (ivec2_eq(oracle->position, ray_pos)) {
-                    if (oracle->marked_phase == det->detects_phase) {
-                        if (!oracle->active) {
-                            oracle->active = true;
-                            oracle->query_count++;
-                            if (IsAudioSoundValid(oracle_sound))
-                                PlayAudioSound(oracle_sound);
-                        }
-                    }
-                }
-            }
+    for (int i = 0; i < MAX_DETECTORS; i++) {
+        QuantumDetector *det = &game->detectors[i];
+        if (!det->is_active)
+            continue;
 
-            if (ivec2_eq(ray_pos, player->position)) {
-                if (player->phase_system.current_phase == det->detects_phase ||
-                    player->phase_system.state == PHASE_STATE_SUPERPOSITION) {
-                    detected = true;
+        /* El rayo se corta en el jugador si es de su fase: un bit de la
+         * cobertura descarta casi siempre tener que buscarlo en el rayo */
+        int detected_at = -1;
+        if (player_in_map &&
+            (player->phase_system.current_phase == det->detects_phase ||
+             player->phase_system.state == PHASE_STATE_SUPERPOSITION) &&
+            BOARD_BIT(game->beam_coverage[det->detects_phase], words,
+                      player_pos.x, player_pos.y)) {
+            for (int s = 0; s < det->beam_length; s++) {
+                if (ivec2_eq(det->beam_cells[s], player_pos)) {
+                    detected_at = s;
                     break;
                 }
             }
-
-            Cell cell = game->map->data[ray_pos.y][ray_pos.x];
-            if (cell == CELL_MIRROR) {
-                if (current_dir == DIR_RIGHT)
-                    current_dir = DIR_DOWN;
-                else if (current_dir == DIR_DOWN)
-                    current_dir = DIR_LEFT;
-                else if (current_dir == DIR_LEFT)
-                    current_dir = DIR_UP;
-                else if (current_dir == DIR_UP)
-                    current_dir = DIR_RIGHT;
-
-                if (IsAudioSoundValid(mirror_reflect_sound))
-                    PlayAudioSound(mirror_reflect_sound);
-            }
-            // User Request: Lasers penetrate walls.
-            // Removed CELL_WALL checks.
-            // else if (cell == CELL_WALL || ...) { break; }
+        }
+        bool detected = detected_at >= 0;
+        det->current_length = detected ? detected_at + 1 : det->beam_length;
+
+        /* Efectos en el orden en que el rayo recorre sus casillas: oráculos
+         * hasta el jugador incluido, reflejos sólo mientras el rayo sigue */
+        uint32_t pending = det->beam_oracles | det->beam_mirrors;
+        for (int s = 0; s < det->current_length && pending; s++) {
+            uint32_t bit = 1u << s;
+            pending &= ~bit;
+            if (det->beam_oracles & bit)
+                detector_query_oracles(game, det, det->beam_cells[s]);
+            if ((det->beam_mirrors & bit) && s != detected_at)
+                emit_sound(game, SOUND_MIRROR_REFLECT);
         }
 
         if (detected) {
@@ -561,7 +833,7 @@ void update_quantum_detectors(GameState *game) {
             player->phase_system.state = PHASE_STATE_STABLE;
             player->phase_system.phase_lock_turns = 5;
             player->coherence.current -= 40.0f;
-            PlayAudioSound(blast_sound);
+            emit_sound(game, SOUND_BLAST);
 
             det->beam_alpha = 1.0f;
         } else {
@@ -570,7 +842,30 @@ void update_quantum_detectors(GameState *game) {
     }
 }
 
-bool attempt_quantum_tunnel(GameState *game, int tunnel_idx) {
+static float quantum_tunnel_chance(GameState *game,
+                                   const QuantumTunnel *tunnel) {
+    float success_chance = tunnel->success_probability;
+
+    /* Dev Fix: Increase base success rate to avoid frustration */
+    if (success_chance < 0.9f) {
+        success_chance = 0.95f;
+    }
+
+    for (int i = 0; i < MAX_ITEMS; i++) {
+        if (game->items[i].kind == ITEM_STABILIZER) {
+            success_chance = 1.0f; /* Stabilizer guarantees tunnel */
+            break;
+        }
+    }
+    return success_chance;
+}
+
+/* `ticket` es la medida pedida por adelantado (prefetch_tunnel_measure) o
+ * NULL. Sólo se usa si su probabilidad coincide con la de este túnel; si
+ * no, se descarta. En ningún caso el turno espera al servidor: si la
+ * respuesta no ha llegado se resuelve con bits del pool. */
+bool attempt_quantum_tunnel(GameState *game, int tunnel_idx,
+                            QiskitMeasureTicket *ticket) {
     QuantumTunnel *tunnel = &game->tunnels[tunnel_idx];
     PlayerState *player = &game->player;
 
@@ -582,42 +877,69 @@ bool attempt_quantum_tunnel(GameState *game, int tunnel_idx) {
     /* Requirement: Must be in Superposition */
     if (player->phase_system.state != PHASE_STATE_SUPERPOSITION) {
         /* Feedback for user error */
-        spawn_centered_text(game, "REQUIERE SUPERPOSICION", PURPLE);
+        emit_centered_text(game, "REQUIERE SUPERPOSICION", PURPLE);
         return false;
     }
 
-    float success_chance = tunnel->success_probability;
-
-    /* Dev Fix: Increase base success rate to avoid frustration */
-    if (success_chance < 0.9f) {
-        success_chance = 0.95f;
-    }
-
-    for (int i = 0; i < MAX_ITEMS; i++) {
-        if (game->items[i].kind == ITEM_STABILIZER) {
-            success_chance = 1.0f; /* Stabilizer guarantees tunnel */
-            break;
-        }
+    float success_chance = quantum_tunnel_chance(game, tunnel);
+    int outcome;
+    if (ticket && ticket->pending && ticket->p == success_chance) {
+        outcome = qiskit_measure_resolve_now(ticket);
+    } else {
+        if (ticket)
+            qiskit_measure_cancel(ticket);
+        outcome = qiskit_measure_now(success_chance);
     }
 
-    float random_val = qiskit_random_float();
-
-    if (random_val < success_chance) {
+    if (outcome) {
         player->position = ivec2_add(tunnel->position, tunnel->target_offset);
-        spawn_spark_effect(game, player->position, PURPLE);
-        PlayAudioSound(teleport_sound); /* Ensure sound plays on success */
+        emit_sparks(game, player->position, PURPLE);
+        emit_sound(game, SOUND_TELEPORT); /* Ensure sound plays on success */
         return true;
     } else {
         player->is_stuck = true;
         player->stuck_turns = 2;
         player->coherence.current -= 10.0f; /* Reduced penalty */
         tunnel->last_failed = true;
-        spawn_spark_effect(game, player->position, RED);
-        spawn_centered_text(game, "TUNELIG FALLIDO", RED);
+        emit_sparks(game, player->position, RED);
+        emit_centered_text(game, "TUNELIG FALLIDO", RED);
         return false;
     }
 }
 
+/* Pide ya la medida del próximo intento de túnel, con la probabilidad del
+ * túnel más cercano, si el jugador está en superposición; si no, suelta la
+ * que hubiera. Todos los túneles de un nivel suelen tener la misma. */
+static void prefetch_tunnel_measure(GameState *game) {
+    PlayerState *player = &game->player;
+    const QuantumTunnel *nearest = NULL;
+    if (!player->dead &&
+        player->phase_system.state == PHASE_STATE_SUPERPOSITION) {
+        int best = 0;
+        for (int i = 0; i < MAX_TUNNELS; i++) {
+            const QuantumTunnel *tunnel = &game->tunnels[i];
+            if (tunnel->size.x <= 0 || tunnel->size.y <= 0)
+                continue;
+            int d = abs(tunnel->position.x - player->position.x) +
+                    abs(tunnel->position.y - player->position.y);
+            if (!nearest || d < best) {
+                nearest = tunnel;
+                best = d;
+            }
+        }
+    }
+    QiskitMeasureTicket *ticket = &game->tunnel_ticket;
+    if (!nearest) {
+        qiskit_measure_cancel(ticket);
+        return;
+    }
+    float p = quantum_tunnel_chance(game, nearest);
+    if (ticket->pending && ticket->p == p)
+        return;
+    qiskit_measure_cancel(ticket);
+    *ticket = qiskit_measure_async(p);
+}
+
 void game_player_turn(GameState *game, Direction dir) {
     PlayerState *player = &game->player;
 
@@ -625,7 +947,8 @@ void game_player_turn(GameState *game, Direction dir) {
     player->prev_eyes = player->eyes;
 
     /* One-way door check BEFORE moving */
-    Cell current_cell = game->map->data[player->position.y][player->position.x];
+    Cell current_cell =
+        MAP_AT(game->map, player->position.x, player->position.y);
     if (current_cell == CELL_ONEWAY_UP && dir != DIR_UP)
         return;
     if (current_cell == CELL_ONEWAY_DOWN && dir != DIR_DOWN)
@@ -641,7 +964,7 @@ void game_player_turn(GameState *game, Direction dir) {
     if (!within_map(game, new_pos))
         return;
 
-    Cell cell = game->map->data[new_pos.y][new_pos.x];
+    Cell cell = MAP_AT(game->map, new_pos.x, new_pos.y);
 
     /* One-way door Entry check */
     if (cell == CELL_ONEWAY_UP && dir != DIR_UP)
@@ -655,14 +978,13 @@ void game_player_turn(GameState *game, Direction dir) {
     if (cell == CELL_ONEWAY_RIGHT && dir == DIR_LEFT)
         return;
 
-    bool in_superposition =
-        player->phase_system.state == PHASE_STATE_SUPERPOSITION;
+    const uint64_t *passable = player_passability(game);
+    int words = game->passability.words;
 
-    if (!is_cell_solid_for_phase(cell, player->phase_system.current_phase,
-                                 in_superposition)) {
+    if (BOARD_BIT(passable, words, new_pos.x, new_pos.y)) {
         player->position = new_pos;
         player->steps_taken++;
-        PlayAudioSound(footstep_sounds[rand() % 4]);
+        emit_footstep(game);
 
         // ICE LOGIC: Slide until hit something solid or non-ice
         if (cell == CELL_ICE) {
@@ -674,18 +996,16 @@ void game_player_turn(GameState *game, Direction dir) {
                 if (!within_map(game, next_slide))
                     break;
 
-                Cell next_cell = game->map->data[next_slide.y][next_slide.x];
+                Cell next_cell = MAP_AT(game->map, next_slide.x, next_slide.y);
 
-                if (is_cell_solid_for_phase(next_cell,
-                                            player->phase_system.current_phase,
-                                            in_superposition)) {
-                    PlayAudioSound(ice_slide_sound);
+                if (!BOARD_BIT(passable, words, next_slide.x, next_slide.y)) {
+                    emit_sound(game, SOUND_ICE_SLIDE);
                     break; // Stop sliding
                 }
 
                 slide_pos = next_slide;
                 if (next_cell != CELL_ICE) {
-                    PlayAudioSound(ice_slide_sound);
+                    emit_sound(game, SOUND_ICE_SLIDE);
                     break; // Slid onto floor/other
                 }
             }
@@ -713,107 +1033,109 @@ void game_player_turn(GameState *game, Direction dir) {
             player->recording_frame++;
         }
 
-        printf("[AUDIO] Playing footstep sound\n");
-        PlayAudioSound(footstep_sounds[rand() % 4]);
+        emit_footstep(game);
     } else if (cell == CELL_DOOR) {
         if (player->keys > 0) {
             player->keys--;
             flood_fill(game, new_pos, CELL_FLOOR);
             player->position = new_pos;
-            PlayAudioSound(open_door_sound);
+            emit_sound(game, SOUND_OPEN_DOOR);
         }
     }
 }
 
 void collect_item_at(GameState *game, IVector2 pos) {
     PlayerState *player = &game->player;
-    for (int i = 0; i < MAX_ITEMS; i++) {
-        Item *item = &game->items[i];
-        if (item->kind == ITEM_NONE)
-            continue;
-        if (!ivec2_eq(item->position, pos))
+    EntityRef next;
+    for (EntityRef ref = entity_index_at(game, pos); ref; ref = next) {
+        /* Recoger un objeto lo saca de la lista que estamos recorriendo */
+        next = entity_index_next(game, ref);
+        if (ENTITY_REF_KIND(ref) != ENTITY_ITEM)
             continue;
+        int i = ENTITY_REF_INDEX(ref);
+        Item *item = &game->items[i];
 
         switch (item->kind) {
         case ITEM_KEY:
             player->keys++;
-            item->kind = ITEM_NONE;
-            PlayAudioSound(key_pickup_sound);
-            spawn_spark_effect(game, item->position, YELLOW);
-            spawn_centered_text(game, "LLAVE OBTENIDA", BLUE);
+            despawn_item(game, i);
+            emit_sound(game, SOUND_KEY_PICKUP);
+            emit_sparks(game, item->position, YELLOW);
+            emit_centered_text(game, "LLAVE OBTENIDA", BLUE);
             break;
         case ITEM_BOMB_REFILL:
             if (player->bombs < player->bomb_slots && item->cooldown <= 0) {
                 player->bombs++;
                 item->cooldown = 10;
-                PlayAudioSound(bomb_pickup_sound);
-                spawn_spark_effect(game, item->position, RED);
+                emit_sound(game, SOUND_BOMB_PICKUP);
+                emit_sparks(game, item->position, RED);
             }
             break;
         case ITEM_BOMB_SLOT:
-            item->kind = ITEM_NONE;
+            despawn_item(game, i);
             player->bomb_slots++;
             player->bombs = player->bomb_slots;
-            PlayAudioSound(key_pickup_sound);
-            spawn_spark_effect(game, item->position, ORANGE);
-            spawn_centered_text(game, "AMPLIACION BOMBAS", ORANGE);
+            emit_sound(game, SOUND_KEY_PICKUP);
+            emit_sparks(game, item->position, ORANGE);
+            emit_centered_text(game, "AMPLIACION BOMBAS", ORANGE);
             break;
         case ITEM_CHECKPOINT:
-            item->kind = ITEM_NONE;
+            despawn_item(game, i);
             player->bombs = player->bomb_slots;
             player->coherence.current = 100.0f;
             game->has_checkpoint = true;
             game->checkpoint_pos = item->position;
-            PlayAudioSound(checkpoint_sound);
-            spawn_spark_effect(game, item->position, GREEN);
-            spawn_centered_text(game, "PUNTO DE CONTROL", GREEN);
+            emit_sound(game, SOUND_CHECKPOINT);
+            emit_sparks(game, item->position, GREEN);
+            emit_centered_text(game, "PUNTO DE CONTROL", GREEN);
             break;
         case ITEM_COHERENCE_PICKUP:
-            item->kind = ITEM_NONE;
+            despawn_item(game, i);
             player->coherence.current =
                 fminf(100.0f, player->coherence.current + 5.0f);
-            PlayAudioSound(key_pickup_sound); // Added sound
-            spawn_spark_effect(game, item->position, BLUE);
-            spawn_centered_text(game, "+5% COHERENCE", YELLOW);
+            emit_sound(game, SOUND_KEY_PICKUP); // Added sound
+            emit_sparks(game, item->position, BLUE);
+            emit_centered_text(game, "+5% COHERENCE", YELLOW);
             break;
         case ITEM_STABILIZER:
             break;
         case ITEM_PHASE_UNLOCKER:
-            item->kind = ITEM_NONE;
+            despawn_item(game, i);
             if (!game->player.phase_system.green_unlocked) {
                 game->player.phase_system.green_unlocked = true;
-                spawn_centered_text(game, "FASE VERDE DESBLOQUEADA", GREEN);
+                emit_centered_text(game, "FASE VERDE DESBLOQUEADA", GREEN);
             } else {
                 game->player.phase_system.yellow_unlocked = true;
-                spawn_centered_text(game, "FASE AMARILLA DESBLOQUEADA", YELLOW);
+                emit_centered_text(game, "FASE AMARILLA DESBLOQUEADA", YELLOW);
             }
-            PlayAudioSound(key_pickup_sound);
+            emit_sound(game, SOUND_KEY_PICKUP);
             break;
         case ITEM_QUBIT:
-            item->kind = ITEM_NONE;
-            if (game->player.qubit_count < MAX_QUBITS) {
-                init_qubit(&game->player.qubits[game->player.qubit_count]);
+            despawn_item(game, i);
+            if (qreg_add_qubit(
+                    &game->player.qreg,
+                    &game->player.qubits[game->player.qubit_count])) {
                 game->player.qubit_count++;
-                if (IsAudioSoundValid(qubit_rotate_sound))
-                    PlayAudioSound(qubit_rotate_sound);
-                spawn_spark_effect(game, item->position, SKYBLUE);
+                emit_sound(game, SOUND_QUBIT_ROTATE);
+                emit_sparks(game, item->position, SKYBLUE);
             }
             break;
         case ITEM_HADAMARD_GATE:
-            item->kind = ITEM_NONE;
-            if (game->player.qubit_count > 0) {
+            despawn_item(game, i);
+            if (game->player.qubit_count > 0 &&
                 apply_hadamard_gate(
-                    &game->player.qubits[game->player.qubit_count - 1]);
+                    &game->player.qubits[game->player.qubit_count - 1])) {
+                emit_sound(game, SOUND_QUBIT_ROTATE);
             }
             break;
         case ITEM_TELEPORT_DEVICE:
-            item->kind = ITEM_NONE;
+            despawn_item(game, i);
             game->has_teleport_device = true;
-            PlayAudioSound(key_pickup_sound);
-            spawn_spark_effect(game, item->position, MAGENTA);
+            emit_sound(game, SOUND_KEY_PICKUP);
+            emit_sparks(game, item->position, MAGENTA);
             break;
         case ITEM_PHASE_LOCK:
-            item->kind = ITEM_NONE;
+            despawn_item(game, i);
             game->player.phase_system.phase_lock_turns = 10;
             break;
         default:
@@ -831,7 +1153,7 @@ void game_bombs_turn(GameState *game) {
         if (game->bombs[i].countdown > 0) {
             game->bombs[i].countdown--;
             if (game->bombs[i].countdown <= 0) {
-                PlayAudioSound(blast_sound);
+                emit_sound(game, SOUND_BLAST);
                 explode(game, game->bombs[i].position);
             }
         }
@@ -845,11 +1167,11 @@ void game_bombs_turn(GameState *game) {
                 colapsor->eyes = EYES_CRINGE;
                 colapsor->health -= 0.45f;
                 if (colapsor->health <= 0.0f) {
-                    colapsor->dead = true;
+                    colapsor_kill(game, e);
                 }
                 break;
             case COLAPSOR_GNOME:
-                colapsor->dead = true;
+                colapsor_kill(game, e);
                 allocate_item(game, colapsor->position, ITEM_KEY);
                 break;
             default:
@@ -859,14 +1181,27 @@ void game_bombs_turn(GameState *game) {
     }
 }
 
+/* Sólo se visitan las casillas que map_set_cell apuntó al explotar; si la
+ * lista se llenó se vuelve a recorrer el mapa entero */
 void game_explosions_turn(GameState *game) {
-    for (int y = 0; y < game->map->rows; y++) {
-        for (int x = 0; x < game->map->cols; x++) {
-            if (game->map->data[y][x] == CELL_EXPLOSION) {
-                game->map->data[y][x] = CELL_FLOOR;
+    if (game->explosion_overflow) {
+        for (int y = 0; y < game->map->rows; y++) {
+            const uint8_t *row = &MAP_AT(game->map, 0, y);
+            for (int x = 0; x < game->map->cols; x++) {
+                if (row[x] == CELL_EXPLOSION) {
+                    map_set_cell(game, ivec2(x, y), CELL_FLOOR);
+                }
             }
         }
+    } else {
+        for (int i = 0; i < game->explosion_count; i++) {
+            IVector2 pos = game->explosion_cells[i];
+            if (MAP_AT(game->map, pos.x, pos.y) == CELL_EXPLOSION)
+                map_set_cell(game, pos, CELL_FLOOR);
+        }
     }
+    game->explosion_count = 0;
+    game->explosion_overflow = false;
 }
 
 void game_items_turn(GameState *game) {
@@ -881,6 +1216,11 @@ void game_items_turn(GameState *game) {
 }
 
 void game_colapsores_turn(GameState *game) {
+    /* El jugador y el terreno no cambian durante este bucle: un campo por
+     * huella sirve a todos los colapsores del turno */
+    invalidate_distance_fields(game);
+    int cols = game->map->cols;
+
     for (int i = 0; i < MAX_COLAPSORES; i++) {
         ColapsarState *colapsor = &game->colapsores[i];
         if (colapsor->dead)
@@ -898,7 +1238,7 @@ void game_colapsores_turn(GameState *game) {
                     /* Fix: Use proper collision logic so they don't clip walls
                      */
                     if (colapsor_can_stand_here(game, target, i)) {
-                        colapsor->position = target;
+                        colapsor_move(game, i, target);
                     }
                 }
             }
@@ -907,11 +1247,10 @@ void game_colapsores_turn(GameState *game) {
             if (colapsor->entanglement_turns >= 6) {
                 colapsor->entangled_with_player = false;
                 colapsor->eyes = EYES_OPEN;
-                spawn_spark_effect(game, colapsor->position, RED);
-                spawn_floating_text(game, colapsor->position, "VINCULO ROTO",
+                emit_sparks(game, colapsor->position, RED);
+                emit_floating_text(game, colapsor->position, "VINCULO ROTO",
                                     RED);
-                if (IsAudioSoundValid(entangle_sound))
-                    PlayAudioSound(entangle_sound);
+                emit_sound(game, SOUND_ENTANGLE);
             } else {
                 // Visual feedback
                 colapsor->eyes = EYES_SURPRISED;
@@ -922,9 +1261,10 @@ void game_colapsores_turn(GameState *game) {
 
         switch (colapsor->kind) {
         case COLAPSOR_GUARD: {
-            recompute_path_for_colapsor(game, i);
+            const DistanceField *path = colapsor_path_field(game, i);
             IVector2 pos = colapsor->position;
-            int dist = colapsor->path[pos.y][pos.x];
+            int dist =
+                path ? distance_field_at(path, pos.y * cols + pos.x) : -1;
 
             if (dist == 0) {
                 kill_player(game);
@@ -940,7 +1280,8 @@ void game_colapsores_turn(GameState *game) {
                             test_pos =
                                 ivec2_add(test_pos, DIRECTION_VECTORS[dir]);
                             if (within_map(game, test_pos) &&
-                                colapsor->path[test_pos.y][test_pos.x] ==
+                                distance_field_at(path, test_pos.y * cols +
+                                                            test_pos.x) ==
                                     dist - 1) {
                                 best_moves[count++] = test_pos;
                                 break;
@@ -949,8 +1290,8 @@ void game_colapsores_turn(GameState *game) {
                     }
 
                     if (count > 0) {
-                        colapsor->position = best_moves[rand() % count];
-                        PlayAudioSound(guard_step_sound);
+                        colapsor_move(game, i, best_moves[game_rand() % count]);
+                        emit_sound(game, SOUND_GUARD_STEP);
                     }
 
                     colapsor->attack_cooldown = GUARD_ATTACK_COOLDOWN;
@@ -977,12 +1318,12 @@ void game_colapsores_turn(GameState *game) {
                 colapsor->attack_cooldown = GUARD_ATTACK_COOLDOWN + 1;
 
                 /* Increase wander chance to 50% to prevent being "frozen" */
-                if (!colapsor->dead && (rand() % 100) < 50) {
-                    int dir = rand() % 4;
+                if (!colapsor->dead && (game_rand() % 100) < 50) {
+                    int dir = game_rand() % 4;
                     IVector2 new_pos =
                         ivec2_add(colapsor->position, DIRECTION_VECTORS[dir]);
                     if (colapsor_can_stand_here(game, new_pos, i)) {
-                        colapsor->position = new_pos;
+                        colapsor_move(game, i, new_pos);
                     }
                 }
             }
@@ -993,25 +1334,31 @@ void game_colapsores_turn(GameState *game) {
             break;
         }
         case COLAPSOR_GNOME: {
-            recompute_path_for_colapsor(game, i);
+            const DistanceField *path = colapsor_path_field(game, i);
             IVector2 pos = colapsor->position;
+            int index = pos.y * cols + pos.x;
+            int dist = path ? distance_field_at(path, index) : -1;
 
-            if (colapsor->path[pos.y][pos.x] >= 0) {
+            if (dist >= 0) {
                 IVector2 available[4];
                 int count = 0;
 
                 for (int dir = 0; dir < 4; dir++) {
                     IVector2 new_pos = ivec2_add(pos, DIRECTION_VECTORS[dir]);
-                    if (within_map(game, new_pos) &&
-                        game->map->data[new_pos.y][new_pos.x] == CELL_FLOOR &&
-                        colapsor->path[new_pos.y][new_pos.x] >
-                            colapsor->path[pos.y][pos.x]) {
+                    int new_index = new_pos.y * cols + new_pos.x;
+                    /* Sólo lo que la búsqueda había visto al llegar al
+                     * gnomo: el campo compartido sigue más allá */
+                    if (MAP_AT(game->map, new_pos.x, new_pos.y) ==
+                            CELL_FLOOR &&
+                        distance_field_at(path, new_index) > dist &&
+                        distance_field_reached_before(path, new_index,
+                                                      index)) {
                         available[count++] = new_pos;
                     }
                 }
 
                 if (count > 0) {
-                    colapsor->position = available[rand() % count];
+                    colapsor_move(game, i, available[game_rand() % count]);
                 }
                 colapsor->eyes = EYES_OPEN;
                 colapsor->eyes_target = game->player.position;
@@ -1052,41 +1399,58 @@ void handle_plant_bomb(GameState *game) {
     }
 }
 
+static PressureButton *button_from_ref(GameState *game, EntityRef ref) {
+    if (ENTITY_REF_KIND(ref) != ENTITY_BUTTON)
+        return NULL;
+    PressureButton *b = &game->buttons[ENTITY_REF_INDEX(ref)];
+    return b->is_active ? b : NULL;
+}
+
 void update_pressure_buttons(GameState *game) {
     PlayerState *player = &game->player;
     bool in_super = player->phase_system.state == PHASE_STATE_SUPERPOSITION;
 
-    for (int i = 0; i < MAX_BUTTONS; i++) {
-        PressureButton *b = &game->buttons[i];
-        if (!b->is_active)
-            continue;
+    for (int i = 0; i < MAX_BUTTONS; i++)
+        game->buttons[i].is_pressed = false;
 
-        b->is_pressed = false;
+    /* Cada jugador/eco/colapsor mira qué botones tiene debajo, en vez de
+     * que cada botón recorra todos los ecos y colapsores */
+    for (EntityRef ref = entity_index_at(game, player->position); ref;
+         ref = entity_index_next(game, ref)) {
+        PressureButton *b = button_from_ref(game, ref);
+        if (b && (in_super || player->phase_system.current_phase == b->phase))
+            b->is_pressed = true;
+    }
 
-        /* Player on button? */
-        if (ivec2_eq(player->position, b->position)) {
-            if (in_super || player->phase_system.current_phase == b->phase) {
+    for (int e = 0; e < MAX_ECHOS; e++) {
+        if (!game->echos[e].active)
+            continue;
+        for (EntityRef ref = entity_index_at(game, game->echos[e].position);
+             ref; ref = entity_index_next(game, ref)) {
+            PressureButton *b = button_from_ref(game, ref);
+            if (b && game->echos[e].phase == b->phase)
                 b->is_pressed = true;
-            }
-        }
-        /* Echo on button? */
-        for (int e = 0; e < MAX_ECHOS; e++) {
-            if (game->echos[e].active &&
-                ivec2_eq(game->echos[e].position, b->position)) {
-                if (game->echos[e].phase == b->phase) {
-                    b->is_pressed = true;
-                }
-            }
         }
+    }
 
-        /* Colapsor on button? */
-        for (int c = 0; c < MAX_COLAPSORES; c++) {
-            if (!game->colapsores[c].dead &&
-                ivec2_eq(game->colapsores[c].position, b->position)) {
+    for (int c = 0; c < MAX_COLAPSORES; c++) {
+        if (game->colapsores[c].dead)
+            continue;
+        for (EntityRef ref =
+                 entity_index_at(game, game->colapsores[c].position);
+             ref; ref = entity_index_next(game, ref)) {
+            PressureButton *b = button_from_ref(game, ref);
+            if (b)
                 b->is_pressed = true;
-            }
         }
     }
+
+    /* Entrada de los disparadores de nivel (check_level_events) */
+    game->buttons_pressed = 0;
+    for (int i = 0; i < MAX_BUTTONS; i++) {
+        if (game->buttons[i].is_pressed)
+            game->buttons_pressed |= 1u << i;
+    }
 }
 
 void handle_entangle_action(GameState *game) {
@@ -1096,7 +1460,7 @@ void handle_entangle_action(GameState *game) {
 
     // Apply strict coherence cost regardless of outcome
     player->coherence.current -= 10.0f;
-    spawn_floating_text(game, player->position, "-10 COHERENCIA", RED);
+    emit_floating_text(game, player->position, "-10 COHERENCIA", RED);
 
     for (int i = 0; i < MAX_COLAPSORES; i++) {
         ColapsarState *colapsor = &game->colapsores[i];
@@ -1119,24 +1483,23 @@ void handle_entangle_action(GameState *game) {
             if (colapsor->entangled_with_player) {
                 game->player.entanglements_created++;
                 colapsor->eyes = EYES_SURPRISED;
-                spawn_spark_effect(game, colapsor->position, GREEN);
-                spawn_floating_text(game, colapsor->position, "ENTRELAZADO!",
+                emit_sparks(game, colapsor->position, GREEN);
+                emit_floating_text(game, colapsor->position, "ENTRELAZADO!",
                                     GREEN);
             } else {
                 colapsor->eyes = EYES_OPEN;
-                spawn_spark_effect(game, colapsor->position, WHITE);
-                spawn_floating_text(game, colapsor->position, "DESVINCULADO",
+                emit_sparks(game, colapsor->position, WHITE);
+                emit_floating_text(game, colapsor->position, "DESVINCULADO",
                                     WHITE);
             }
         }
     }
 
     if (any_entangled) {
-        if (IsAudioSoundValid(entangle_sound))
-            PlayAudioSound(entangle_sound);
+        emit_sound(game, SOUND_ENTANGLE);
     } else {
         // Feedback if no valid target found
-        spawn_floating_text(game, player->position, "NO HAY OBJETIVO", RED);
+        emit_floating_text(game, player->position, "NO HAY OBJETIVO", RED);
     }
 }
 
@@ -1160,6 +1523,9 @@ void execute_turn(GameState *game, Command cmd) {
 
     game->turn_animation = 1.0f;
     game->turn_count++;
+    /* Lo que se movió el jugador en este turno (lo usan los colapsores
+     * entrelazados y la animación): sin paso, nada */
+    game->player.prev_position = game->player.position;
 
     game_explosions_turn(game);
     game_items_turn(game);
@@ -1168,24 +1534,23 @@ void execute_turn(GameState *game, Command cmd) {
         game_player_turn(game, cmd.dir);
     } else if (cmd.kind == CMD_PLANT) {
         handle_plant_bomb(game);
-        PlayAudioSound(plant_bomb_sound);
-        spawn_spark_effect(game, game->player.position, ORANGE);
+        emit_sound(game, SOUND_PLANT_BOMB);
+        emit_sparks(game, game->player.position, ORANGE);
     } else if (cmd.kind == CMD_PHASE_CHANGE) {
         handle_phase_change(game);
-        spawn_spark_effect(game, game->player.position, SKYBLUE);
+        emit_sparks(game, game->player.position, SKYBLUE);
     } else if (cmd.kind == CMD_SUPERPOSITION) {
         handle_superposition(game);
-        spawn_spark_effect(game, game->player.position, PURPLE);
+        emit_sparks(game, game->player.position, PURPLE);
     } else if (cmd.kind == CMD_INTERACT) {
         handle_portal_teleport(game);
-        spawn_spark_effect(game, game->player.position, MAGENTA);
+        emit_sparks(game, game->player.position, MAGENTA);
     } else if (cmd.kind == CMD_ENTANGLE) {
         handle_entangle_action(game);
-        spawn_spark_effect(game, game->player.position, GREEN);
+        emit_sparks(game, game->player.position, GREEN);
     } else if (cmd.kind == CMD_WAIT) {
         if (game->player.phase_system.state == PHASE_STATE_SUPERPOSITION) {
-            SetAudioSoundPitch(phase_shift_sound, 0.5f);
-            PlayAudioSound(phase_shift_sound);
+            emit_sound_pitch(game, SOUND_PHASE_SHIFT, 0.5f);
         }
         if (game->player.is_recording_echo &&
             game->player.recording_frame < MAX_ECHO_FRAMES) {
@@ -1206,14 +1571,15 @@ void execute_turn(GameState *game, Command cmd) {
     update_pressure_buttons(game);
     update_oracles(game);
 
+    /* Punto de commit de la medida del túnel, pedida al acabar el turno
+     * anterior */
     for (int i = 0; i < MAX_TUNNELS; i++) {
-        if (attempt_quantum_tunnel(game, i)) {
-            PlayAudioSound(teleport_sound);
+        if (attempt_quantum_tunnel(game, i, &game->tunnel_ticket)) {
+            emit_sound(game, SOUND_TELEPORT);
             game_items_turn(game); // Force pickup check immediately
             break;
         }
     }
-
     /* Automatic Portal Check */
     handle_portal_teleport(game);
 
@@ -1227,6 +1593,8 @@ void execute_turn(GameState *game, Command cmd) {
     }
 
     check_level_events(game);
+    prefetch_tunnel_measure(game);
+    qiskit_mark_turn();
 }
 
 bool check_level_complete(GameState *game) {
@@ -1234,3 +1602,152 @@ bool check_level_complete(GameState *game) {
         return false;
     return ivec2_eq(game->player.position, game->exit_position);
 }
+
+/* ===== HASH DEL ESTADO ===== */
+
+/* Sólo casillas y objetos llevan hashes Zobrist que se mantienen al
+ * cambiar; el resto del estado que decide los turnos siguientes (jugador,
+ * vector de estado, colapsores, grabaciones de los ecos...) se vuelve a
+ * mezclar campo a campo en cada llamada. player.prev_position no entra:
+ * execute_turn la pone al día antes de usarla. Lo puramente visual (ojos, partículas, animaciones) y las
+ * estadísticas del jugador no cuentan: dos estados que sólo difieren en eso
+ * juegan igual. */
+static uint64_t hash_word(uint64_t hash, uint64_t value) {
+    return zobrist_key(hash ^ value, 0);
+}
+
+static uint64_t hash_float(uint64_t hash, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_word(hash, bits);
+}
+
+static uint64_t hash_pos(uint64_t hash, IVector2 pos) {
+    return hash_word(hash, (uint64_t)(uint32_t)pos.x << 32 |
+                               (uint32_t)pos.y);
+}
+
+static uint64_t hash_recording(uint64_t hash, const EchoAction *frames,
+                               int count) {
+    for (int i = 0; i < count; i++) {
+        hash = hash_pos(hash, frames[i].position);
+        hash = hash_word(hash, (uint64_t)frames[i].action.kind << 8 |
+                                   (uint64_t)frames[i].action.dir);
+    }
+    return hash;
+}
+
+uint64_t game_state_hash(GameState *game) {
+    const PlayerState *player = &game->player;
+    uint64_t hash = map_cell_hash(game) ^ game->item_hash;
+
+    hash = hash_pos(hash, player->position);
+    hash = hash_word(hash, (uint64_t)player->dead | player->is_stuck << 1 |
+                               player->is_recording_echo << 2 |
+                               player->next_echo_permanent << 3 |
+                               (uint64_t)game->has_teleport_device << 4 |
+                               (uint64_t)game->has_checkpoint << 5 |
+                               (uint64_t)game->game_over << 6);
+    hash = hash_word(hash, (uint64_t)player->keys << 32 |
+                               (uint32_t)player->bombs);
+    hash = hash_word(hash, (uint64_t)player->bomb_slots << 32 |
+                               (uint32_t)player->stuck_turns);
+    const QuantumPhaseSystem *phase = &player->phase_system;
+    hash = hash_word(hash, (uint64_t)phase->current_phase |
+                               (uint64_t)phase->state << 4 |
+                               (uint64_t)phase->green_unlocked << 8 |
+                               (uint64_t)phase->yellow_unlocked << 9 |
+                               (uint64_t)phase->superposition_turns_left
+                                   << 16 |
+                               (uint64_t)phase->phase_lock_turns << 40);
+    hash = hash_float(hash, player->coherence.current);
+    hash = hash_float(hash, player->coherence.max_coherence);
+    hash = hash_word(hash, (uint64_t)player->coherence.decay_counter << 32 |
+                               (uint32_t)player->coherence.regen_counter);
+    hash = hash_pos(hash, player->superposition_start_pos);
+    if (player->is_recording_echo)
+        hash = hash_recording(hash, player->current_recording,
+                              player->recording_frame);
+    hash = hash_pos(hash, game->checkpoint_pos);
+    hash = hash_pos(hash, game->exit_position);
+
+    hash = hash_word(hash, (uint64_t)player->qubit_count << 32 |
+                               (uint32_t)player->qreg.num_qubits);
+    for (int i = 0; i < player->qubit_count; i++) {
+        const Qubit *qubit = &player->qubits[i];
+        hash = hash_word(hash, (uint64_t)qubit->active |
+                                   (uint64_t)qubit->is_measured << 1 |
+                                   (uint64_t)qubit->measured_value << 2 |
+                                   (uint64_t)qubit->wire << 8);
+    }
+    for (int s = 0; s < (1 << player->qreg.num_qubits); s++) {
+        hash = hash_float(hash, player->qreg.re[s]);
+        hash = hash_float(hash, player->qreg.im[s]);
+    }
+
+    for (int i = 0; i < MAX_COLAPSORES; i++) {
+        const ColapsarState *colapsor = &game->colapsores[i];
+        if (colapsor->dead)
+            continue;
+        hash = hash_word(hash, (uint64_t)i << 32 | colapsor->kind);
+        hash = hash_pos(hash, colapsor->position);
+        hash = hash_float(hash, colapsor->health);
+        hash = hash_word(hash, (uint64_t)colapsor->attack_cooldown << 32 |
+                                   (uint64_t)colapsor->damaged |
+                                   (uint64_t)colapsor->teleports << 1 |
+                                   (uint64_t)colapsor->entangled_with_player
+                                       << 2 |
+                                   (uint64_t)colapsor->entanglement_turns
+                                       << 8);
+    }
+    for (int i = 0; i < MAX_BOMBS; i++) {
+        const BombState *bomb = &game->bombs[i];
+        if (bomb->countdown <= 0)
+            continue;
+        hash = hash_word(hash, (uint64_t)i << 32 | (uint32_t)bomb->countdown);
+        hash = hash_pos(hash, bomb->position);
+    }
+    for (int i = 0; i < MAX_ECHOS; i++) {
+        const QuantumEcho *echo = &game->echos[i];
+        if (!echo->active)
+            continue;
+        hash = hash_word(hash, (uint64_t)i << 48 | (uint64_t)echo->phase |
+                                   (uint64_t)echo->is_permanent << 4 |
+                                   (uint64_t)echo->playback_index << 8 |
+                                   (uint64_t)echo->recording_index << 24);
+        hash = hash_pos(hash, echo->position);
+        hash = hash_recording(hash, echo->recording, echo->recording_index);
+    }
+    for (int i = 0; i < MAX_ITEMS; i++) {
+        if (game->items[i].kind != ITEM_NONE && game->items[i].cooldown)
+            hash = hash_word(hash, (uint64_t)i << 32 |
+                                       (uint32_t)game->items[i].cooldown);
+    }
+    for (int i = 0; i < MAX_ENTANGLED; i++) {
+        const EntangledObject *object = &game->entangled[i];
+        if (!object->is_active)
+            continue;
+        hash = hash_word(hash, (uint64_t)i << 32 | object->phase |
+                                   (uint64_t)object->partner_index << 8);
+        hash = hash_pos(hash, object->position);
+    }
+
+    uint64_t flags = game->buttons_pressed;
+    for (int i = 0; i < MAX_PORTALS; i++)
+        flags |= (uint64_t)game->portals[i].active << (32 + i);
+    for (int i = 0; i < MAX_TRIGGERS; i++)
+        flags |= (uint64_t)game->triggers[i].was_met << (48 + i);
+    hash = hash_word(hash, flags);
+    flags = 0;
+    for (int i = 0; i < MAX_ORACLES; i++) {
+        flags |= (uint64_t)game->oracles[i].active << i |
+                 (uint64_t)game->oracles[i].is_marked_state << (8 + i) |
+                 (uint64_t)game->oracles[i].inverts_phase << (16 + i);
+        hash = hash_word(hash, (uint64_t)game->oracles[i].query_count);
+    }
+    for (int i = 0; i < MAX_DETECTORS; i++)
+        flags |= (uint64_t)game->detectors[i].is_active << (24 + i);
+    for (int i = 0; i < MAX_TUNNELS; i++)
+        flags |= (uint64_t)game->tunnels[i].last_failed << (40 + i);
+    return hash_word(hash, flags);
+}
@@ -8,6 +8,7 @@
 void spawn_guard(GameState *game, IVector2 pos);
 void spawn_gnome(GameState *game, IVector2 pos);
 void allocate_item(GameState *game, IVector2 pos, ItemKind kind);
+void despawn_item(GameState *game, int item_idx);
 void spawn_detector(GameState *game, IVector2 pos, Direction dir,
                     PhaseKind phase);
 void spawn_tunnel(GameState *game, IVector2 pos, IVector2 size,
@@ -17,6 +18,7 @@ void make_room(GameState *game);
 
 // Turn Execution
 void execute_turn(GameState *game, Command cmd);
+void game_explosions_turn(GameState *game);
 void handle_phase_change(GameState *game);
 void handle_superposition(GameState *game);
 
@@ -37,6 +39,29 @@ bool check_level_complete(GameState *game);
 void check_level_events(GameState *game);
 void kill_player(GameState *game);
 
+// Hash de todo lo que decide los turnos siguientes (casillas, objetos,
+// jugador, colapsores, bombas, ecos, qubits, botones, portales...). Estados
+// con el mismo hash juegan igual; lo usa tools/level_solver.c para no
+// visitar dos veces el mismo estado.
+uint64_t game_state_hash(GameState *game);
+
+// Pathfinding y relleno (BFS sobre el scratch del nivel, sin reservas)
+// Campo compartido por todos los colapsores de esa huella; se recalcula la
+// primera vez que se pide tras invalidate_distance_fields (una vez por turno)
+const DistanceField *colapsor_distance_field(GameState *game, IVector2 size);
+// El campo con el que se mueve ese colapsor este turno: el compartido, o
+// su propio BFS con los demás colapsores como obstáculos si alguno le corta
+// el camino
+const DistanceField *colapsor_path_field(GameState *game, int colapsor_idx);
+// Distancia en la casilla index (y*cols+x) del campo, -1 si no se alcanzó
+int distance_field_at(const DistanceField *field, int index);
+// index ya tenía distancia cuando el BFS sacó stop_index de la cola: lo
+// que vería una búsqueda que se para en stop_index
+bool distance_field_reached_before(const DistanceField *field, int index,
+                                   int stop_index);
+void invalidate_distance_fields(GameState *game);
+void flood_fill(GameState *game, IVector2 start, Cell fill);
+
 // Atmosphere & Flashlight
 void init_atmosphere(GameState *game);
 void update_atmosphere(GameState *game);
@@ -1,24 +1,22 @@
-#include "audio.h"
 #include "common.h"
+#include "events.h"
+#include "level_watch.h"
 #include "levels.h"
 #include "persistence.h"
+#include "presentation.h"
 #include "qiskit.h"
 #include "render.h"
 #include "utils.h"
 
 void cleanup_game(GameState *game) {
     qiskit_shutdown();
-    if (game->map) {
-        map_free(game->map);
-    }
-
-    for (int i = 0; i < MAX_COLAPSORES; i++) {
-        if (game->colapsores[i].path) {
-            path_free(game->colapsores[i].path, game->colapsores[i].path_rows);
-        }
-    }
+    free_level_state(game);
 }
 
+#ifdef DEBUG_MODE
+static bool show_qiskit_overlay = false;
+#endif
+
 int main(void) {
     SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_VSYNC_HINT);
 #ifndef DEBUG_MODE
@@ -112,12 +110,29 @@ int main(void) {
     load_game(&game);
     init_atmosphere(&game);
 
+    /* La simulación sólo emite eventos; aquí se convierten en audio/FX */
+    game_set_event_sink(&game, present_game_event, &game);
     load_level(&game, 0);
 
+#ifdef DEBUG_MODE
+    /* Recarga en caliente de los .psl de assets/levels (make levels) */
+    LevelWatch level_watch;
+    level_watch_start(&level_watch);
+#endif
+
     while (!WindowShouldClose()) {
         UpdateAudioMusic(ambient_music);
 
 #ifdef DEBUG_MODE
+        /* === QISKIT DEBUG KEYS === */
+        if (IsKeyPressed(KEY_F8)) {
+            show_qiskit_overlay = !show_qiskit_overlay;
+        }
+        if (IsKeyPressed(KEY_F9)) {
+            if (qiskit_dump_stats("qiskit_stats.txt"))
+                printf("[Qiskit] F9: stats written to qiskit_stats.txt\n");
+        }
+
         /* === AUDIO DEBUG KEYS === */
         if (IsKeyPressed(KEY_F7)) {
             if (IsAudioMusicPlaying(ambient_music)) {
@@ -129,6 +144,11 @@ int main(void) {
                 printf("[AUDIO DEBUG] F7: Music STARTED\n");
             }
         }
+
+        /* === RECARGA DE NIVELES === */
+        if (game.state_kind == GAME_STATE_PLAYING &&
+            level_watch_update(&level_watch, &game))
+            TraceLog(LOG_INFO, "LEVELS: %s recargado", game.level_name);
 #endif
 
         float dt = GetFrameTime();
@@ -211,6 +231,8 @@ int main(void) {
                     game.game_over = true;
                 }
             } else {
+                game.player.level_time += dt;
+
                 if (check_level_complete(&game)) {
                     PlayAudioSound(level_complete_sound);
                     if (game.current_level < MAX_LEVELS - 1) {
@@ -424,9 +446,18 @@ int main(void) {
             }
         }
 
+#ifdef DEBUG_MODE
+        if (show_qiskit_overlay) {
+            render_qiskit_overlay();
+        }
+#endif
+
         EndDrawing();
     }
 
+#ifdef DEBUG_MODE
+    level_watch_stop(&level_watch);
+#endif
     unload_post_shader();
     cleanup_game(&game);
 
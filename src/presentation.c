@@ -0,0 +1,106 @@
+#include "presentation.h"
+#include "render.h"
+
+// Global Definitions
+AudioSound footstep_sounds[4];
+AudioSound blast_sound;
+AudioSound key_pickup_sound;
+AudioSound bomb_pickup_sound;
+AudioSound checkpoint_sound;
+AudioSound phase_shift_sound;
+AudioMusic ambient_music;
+
+AudioSound teleport_sound;
+AudioSound measurement_sound;
+AudioSound entangle_sound;
+AudioSound qubit_rotate_sound;
+AudioSound oracle_sound;
+AudioSound ice_slide_sound;
+AudioSound mirror_reflect_sound;
+AudioSound decoherence_sound;
+AudioSound portal_activate_sound;
+AudioSound level_complete_sound;
+AudioSound guard_step_sound;
+AudioSound open_door_sound;
+AudioSound plant_bomb_sound;
+
+static AudioSound *sound_for_event(const GameEvent *event) {
+    switch (event->sound) {
+    case SOUND_FOOTSTEP:
+        return &footstep_sounds[event->variant & 3];
+    case SOUND_BLAST:
+        return &blast_sound;
+    case SOUND_KEY_PICKUP:
+        return &key_pickup_sound;
+    case SOUND_BOMB_PICKUP:
+        return &bomb_pickup_sound;
+    case SOUND_CHECKPOINT:
+        return &checkpoint_sound;
+    case SOUND_PHASE_SHIFT:
+        return &phase_shift_sound;
+    case SOUND_TELEPORT:
+        return &teleport_sound;
+    case SOUND_MEASUREMENT:
+        return &measurement_sound;
+    case SOUND_ENTANGLE:
+        return &entangle_sound;
+    case SOUND_QUBIT_ROTATE:
+        return &qubit_rotate_sound;
+    case SOUND_ORACLE:
+        return &oracle_sound;
+    case SOUND_ICE_SLIDE:
+        return &ice_slide_sound;
+    case SOUND_MIRROR_REFLECT:
+        return &mirror_reflect_sound;
+    case SOUND_DECOHERENCE:
+        return &decoherence_sound;
+    case SOUND_GUARD_STEP:
+        return &guard_step_sound;
+    case SOUND_OPEN_DOOR:
+        return &open_door_sound;
+    case SOUND_PLANT_BOMB:
+        return &plant_bomb_sound;
+    default:
+        return NULL;
+    }
+}
+
+/* Las chispas usan GetRandomValue (generador propio de raylib) para no
+ * consumir la secuencia de rand() de la simulación */
+static void spawn_spark_effect(GameState *game, IVector2 pos, Color col) {
+    Vector2 center = {pos.x * CELL_SIZE + CELL_SIZE / 2.0f,
+                      pos.y * CELL_SIZE + CELL_SIZE / 2.0f};
+    for (int i = 0; i < 10; i++) {
+        Vector2 vel = {(float)GetRandomValue(-100, 99),
+                       (float)GetRandomValue(-100, 99)};
+        spawn_particle(game, center, vel, col, 4.0f, 0.5f);
+    }
+}
+
+void present_game_event(const GameEvent *event, void *user) {
+    GameState *game = (GameState *)user;
+
+    switch (event->kind) {
+    case EVENT_SOUND: {
+        AudioSound *sound = sound_for_event(event);
+        if (!sound || !IsAudioSoundValid(*sound))
+            break;
+        if (event->pitch > 0.0f)
+            SetAudioSoundPitch(*sound, event->pitch);
+        PlayAudioSound(*sound);
+        break;
+    }
+    case EVENT_SPARKS:
+        spawn_spark_effect(game, event->cell, event->color);
+        break;
+    case EVENT_FLOATING_TEXT:
+        spawn_floating_text(game, event->cell, event->text, event->color);
+        break;
+    case EVENT_CENTERED_TEXT:
+        spawn_centered_text(game, event->text, event->color);
+        break;
+    case EVENT_PLAYER_DIED:
+        game->player.death_time = GetTime();
+        break;
+    }
+}
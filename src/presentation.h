@@ -0,0 +1,34 @@
+#ifndef PRESENTATION_H
+#define PRESENTATION_H
+
+#include "audio.h"
+#include "common.h"
+
+// Sonidos del juego (cargados en main.c)
+extern AudioSound footstep_sounds[4];
+extern AudioSound blast_sound;
+extern AudioSound key_pickup_sound;
+extern AudioSound bomb_pickup_sound;
+extern AudioSound checkpoint_sound;
+extern AudioSound phase_shift_sound;
+extern AudioMusic ambient_music;
+
+extern AudioSound teleport_sound;
+extern AudioSound measurement_sound;
+extern AudioSound entangle_sound;
+extern AudioSound qubit_rotate_sound;
+extern AudioSound oracle_sound;
+extern AudioSound ice_slide_sound;
+extern AudioSound mirror_reflect_sound;
+extern AudioSound decoherence_sound;
+extern AudioSound portal_activate_sound;
+extern AudioSound level_complete_sound;
+extern AudioSound guard_step_sound;
+extern AudioSound open_door_sound;
+extern AudioSound plant_bomb_sound;
+
+// Receptor de eventos del front-end: audio, partículas y textos.
+// user debe ser el GameState que emite los eventos.
+void present_game_event(const GameEvent *event, void *user);
+
+#endif
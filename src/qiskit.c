@@ -1,3 +1,7 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "qiskit.h"
 #include <stdbool.h>
 #include <stdio.h>
@@ -8,20 +12,1206 @@
 #include <windows.h>
 #include <wininet.h>
 #pragma comment(lib, "wininet.lib")
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#define QISKIT_THREAD_LOCAL __declspec(thread)
+#else
+#define QISKIT_THREAD_LOCAL __thread
 #endif
 
 #define QISKIT_SERVER_HOST "91.99.90.39"
 #define QISKIT_SERVER_PORT 8609
 #define QISKIT_ENDPOINT "/generate_bit"
+#define QISKIT_BATCH_ENDPOINT "/generate_bits"
+#define QISKIT_MEASURE_ENDPOINT "/measure"
 #define QISKIT_TIMEOUT_MS 2000
+/* Timeout de cada petición a /measure */
+#define QISKIT_MEASURE_TIMEOUT_MS 250
+/* Espera máxima del hilo de juego en el punto de commit de una medida
+ * (timeout de la petición más margen para el hilo de medidas) */
+#define QISKIT_MEASURE_WAIT_MS (QISKIT_MEASURE_TIMEOUT_MS + 50)
+#define QISKIT_MEASURE_SLOTS 8   /* Medidas pendientes a la vez */
+#define QISKIT_MEASURE_POLL_MS 1 /* Sondeo de la cola de medidas */
+
+/* Variables de entorno para apuntar a otro servidor (p. ej. uno local) */
+#define QISKIT_ENV_HOST "PHASE_SHIFT_QISKIT_HOST"
+#define QISKIT_ENV_PORT "PHASE_SHIFT_QISKIT_PORT"
+/* Selección de backend: remote (por defecto), sim o tape */
+#define QISKIT_ENV_BACKEND "PHASE_SHIFT_QISKIT_BACKEND"
+#define QISKIT_ENV_SEED "PHASE_SHIFT_QISKIT_SEED"
+#define QISKIT_ENV_TAPE "PHASE_SHIFT_QISKIT_TAPE"
+#define QISKIT_ENV_RECORD "PHASE_SHIFT_QISKIT_RECORD"
+
+#define QISKIT_SIM_DEFAULT_SEED 0x5EEDULL
+#define QISKIT_TAPE_MAGIC "PSQTAPE1"
+
+/* Pool de entropía: ring buffer de bytes (8 bits del servidor por byte).
+ * Tamaño potencia de dos para poder enmascarar los índices. */
+#define QISKIT_POOL_BYTES 4096
+#define QISKIT_POOL_MASK (QISKIT_POOL_BYTES - 1)
+#define QISKIT_BATCH_BYTES 512 /* 4096 bits por petición a /generate_bits */
+#define QISKIT_PIPELINE_DEPTH 4 /* Lotes en vuelo por ráfaga */
+#define QISKIT_IDLE_MS 10   /* Espera del productor con el pool lleno */
+
+/* Circuit breaker: fallos seguidos para abrirlo, respuesta que cuenta como
+ * fallo por lenta y ventana sin peticiones (se duplica hasta el máximo) */
+#define QISKIT_BREAKER_FAILURES 3
+#define QISKIT_BREAKER_SLOW_MS 1000
+#define QISKIT_BREAKER_MIN_MS 1000
+#define QISKIT_BREAKER_MAX_MS 30000
+
+/* Fichero donde qiskit_shutdown() vuelca las estadísticas del cliente */
+#define QISKIT_ENV_STATS "PHASE_SHIFT_QISKIT_STATS"
+
+/* Resultado de qiskit_fetch_batches() cuando el servidor no conoce el
+ * endpoint por lotes (versiones antiguas de quantum_server.py) */
+#define QISKIT_FETCH_UNSUPPORTED (-2)
+
+static char server_host[256] = QISKIT_SERVER_HOST;
+static int server_port = QISKIT_SERVER_PORT;
 
 #ifdef _WIN32
 static HINTERNET h_internet = NULL;
 static HINTERNET h_connect = NULL;
+static HANDLE producer_thread = NULL;
+#else
+static pthread_t producer_thread;
 #endif
+static bool producer_started = false;
+static int producer_running = 0;
+
+/* Ring buffer SPSC sin locks: sólo el productor escribe pool_head y sólo el
+ * hilo de juego escribe pool_tail. La publicación de cada byte usa
+ * release/acquire, así que el consumidor nunca lee un byte a medio escribir. */
+static unsigned char pool[QISKIT_POOL_BYTES];
+static unsigned int pool_head = 0;
+static unsigned int pool_tail = 0;
+
+/* Estado privado del consumidor (hilo de juego) */
+static unsigned char consumer_byte = 0;
+static int consumer_bits_left = 0;
+static unsigned long stat_served = 0;
+static unsigned long stat_fallback = 0;
+
+/* Contadores del productor (leídos desde el hilo de juego) */
+static unsigned long stat_fetched = 0;
+static unsigned long stat_fetch_errors = 0;
+
 static bool last_connected = false;
+static bool batch_supported = true; /* Sólo lo modifica el productor */
+
+/* Estado de /measure (sólo hilo de medidas) */
+static bool measure_supported = true;
+static unsigned long stat_measure_remote = 0; /* Atómico */
+static unsigned long stat_measure_local = 0;  /* Sólo hilo de juego */
+/* Respuestas del servidor que llegaron a usarse, tickets que llegaron al
+ * commit sin respuesta y tickets cancelados con la petición en marcha (sólo
+ * hilo de juego) */
+static unsigned long stat_measure_used = 0;
+static unsigned long stat_measure_late = 0;
+static unsigned long stat_measure_dropped = 0;
+
+static void qiskit_sleep_ms(int ms) {
+#ifdef _WIN32
+    Sleep((DWORD)ms);
+#else
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static long long qiskit_now_ms(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/* Extrae el bit de una respuesta JSON de /generate_bit:
+ * {"success": true, "value": 0, ...} */
+static bool qiskit_parse_bit(const char *body, int *bit) {
+    const char *val_ptr = strstr(body, "\"value\":");
+    if (!val_ptr)
+        return false;
+    val_ptr += 8; /* skip "value": */
+    while (*val_ptr == ' ')
+        val_ptr++;
+    *bit = (*val_ptr == '1') ? 1 : 0;
+    return true;
+}
+
+/* ===== INSTRUMENTACIÓN ===== */
+
+/* Histograma de latencias log-lineal: cuatro cubos por octava de
+ * microsegundos, de 1 us a ~16 s. Los percentiles se dan por el límite
+ * superior del cubo (error < 19%). Los escriben el productor y el hilo de
+ * medidas, así que todos los contadores son atómicos. */
+#define QISKIT_HIST_BUCKETS 96
+#define QISKIT_TURN_BUCKETS 65 /* Bits por turno: 0..63 y 64 o más */
+
+typedef struct {
+    unsigned long count[QISKIT_HIST_BUCKETS];
+    unsigned long requests;
+    unsigned long timeouts;
+    unsigned long errors;
+    unsigned long parse_failures;
+    unsigned long long max_us;
+} QiskitRequestHist;
+
+static QiskitRequestHist request_hist[QISKIT_REQ_COUNT];
+
+/* Bits entregados al juego por turno. Por hilo: las estadísticas son las
+ * del hilo de juego y el solver juega turnos en varios a la vez */
+static QISKIT_THREAD_LOCAL unsigned long turn_hist[QISKIT_TURN_BUCKETS];
+static QISKIT_THREAD_LOCAL unsigned long stat_turns = 0;
+static QISKIT_THREAD_LOCAL unsigned long long stat_turn_bits = 0;
+static QISKIT_THREAD_LOCAL int turn_bits = 0;
+static QISKIT_THREAD_LOCAL int turn_bits_max = 0;
+
+/* Circuit breaker compartido por el productor y el hilo de medidas: tras
+ * QISKIT_BREAKER_FAILURES fallos seguidos (o respuestas más lentas que
+ * QISKIT_BREAKER_SLOW_MS) deja de pedir nada al servidor durante una
+ * ventana que se duplica en cada disparo. Al acabar la ventana pasa una
+ * sola petición de prueba; si falla, vuelve a abrirse. */
+static long long breaker_open_until = 0; /* 0: cerrado */
+static int breaker_failures = 0;
+static int breaker_backoff_ms = QISKIT_BREAKER_MIN_MS;
+static int breaker_probe = 0; /* Petición de prueba en vuelo */
+static unsigned long stat_breaker_trips = 0;
+
+static long long qiskit_now_us(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart / freq.QuadPart) * 1000000 +
+           (long long)(counter.QuadPart % freq.QuadPart) * 1000000 /
+               freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static int qiskit_hist_bucket(unsigned long long us) {
+    if (us < 4)
+        return (int)us;
+    int msb = 63 - __builtin_clzll(us);
+    int index = (msb - 1) * 4 + (int)((us >> (msb - 2)) & 3);
+    return index < QISKIT_HIST_BUCKETS ? index : QISKIT_HIST_BUCKETS - 1;
+}
+
+/* Límite superior (exclusivo) del cubo, en microsegundos */
+static unsigned long long qiskit_hist_upper(int index) {
+    if (index < 4)
+        return (unsigned long long)index + 1;
+    int msb = index / 4 + 1;
+    return (unsigned long long)(5 + index % 4) << (msb - 2);
+}
+
+/* Cubo en el que cae el cuantil q, o -1 si no hay muestras */
+static int qiskit_hist_rank(const unsigned long *count, int buckets,
+                            double q) {
+    unsigned long total = 0;
+    for (int i = 0; i < buckets; i++) {
+        total += count[i];
+    }
+    if (total == 0)
+        return -1;
+
+    unsigned long rank = (unsigned long)(q * (double)(total - 1)) + 1;
+    unsigned long seen = 0;
+    for (int i = 0; i < buckets; i++) {
+        seen += count[i];
+        if (seen >= rank)
+            return i;
+    }
+    return buckets - 1;
+}
+
+/* Fallo de parseo: respuesta 200 con un cuerpo que no se entiende */
+static void qiskit_note_parse_failure(QiskitRequestKind kind) {
+    __atomic_add_fetch(&request_hist[kind].parse_failures, 1,
+                       __ATOMIC_RELAXED);
+}
+
+/* Anota una petición (o ráfaga encadenada) que empezó en `start_us`.
+ * Un fallo que agota `timeout_ms` cuenta como timeout. */
+static void qiskit_note_request(QiskitRequestKind kind, long long start_us,
+                                bool ok, int timeout_ms) {
+    QiskitRequestHist *hist = &request_hist[kind];
+    unsigned long long us = (unsigned long long)(qiskit_now_us() - start_us);
+
+    __atomic_add_fetch(&hist->count[qiskit_hist_bucket(us)], 1,
+                       __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->requests, 1, __ATOMIC_RELAXED);
+    if (!ok) {
+        if (us + 1000 >= (unsigned long long)timeout_ms * 1000)
+            __atomic_add_fetch(&hist->timeouts, 1, __ATOMIC_RELAXED);
+        else
+            __atomic_add_fetch(&hist->errors, 1, __ATOMIC_RELAXED);
+    }
+
+    unsigned long long max = __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
+    while (us > max &&
+           !__atomic_compare_exchange_n(&hist->max_us, &max, us, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/* Devuelve verdadero si se puede hablar con el servidor ahora mismo */
+static bool qiskit_breaker_allow(void) {
+    long long until = __atomic_load_n(&breaker_open_until, __ATOMIC_ACQUIRE);
+    if (until == 0)
+        return true;
+    if (qiskit_now_ms() < until)
+        return false;
+    int idle = 0;
+    return __atomic_compare_exchange_n(&breaker_probe, &idle, 1, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* Resultado de una petición permitida por qiskit_breaker_allow() */
+static void qiskit_breaker_report(bool ok, long long start_us) {
+    if (ok && qiskit_now_us() - start_us <=
+                  (long long)QISKIT_BREAKER_SLOW_MS * 1000) {
+        __atomic_store_n(&breaker_failures, 0, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&breaker_open_until, __ATOMIC_ACQUIRE) != 0) {
+            __atomic_store_n(&breaker_backoff_ms, QISKIT_BREAKER_MIN_MS,
+                             __ATOMIC_RELAXED);
+            __atomic_store_n(&breaker_open_until, 0, __ATOMIC_RELEASE);
+            __atomic_store_n(&breaker_probe, 0, __ATOMIC_RELEASE);
+            printf("[Qiskit] Server responsive again\n");
+        }
+        return;
+    }
+
+    long long now = qiskit_now_ms();
+    bool probe = __atomic_load_n(&breaker_probe, __ATOMIC_ACQUIRE) != 0;
+    int failures = __atomic_add_fetch(&breaker_failures, 1, __ATOMIC_RELAXED);
+    if (!probe && failures < QISKIT_BREAKER_FAILURES)
+        return;
+    /* Ya abierto por el otro hilo: no alargar la ventana dos veces */
+    if (!probe && __atomic_load_n(&breaker_open_until, __ATOMIC_ACQUIRE) > now)
+        return;
+
+    int backoff = __atomic_load_n(&breaker_backoff_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&breaker_backoff_ms,
+                     backoff * 2 < QISKIT_BREAKER_MAX_MS ? backoff * 2
+                                                         : QISKIT_BREAKER_MAX_MS,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&breaker_failures, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&breaker_open_until, now + backoff, __ATOMIC_RELEASE);
+    __atomic_store_n(&breaker_probe, 0, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&stat_breaker_trips, 1, __ATOMIC_RELAXED);
+    printf("[Qiskit] Server not responding, pausing requests for %d ms\n",
+           backoff);
+}
+
+/* ===== TRANSPORTE WININET (WINDOWS) ===== */
+
+#ifdef _WIN32
+/* Petición bloqueante de un bit al servidor. Sólo se llama desde el hilo
+ * productor, nunca desde el hilo de juego. */
+static bool qiskit_fetch_bit(int *bit) {
+    if (!h_connect)
+        return false;
+
+    HINTERNET h_request = HttpOpenRequestA(h_connect, "GET", QISKIT_ENDPOINT,
+                                           NULL, NULL, NULL,
+                                           INTERNET_FLAG_KEEP_CONNECTION, 0);
+    if (!h_request)
+        return false;
+
+    BOOL sent = HttpSendRequestA(h_request, NULL, 0, NULL, 0);
+    if (!sent) {
+        InternetCloseHandle(h_request);
+        return false;
+    }
+
+    char buffer[512] = {0};
+    DWORD bytes_read = 0;
+    DWORD total_read = 0;
+
+    while (InternetReadFile(h_request, buffer + total_read,
+                            sizeof(buffer) - total_read - 1, &bytes_read)) {
+        if (bytes_read == 0)
+            break;
+        total_read += bytes_read;
+    }
+    buffer[total_read] = '\0';
+
+    InternetCloseHandle(h_request);
+    if (!qiskit_parse_bit(buffer, bit)) {
+        qiskit_note_parse_failure(QISKIT_REQ_BIT);
+        return false;
+    }
+    return true;
+}
+
+/* Petición bloqueante de un lote de bits empaquetados a /generate_bits.
+ * Devuelve los bytes leídos, -1 si falla la red o QISKIT_FETCH_UNSUPPORTED
+ * si el servidor responde sin cuerpo binario. */
+static int qiskit_fetch_batch(unsigned char *out, int max_bytes) {
+    if (!h_connect)
+        return -1;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s?n=%d", QISKIT_BATCH_ENDPOINT,
+             max_bytes * 8);
+
+    HINTERNET h_request =
+        HttpOpenRequestA(h_connect, "GET", path, NULL, NULL, NULL,
+                         INTERNET_FLAG_KEEP_CONNECTION, 0);
+    if (!h_request)
+        return -1;
+
+    if (!HttpSendRequestA(h_request, NULL, 0, NULL, 0)) {
+        InternetCloseHandle(h_request);
+        return -1;
+    }
+
+    /* Los servidores antiguos responden 200 en texto plano a rutas
+     * desconocidas: exigir el tipo binario antes de aceptar los bytes */
+    char content_type[64] = {0};
+    DWORD type_len = sizeof(content_type) - 1;
+    if (!HttpQueryInfoA(h_request, HTTP_QUERY_CONTENT_TYPE, content_type,
+                        &type_len, NULL) ||
+        !strstr(content_type, "octet-stream")) {
+        InternetCloseHandle(h_request);
+        return QISKIT_FETCH_UNSUPPORTED;
+    }
+
+    DWORD bytes_read = 0;
+    DWORD total_read = 0;
+    while (total_read < (DWORD)max_bytes &&
+           InternetReadFile(h_request, out + total_read,
+                            (DWORD)max_bytes - total_read, &bytes_read)) {
+        if (bytes_read == 0)
+            break;
+        total_read += bytes_read;
+    }
+
+    InternetCloseHandle(h_request);
+    return (int)total_read;
+}
+
+/* WinINet ya reutiliza la conexión: las peticiones van en serie */
+static int qiskit_fetch_batches(unsigned char *out, int batches) {
+    int total = 0;
+    for (int i = 0; i < batches; i++) {
+        int got = qiskit_fetch_batch(out + total, QISKIT_BATCH_BYTES);
+        if (got < 0)
+            return total > 0 ? total : got;
+        total += got;
+    }
+    return total;
+}
+
+static int qiskit_fetch_bits(int *bits, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!qiskit_fetch_bit(&bits[i]))
+            return i > 0 ? i : -1;
+    }
+    return count;
+}
+
+/* Mide en el servidor un qubit que vale 1 con probabilidad p. Devuelve el
+ * bit, -1 si falla la red o QISKIT_FETCH_UNSUPPORTED si no hay /measure. */
+static int qiskit_fetch_measure(const char *path) {
+    if (!h_connect)
+        return -1;
+
+    HINTERNET h_request =
+        HttpOpenRequestA(h_connect, "GET", path, NULL, NULL, NULL,
+                         INTERNET_FLAG_KEEP_CONNECTION, 0);
+    if (!h_request)
+        return -1;
+
+    DWORD timeout = QISKIT_MEASURE_TIMEOUT_MS;
+    InternetSetOptionA(h_request, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeout,
+                       sizeof(timeout));
+    InternetSetOptionA(h_request, INTERNET_OPTION_SEND_TIMEOUT, &timeout,
+                       sizeof(timeout));
+
+    if (!HttpSendRequestA(h_request, NULL, 0, NULL, 0)) {
+        InternetCloseHandle(h_request);
+        return -1;
+    }
+
+    DWORD status = 0;
+    DWORD status_len = sizeof(status);
+    HttpQueryInfoA(h_request, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER,
+                   &status, &status_len, NULL);
+
+    char buffer[512] = {0};
+    DWORD bytes_read = 0;
+    DWORD total_read = 0;
+    while (InternetReadFile(h_request, buffer + total_read,
+                            sizeof(buffer) - total_read - 1, &bytes_read)) {
+        if (bytes_read == 0)
+            break;
+        total_read += bytes_read;
+    }
+    buffer[total_read] = '\0';
+    InternetCloseHandle(h_request);
+
+    int bit;
+    if (status >= 500)
+        return -1; /* Servidor sin bits por ahora (503): no es que no exista */
+    if (status != 200)
+        return QISKIT_FETCH_UNSUPPORTED;
+    if (!qiskit_parse_bit(buffer, &bit)) {
+        qiskit_note_parse_failure(QISKIT_REQ_MEASURE);
+        return QISKIT_FETCH_UNSUPPORTED;
+    }
+    return bit;
+}
+#else
+
+/* ===== TRANSPORTE POSIX (HTTP/1.1 KEEP-ALIVE) ===== */
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define QISKIT_RECV_BUFFER 8192
+
+/* Conexión persistente: los bytes recibidos de más (respuestas encadenadas
+ * por pipelining) se quedan en `buf` para la siguiente lectura. */
+typedef struct {
+    int fd;
+    char buf[QISKIT_RECV_BUFFER + 1];
+    int buf_len;
+} QiskitConn;
+
+typedef struct {
+    int status;
+    bool binary;     /* Content-Type: application/octet-stream */
+    bool keep_alive; /* El servidor no pidió cerrar la conexión */
+} QiskitResponse;
+
+static QiskitConn producer_conn = {-1, {0}, 0};
+static QiskitConn measure_conn = {-1, {0}, 0}; /* Sólo hilo de medidas */
+
+static int qiskit_ms_left(long long deadline) {
+    long long left = deadline - qiskit_now_ms();
+    return left > 0 ? (int)left : 0;
+}
+
+static void qiskit_conn_close(QiskitConn *conn) {
+    if (conn->fd >= 0)
+        close(conn->fd);
+    conn->fd = -1;
+    conn->buf_len = 0;
+}
+
+/* connect() no bloqueante acotado por poll(): un servidor caído cuesta como
+ * mucho el timeout, nunca el SYN timeout del kernel. */
+static bool qiskit_conn_open(QiskitConn *conn, long long deadline) {
+    if (conn->fd >= 0)
+        return true;
+
+    char port[16];
+    snprintf(port, sizeof(port), "%d", server_port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(server_host, port, &hints, &res) != 0)
+        return false;
+
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        bool ok = connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+        if (!ok && errno == EINPROGRESS) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, qiskit_ms_left(deadline)) == 1) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                ok = err == 0;
+            }
+        }
+
+        if (ok) {
+            conn->fd = fd;
+            conn->buf_len = 0;
+            break;
+        }
+        close(fd);
+    }
+
+    freeaddrinfo(res);
+    return conn->fd >= 0;
+}
+
+static bool qiskit_conn_send(QiskitConn *conn, const char *data, int len,
+                             long long deadline) {
+    int sent = 0;
+    while (sent < len) {
+        ssize_t n = send(conn->fd, data + sent, len - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (int)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {conn->fd, POLLOUT, 0};
+            if (poll(&pfd, 1, qiskit_ms_left(deadline)) == 1)
+                continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+/* Añade al buffer lo que haya en el socket, esperando como mucho hasta
+ * `deadline`. Devuelve 1 si llegaron datos, 0 si el servidor cerró la
+ * conexión y -1 si se agotó el tiempo o hubo un error. */
+static int qiskit_conn_fill(QiskitConn *conn, long long deadline) {
+    if (conn->buf_len >= QISKIT_RECV_BUFFER)
+        return -1;
+
+    for (;;) {
+        ssize_t n = recv(conn->fd, conn->buf + conn->buf_len,
+                         QISKIT_RECV_BUFFER - conn->buf_len, 0);
+        if (n > 0) {
+            conn->buf_len += (int)n;
+            conn->buf[conn->buf_len] = '\0';
+            return 1;
+        }
+        if (n == 0)
+            return 0;
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return -1;
+
+        struct pollfd pfd = {conn->fd, POLLIN, 0};
+        if (poll(&pfd, 1, qiskit_ms_left(deadline)) != 1)
+            return -1;
+    }
+}
+
+/* Compara el nombre de la cabecera sin distinguir mayúsculas */
+static bool qiskit_header_is(const char *line, const char *name) {
+    size_t len = strlen(name);
+    for (size_t i = 0; i < len; i++) {
+        char c = line[i];
+        if (c >= 'A' && c <= 'Z')
+            c = (char)(c - 'A' + 'a');
+        if (c != name[i])
+            return false;
+    }
+    return line[len] == ':';
+}
+
+/* Lee una respuesta completa (cabeceras + cuerpo con Content-Length) y deja
+ * en el buffer lo que sobre. Copia como mucho `body_max` bytes del cuerpo a
+ * `body` y devuelve cuántos copió, o -1 si la conexión ya no es usable. */
+static int qiskit_conn_read_response(QiskitConn *conn, QiskitResponse *resp,
+                                     char *body, int body_max,
+                                     long long deadline) {
+    char *end;
+    conn->buf[conn->buf_len] = '\0';
+    while ((end = strstr(conn->buf, "\r\n\r\n")) == NULL) {
+        if (qiskit_conn_fill(conn, deadline) <= 0)
+            return -1;
+    }
+
+    int header_len = (int)(end - conn->buf) + 4;
+    int content_length = -1;
+    int minor = 0;
+    resp->status = 0;
+    resp->binary = false;
+
+    if (sscanf(conn->buf, "HTTP/1.%d %d", &minor, &resp->status) != 2)
+        return -1;
+    /* HTTP/1.0 cierra por defecto (quantum_server.py antiguo) */
+    resp->keep_alive = minor >= 1;
+
+    char *line = conn->buf;
+    while ((line = strstr(line, "\r\n")) != NULL && line < end) {
+        line += 2;
+        const char *value = strchr(line, ':');
+        if (!value || value > end)
+            continue;
+        value++;
+        while (*value == ' ')
+            value++;
+
+        if (qiskit_header_is(line, "content-length")) {
+            content_length = atoi(value);
+        } else if (qiskit_header_is(line, "content-type")) {
+            resp->binary = strncmp(value, "application/octet-stream", 24) == 0;
+        } else if (qiskit_header_is(line, "connection")) {
+            resp->keep_alive = strncmp(value, "close", 5) != 0;
+        }
+    }
+
+    /* Sin Content-Length el cuerpo termina cuando el servidor cierra, y la
+     * conexión ya no sirve para la siguiente respuesta */
+    if (content_length < 0) {
+        int rc;
+        while ((rc = qiskit_conn_fill(conn, deadline)) > 0) {
+        }
+        if (rc < 0)
+            return -1;
+        content_length = conn->buf_len - header_len;
+        resp->keep_alive = false;
+    }
+    if (header_len + content_length > QISKIT_RECV_BUFFER)
+        return -1;
+
+    while (conn->buf_len < header_len + content_length) {
+        if (qiskit_conn_fill(conn, deadline) <= 0)
+            return -1;
+    }
+
+    int copy = content_length < body_max ? content_length : body_max;
+    memcpy(body, conn->buf + header_len, copy);
+
+    int consumed = header_len + content_length;
+    memmove(conn->buf, conn->buf + consumed, conn->buf_len - consumed);
+    conn->buf_len -= consumed;
+    conn->buf[conn->buf_len] = '\0';
+    return copy;
+}
+
+/* Envía `count` peticiones GET seguidas (pipelining) por la conexión
+ * persistente, abriéndola si hace falta. */
+static bool qiskit_conn_send_requests(QiskitConn *conn, const char *path,
+                                      int count, long long deadline) {
+    char request[8 * 384];
+    int len = 0;
+    for (int i = 0; i < count && len < (int)sizeof(request); i++) {
+        len += snprintf(request + len, sizeof(request) - len,
+                        "GET %s HTTP/1.1\r\n"
+                        "Host: %s:%d\r\n"
+                        "User-Agent: PhaseShift/1.0\r\n"
+                        "Connection: keep-alive\r\n\r\n",
+                        path, server_host, server_port);
+    }
+    if (len >= (int)sizeof(request))
+        return false;
+
+    bool reused = conn->fd >= 0;
+    if (!qiskit_conn_open(conn, deadline))
+        return false;
+    if (qiskit_conn_send(conn, request, len, deadline))
+        return true;
+
+    /* El servidor pudo cerrar la conexión ociosa: un reintento limpio */
+    qiskit_conn_close(conn);
+    return reused && qiskit_conn_open(conn, deadline) &&
+           qiskit_conn_send(conn, request, len, deadline);
+}
+
+/* Pide `batches` lotes de QISKIT_BATCH_BYTES en una sola ráfaga y los lee
+ * en orden. Devuelve los bytes recibidos, -1 si no llegó ninguno o
+ * QISKIT_FETCH_UNSUPPORTED si el servidor no devuelve binario. */
+static int qiskit_fetch_batches(unsigned char *out, int batches) {
+    QiskitConn *conn = &producer_conn;
+    long long deadline = qiskit_now_ms() + QISKIT_TIMEOUT_MS;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s?n=%d", QISKIT_BATCH_ENDPOINT,
+             QISKIT_BATCH_BYTES * 8);
+    if (!qiskit_conn_send_requests(conn, path, batches, deadline)) {
+        qiskit_conn_close(conn);
+        return -1;
+    }
+
+    int total = 0;
+    for (int i = 0; i < batches; i++) {
+        QiskitResponse resp;
+        int got = qiskit_conn_read_response(
+            conn, &resp, (char *)out + total, QISKIT_BATCH_BYTES, deadline);
+        if (got < 0 || resp.status != 200) {
+            qiskit_conn_close(conn);
+            return total > 0 ? total : -1;
+        }
+        if (!resp.binary) {
+            qiskit_conn_close(conn);
+            return total > 0 ? total : QISKIT_FETCH_UNSUPPORTED;
+        }
+        total += got;
+        if (!resp.keep_alive) {
+            qiskit_conn_close(conn);
+            break;
+        }
+    }
+    return total;
+}
+
+/* Igual que qiskit_fetch_batches() pero contra /generate_bit, para
+ * servidores sin endpoint por lotes. Devuelve los bits leídos o -1. */
+static int qiskit_fetch_bits(int *bits, int count) {
+    QiskitConn *conn = &producer_conn;
+    long long deadline = qiskit_now_ms() + QISKIT_TIMEOUT_MS;
+
+    if (!qiskit_conn_send_requests(conn, QISKIT_ENDPOINT, count, deadline)) {
+        qiskit_conn_close(conn);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        QiskitResponse resp;
+        char body[512];
+        int got = qiskit_conn_read_response(conn, &resp, body,
+                                            sizeof(body) - 1, deadline);
+        if (got >= 0)
+            body[got] = '\0';
+        bool parsed = got >= 0 && resp.status == 200 &&
+                      qiskit_parse_bit(body, &bits[i]);
+        if (!parsed) {
+            if (got >= 0 && resp.status == 200)
+                qiskit_note_parse_failure(QISKIT_REQ_BIT);
+            qiskit_conn_close(conn);
+            return i > 0 ? i : -1;
+        }
+        if (!resp.keep_alive) {
+            qiskit_conn_close(conn);
+            return i + 1;
+        }
+    }
+    return count;
+}
+
+/* Mide en el servidor un qubit que vale 1 con probabilidad p. Devuelve el
+ * bit, -1 si falla la red o QISKIT_FETCH_UNSUPPORTED si no hay /measure. */
+static int qiskit_fetch_measure(const char *path) {
+    QiskitConn *conn = &measure_conn;
+    long long deadline = qiskit_now_ms() + QISKIT_MEASURE_TIMEOUT_MS;
+
+    if (!qiskit_conn_send_requests(conn, path, 1, deadline)) {
+        qiskit_conn_close(conn);
+        return -1;
+    }
+
+    QiskitResponse resp;
+    char body[512];
+    int got =
+        qiskit_conn_read_response(conn, &resp, body, sizeof(body) - 1, deadline);
+    if (got < 0) {
+        qiskit_conn_close(conn);
+        return -1;
+    }
+    body[got] = '\0';
+    if (!resp.keep_alive)
+        qiskit_conn_close(conn);
+
+    int bit;
+    if (resp.status >= 500)
+        return -1; /* Servidor sin bits por ahora (503): no es que no exista */
+    if (resp.status != 200)
+        return QISKIT_FETCH_UNSUPPORTED;
+    if (!qiskit_parse_bit(body, &bit)) {
+        qiskit_note_parse_failure(QISKIT_REQ_MEASURE);
+        return QISKIT_FETCH_UNSUPPORTED;
+    }
+    return bit;
+}
+#endif
+
+/* ===== PRODUCTOR ===== */
+
+/* Copia `count` bytes al pool y los publica de una vez */
+static void qiskit_pool_push(const unsigned char *bytes, int count) {
+    unsigned int head = __atomic_load_n(&pool_head, __ATOMIC_RELAXED);
+    for (int i = 0; i < count; i++) {
+        pool[(head + i) & QISKIT_POOL_MASK] = bytes[i];
+    }
+    __atomic_store_n(&pool_head, head + count, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&stat_fetched, (unsigned long)count * 8,
+                       __ATOMIC_RELAXED);
+}
+
+static void qiskit_producer_loop(void) {
+    unsigned char batch[QISKIT_PIPELINE_DEPTH * QISKIT_BATCH_BYTES];
+    unsigned char acc = 0;
+    int acc_bits = 0;
+
+    while (__atomic_load_n(&producer_running, __ATOMIC_ACQUIRE)) {
+        unsigned int head = __atomic_load_n(&pool_head, __ATOMIC_RELAXED);
+        unsigned int tail = __atomic_load_n(&pool_tail, __ATOMIC_ACQUIRE);
+        int free_bytes = QISKIT_POOL_BYTES - (int)(head - tail);
+
+        if (batch_supported) {
+            int batches = free_bytes / QISKIT_BATCH_BYTES;
+            if (batches > QISKIT_PIPELINE_DEPTH)
+                batches = QISKIT_PIPELINE_DEPTH;
+            if (batches == 0 || !qiskit_breaker_allow()) {
+                qiskit_sleep_ms(QISKIT_IDLE_MS);
+                continue;
+            }
+
+            long long start = qiskit_now_us();
+            int got = qiskit_fetch_batches(batch, batches);
+            qiskit_note_request(QISKIT_REQ_BATCH, start,
+                                got != -1, QISKIT_TIMEOUT_MS);
+            qiskit_breaker_report(got != -1, start);
+            if (got == QISKIT_FETCH_UNSUPPORTED) {
+                printf("[Qiskit] Server has no %s, fetching single bits\n",
+                       QISKIT_BATCH_ENDPOINT);
+                batch_supported = false;
+                continue;
+            }
+            if (got <= 0) {
+                __atomic_add_fetch(&stat_fetch_errors, 1, __ATOMIC_RELAXED);
+                qiskit_sleep_ms(QISKIT_IDLE_MS);
+                continue;
+            }
+            qiskit_pool_push(batch, got);
+            continue;
+        }
+
+        /* Servidor antiguo: un bit por petición, ocho peticiones por byte */
+        if (free_bytes <= 0 || !qiskit_breaker_allow()) {
+            qiskit_sleep_ms(QISKIT_IDLE_MS);
+            continue;
+        }
+
+        int bits[8];
+        long long start = qiskit_now_us();
+        int got = qiskit_fetch_bits(bits, 8 - acc_bits);
+        qiskit_note_request(QISKIT_REQ_BIT, start, got > 0,
+                            QISKIT_TIMEOUT_MS);
+        qiskit_breaker_report(got > 0, start);
+        if (got <= 0) {
+            __atomic_add_fetch(&stat_fetch_errors, 1, __ATOMIC_RELAXED);
+            qiskit_sleep_ms(QISKIT_IDLE_MS);
+            continue;
+        }
+
+        for (int i = 0; i < got; i++) {
+            acc = (unsigned char)((acc << 1) | bits[i]);
+        }
+        acc_bits += got;
+        if (acc_bits == 8) {
+            qiskit_pool_push(&acc, 1);
+            acc = 0;
+            acc_bits = 0;
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI qiskit_producer_main(LPVOID arg) {
+    (void)arg;
+    qiskit_producer_loop();
+    return 0;
+}
+#else
+static void *qiskit_producer_main(void *arg) {
+    (void)arg;
+    qiskit_producer_loop();
+    qiskit_conn_close(&producer_conn);
+    return NULL;
+}
+#endif
+
+static void qiskit_start_producer(void) {
+    __atomic_store_n(&producer_running, 1, __ATOMIC_RELEASE);
+#ifdef _WIN32
+    producer_thread =
+        CreateThread(NULL, 0, qiskit_producer_main, NULL, 0, NULL);
+    producer_started = producer_thread != NULL;
+#else
+    producer_started = pthread_create(&producer_thread, NULL,
+                                      qiskit_producer_main, NULL) == 0;
+#endif
+    if (!producer_started) {
+        __atomic_store_n(&producer_running, 0, __ATOMIC_RELEASE);
+        printf("[Qiskit] Could not start entropy producer, using local "
+               "fallback\n");
+    }
+}
+
+static void qiskit_stop_producer(void) {
+    if (!producer_started)
+        return;
+    __atomic_store_n(&producer_running, 0, __ATOMIC_RELEASE);
+#ifdef _WIN32
+    WaitForSingleObject(producer_thread, INFINITE);
+    CloseHandle(producer_thread);
+    producer_thread = NULL;
+#else
+    pthread_join(producer_thread, NULL);
+#endif
+    producer_started = false;
+}
+
+/* ===== MEDIDAS EN SEGUNDO PLANO ===== */
+
+/* Cola de peticiones a /measure. El hilo de juego encola (FREE -> QUEUED),
+ * el hilo de medidas la atiende (QUEUED -> BUSY -> DONE) y el juego recoge
+ * el resultado en el punto de commit del turno (DONE -> FREE). Todas las
+ * transiciones que pueden competir son CAS, así que no hace falta lock. */
+enum {
+    MEASURE_SLOT_FREE,
+    MEASURE_SLOT_QUEUED,
+    MEASURE_SLOT_BUSY,
+    MEASURE_SLOT_DONE,
+    MEASURE_SLOT_CANCELLED /* Abandonada mientras estaba en vuelo */
+};
+
+typedef struct {
+    int state;
+    float p;
+    int result;        /* Bit del servidor, o -1 para resolver en local */
+    unsigned long seq; /* Orden de llegada: se atiende la más antigua */
+} QiskitMeasureSlot;
+
+static QiskitMeasureSlot measure_slots[QISKIT_MEASURE_SLOTS];
+static unsigned long measure_seq = 0; /* Sólo hilo de juego */
+
+#ifdef _WIN32
+static HANDLE measure_thread = NULL;
+#else
+static pthread_t measure_thread;
+#endif
+static bool measure_started = false;
+static int measure_running = 0;
+
+static bool qiskit_slot_cas(QiskitMeasureSlot *slot, int from, int to) {
+    return __atomic_compare_exchange_n(&slot->state, &from, to, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* Una medida en el servidor (hilo de medidas). -1 si hay que resolverla en
+ * local: red caída, servidor sin /measure o circuit breaker abierto. */
+static int qiskit_measure_remote(float p) {
+    if (!measure_supported || !qiskit_breaker_allow())
+        return -1;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s?p=%.9g", QISKIT_MEASURE_ENDPOINT,
+             (double)p);
+
+    long long start = qiskit_now_us();
+    int bit = qiskit_fetch_measure(path);
+    qiskit_note_request(QISKIT_REQ_MEASURE, start, bit != -1,
+                        QISKIT_MEASURE_TIMEOUT_MS);
+    qiskit_breaker_report(bit != -1, start);
+    if (bit >= 0) {
+        __atomic_add_fetch(&stat_measure_remote, 1, __ATOMIC_RELAXED);
+        return bit;
+    }
+    if (bit == QISKIT_FETCH_UNSUPPORTED) {
+        printf("[Qiskit] Server has no %s, measuring from the pool\n",
+               QISKIT_MEASURE_ENDPOINT);
+        measure_supported = false;
+    }
+    return -1;
+}
+
+static void qiskit_measure_loop(void) {
+    while (__atomic_load_n(&measure_running, __ATOMIC_ACQUIRE)) {
+        QiskitMeasureSlot *next = NULL;
+        for (int i = 0; i < QISKIT_MEASURE_SLOTS; i++) {
+            QiskitMeasureSlot *slot = &measure_slots[i];
+            if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) ==
+                    MEASURE_SLOT_QUEUED &&
+                (!next || slot->seq < next->seq))
+                next = slot;
+        }
+
+        if (!next || !qiskit_slot_cas(next, MEASURE_SLOT_QUEUED,
+                                      MEASURE_SLOT_BUSY)) {
+            qiskit_sleep_ms(QISKIT_MEASURE_POLL_MS);
+            continue;
+        }
+
+        next->result = qiskit_measure_remote(next->p);
+        if (!qiskit_slot_cas(next, MEASURE_SLOT_BUSY, MEASURE_SLOT_DONE)) {
+            /* El juego ya no la quiere: el hueco vuelve a estar libre */
+            __atomic_store_n(&next->state, MEASURE_SLOT_FREE,
+                             __ATOMIC_RELEASE);
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI qiskit_measure_main(LPVOID arg) {
+    (void)arg;
+    qiskit_measure_loop();
+    return 0;
+}
+#else
+static void *qiskit_measure_main(void *arg) {
+    (void)arg;
+    qiskit_measure_loop();
+    qiskit_conn_close(&measure_conn);
+    return NULL;
+}
+#endif
+
+static void qiskit_start_measure_worker(void) {
+    memset(measure_slots, 0, sizeof(measure_slots));
+    __atomic_store_n(&measure_running, 1, __ATOMIC_RELEASE);
+#ifdef _WIN32
+    measure_thread = CreateThread(NULL, 0, qiskit_measure_main, NULL, 0, NULL);
+    measure_started = measure_thread != NULL;
+#else
+    measure_started = pthread_create(&measure_thread, NULL,
+                                     qiskit_measure_main, NULL) == 0;
+#endif
+    if (!measure_started) {
+        __atomic_store_n(&measure_running, 0, __ATOMIC_RELEASE);
+        printf("[Qiskit] Could not start measurement worker, measuring from "
+               "the pool\n");
+    }
+}
+
+static void qiskit_stop_measure_worker(void) {
+    if (!measure_started)
+        return;
+    __atomic_store_n(&measure_running, 0, __ATOMIC_RELEASE);
+#ifdef _WIN32
+    WaitForSingleObject(measure_thread, INFINITE);
+    CloseHandle(measure_thread);
+    measure_thread = NULL;
+#else
+    pthread_join(measure_thread, NULL);
+#endif
+    measure_started = false;
+}
+
+/* Encola una medida (hilo de juego). Devuelve el hueco, o -1 si no hay hilo
+ * de medidas o la cola está llena: entonces se resuelve en local. */
+static int qiskit_measure_submit(float p) {
+    if (!measure_started)
+        return -1;
+    for (int i = 0; i < QISKIT_MEASURE_SLOTS; i++) {
+        QiskitMeasureSlot *slot = &measure_slots[i];
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) !=
+            MEASURE_SLOT_FREE)
+            continue;
+        slot->p = p;
+        slot->result = -1;
+        slot->seq = measure_seq++;
+        __atomic_store_n(&slot->state, MEASURE_SLOT_QUEUED, __ATOMIC_RELEASE);
+        return i;
+    }
+    return -1;
+}
+
+static bool qiskit_measure_done(int index) {
+    return __atomic_load_n(&measure_slots[index].state, __ATOMIC_ACQUIRE) ==
+           MEASURE_SLOT_DONE;
+}
+
+/* Abandona una medida encolada; si está en vuelo la libera el hilo de
+ * medidas al terminar */
+static void qiskit_measure_release(int index) {
+    QiskitMeasureSlot *slot = &measure_slots[index];
+    for (;;) {
+        int state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+        if (state == MEASURE_SLOT_QUEUED || state == MEASURE_SLOT_DONE) {
+            if (qiskit_slot_cas(slot, state, MEASURE_SLOT_FREE))
+                return;
+        } else if (state == MEASURE_SLOT_BUSY) {
+            if (qiskit_slot_cas(slot, state, MEASURE_SLOT_CANCELLED))
+                return;
+        } else {
+            return;
+        }
+    }
+}
+
+/* Espera el resultado de una medida encolada (como mucho
+ * QISKIT_MEASURE_WAIT_MS) y libera el hueco. -1 si hay que resolverla en
+ * local. */
+static int qiskit_measure_collect(int index) {
+    QiskitMeasureSlot *slot = &measure_slots[index];
+    long long deadline = qiskit_now_ms() + QISKIT_MEASURE_WAIT_MS;
+    for (;;) {
+        if (qiskit_measure_done(index)) {
+            int result = slot->result;
+            __atomic_store_n(&slot->state, MEASURE_SLOT_FREE,
+                             __ATOMIC_RELEASE);
+            return result;
+        }
+        if (qiskit_now_ms() >= deadline)
+            break;
+        qiskit_sleep_ms(QISKIT_MEASURE_POLL_MS);
+    }
+    qiskit_measure_release(index);
+    return -1;
+}
+
+/* ===== BACKENDS ===== */
+
+/* Todas las fuentes de aleatoriedad cuántica implementan esta interfaz.
+ * measure() sólo recibe 0 < p < 1: los casos triviales no llegan aquí, así
+ * que no consumen bits ni quedan grabados en la cinta. */
+typedef struct {
+    const char *name;
+    void (*init)(void);
+    void (*shutdown)(void);
+    int (*random_bit)(void);
+    int (*measure)(float p);
+} QiskitBackend;
+
+/* Compara bit a bit un uniforme U = 0.b1b2b3... con la expansión binaria
+ * de p: la primera diferencia decide U < p. Probabilidad exacta (hasta la
+ * precisión de p) con dos bits de media. */
+static int qiskit_compare_measure(double p, int (*next_bit)(void)) {
+    for (int i = 0; i < 53 && p > 0.0; i++) {
+        p *= 2.0;
+        int p_bit = p >= 1.0;
+        p -= p_bit;
+        int u_bit = next_bit();
+        if (u_bit != p_bit)
+            return u_bit < p_bit;
+    }
+    return 0;
+}
+
+/* ----- Remoto: servidor HTTP + pool precargado ----- */
+
+static void remote_init(void) {
+    const char *env_host = getenv(QISKIT_ENV_HOST);
+    const char *env_port = getenv(QISKIT_ENV_PORT);
+    if (env_host && env_host[0]) {
+        snprintf(server_host, sizeof(server_host), "%s", env_host);
+    }
+    if (env_port && atoi(env_port) > 0 && atoi(env_port) < 65536) {
+        server_port = atoi(env_port);
+    }
 
-void qiskit_init(void) {
 #ifdef _WIN32
     h_internet = InternetOpenA("PhaseShift/1.0", INTERNET_OPEN_TYPE_DIRECT,
                                NULL, NULL, 0);
@@ -34,16 +1224,23 @@ void qiskit_init(void) {
         InternetSetOptionA(h_internet, INTERNET_OPTION_SEND_TIMEOUT, &timeout,
                            sizeof(timeout));
 
-        h_connect =
-            InternetConnectA(h_internet, QISKIT_SERVER_HOST, QISKIT_SERVER_PORT,
-                             NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
+        h_connect = InternetConnectA(h_internet, server_host,
+                                     (INTERNET_PORT)server_port, NULL, NULL,
+                                     INTERNET_SERVICE_HTTP, 0, 0);
     }
-    printf("[Qiskit] Initialized connection to %s:%d\n", QISKIT_SERVER_HOST,
-           QISKIT_SERVER_PORT);
 #endif
+    printf("[Qiskit] Initialized connection to %s:%d\n", server_host,
+           server_port);
+
+    qiskit_start_producer();
+    qiskit_start_measure_worker();
 }
 
-void qiskit_shutdown(void) {
+static void remote_shutdown(void) {
+    /* Parar los hilos antes de cerrar los handles que usan */
+    qiskit_stop_producer();
+    qiskit_stop_measure_worker();
+
 #ifdef _WIN32
     if (h_connect)
         InternetCloseHandle(h_connect);
@@ -52,65 +1249,303 @@ void qiskit_shutdown(void) {
     h_connect = NULL;
     h_internet = NULL;
 #endif
+
+    unsigned long total = stat_served + stat_fallback;
+    printf("[Qiskit] Pool: %lu bits cuanticos, %lu de respaldo local "
+           "(%.1f%%)\n",
+           stat_served, stat_fallback,
+           total > 0 ? 100.0 * (double)stat_fallback / (double)total : 0.0);
+    printf("[Qiskit] Medidas: %lu en el servidor (%lu usadas, %lu tarde, "
+           "%lu descartadas), %lu locales\n",
+           __atomic_load_n(&stat_measure_remote, __ATOMIC_RELAXED),
+           stat_measure_used, stat_measure_late, stat_measure_dropped,
+           stat_measure_local);
     printf("[Qiskit] Connection closed\n");
 }
 
-int qiskit_random_bit(void) {
-#ifdef _WIN32
-    if (!h_connect) {
-        last_connected = false;
-        return rand() % 2;
+static int remote_random_bit(void) {
+    if (consumer_bits_left == 0) {
+        unsigned int tail = __atomic_load_n(&pool_tail, __ATOMIC_RELAXED);
+        unsigned int head = __atomic_load_n(&pool_head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            /* Pool vacío: nunca esperar a la red en el hilo de juego */
+            stat_fallback++;
+            last_connected = false;
+            return rand() % 2;
+        }
+        consumer_byte = pool[tail & QISKIT_POOL_MASK];
+        consumer_bits_left = 8;
+        __atomic_store_n(&pool_tail, tail + 1, __ATOMIC_RELEASE);
     }
 
-    HINTERNET h_request = HttpOpenRequestA(h_connect, "GET", QISKIT_ENDPOINT,
-                                           NULL, NULL, NULL, 0, 0);
-    if (!h_request) {
-        last_connected = false;
-        return rand() % 2;
+    consumer_bits_left--;
+    stat_served++;
+    last_connected = true;
+    return (consumer_byte >> consumer_bits_left) & 1;
+}
+
+/* Medida resuelta con bits del pool, sin tocar la red */
+static int remote_measure_pool(float p) {
+    stat_measure_local++;
+    return qiskit_compare_measure((double)p, remote_random_bit);
+}
+
+/* Resultado de una medida encolada en `index` (-1: sin encolar): el del
+ * servidor si llega a tiempo, si no se resuelve con bits del pool */
+static int remote_measure_finish(int index, float p) {
+    int bit = index >= 0 ? qiskit_measure_collect(index) : -1;
+    if (bit >= 0) {
+        stat_measure_used++;
+        last_connected = true;
+        return bit;
     }
+    return remote_measure_pool(p);
+}
 
-    BOOL sent = HttpSendRequestA(h_request, NULL, 0, NULL, 0);
-    if (!sent) {
-        InternetCloseHandle(h_request);
-        last_connected = false;
-        return rand() % 2;
+static int remote_measure(float p) {
+    return remote_measure_finish(qiskit_measure_submit(p), p);
+}
+
+static const QiskitBackend remote_backend = {
+    "remote", remote_init, remote_shutdown, remote_random_bit, remote_measure};
+
+/* ----- Simulador local con semilla ----- */
+
+/* Emula los circuitos del servidor (H y RY medidos) con un generador
+ * SplitMix64: misma semilla, misma secuencia de resultados. Cada hilo lleva
+ * su generador (qiskit_seed_local siembra el del hilo que la llama). */
+static QISKIT_THREAD_LOCAL unsigned long long sim_state =
+    QISKIT_SIM_DEFAULT_SEED;
+static QISKIT_THREAD_LOCAL unsigned long long sim_word = 0;
+static QISKIT_THREAD_LOCAL int sim_bits_left = 0;
+
+static void sim_seed(unsigned long long seed) {
+    sim_state = seed;
+    sim_bits_left = 0;
+}
+
+static unsigned long long sim_next64(void) {
+    unsigned long long z = (sim_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void sim_seed_from_env(void) {
+    const char *env_seed = getenv(QISKIT_ENV_SEED);
+    if (env_seed && env_seed[0]) {
+        sim_seed(strtoull(env_seed, NULL, 0));
     }
+}
 
-    char buffer[512] = {0};
-    DWORD bytes_read = 0;
-    DWORD total_read = 0;
+static void sim_init(void) {
+    sim_seed_from_env();
+    printf("[Qiskit] Local simulator, seed %llu\n", sim_state);
+}
 
-    while (InternetReadFile(h_request, buffer + total_read,
-                            sizeof(buffer) - total_read - 1, &bytes_read)) {
-        if (bytes_read == 0)
-            break;
-        total_read += bytes_read;
+static void sim_shutdown(void) {}
+
+static int sim_random_bit(void) {
+    if (sim_bits_left == 0) {
+        sim_word = sim_next64();
+        sim_bits_left = 64;
     }
-    buffer[total_read] = '\0';
+    sim_bits_left--;
+    return (int)((sim_word >> sim_bits_left) & 1u);
+}
 
-    InternetCloseHandle(h_request);
+static int sim_measure(float p) {
+    return qiskit_compare_measure((double)p, sim_random_bit);
+}
 
-    /* Parse JSON: {"success": true, "value": 0, ...} */
-    /* Simple parse: find "value": and read the digit */
-    char *val_ptr = strstr(buffer, "\"value\":");
-    if (val_ptr) {
-        val_ptr += 8; /* skip "value": */
-        while (*val_ptr == ' ')
-            val_ptr++;
-        int bit = (*val_ptr == '1') ? 1 : 0;
-        last_connected = true;
-        return bit;
+static const QiskitBackend sim_backend = {"sim", sim_init, sim_shutdown,
+                                          sim_random_bit, sim_measure};
+
+/* ----- Cinta: reproduce resultados grabados ----- */
+
+/* Formato: QISKIT_TAPE_MAGIC (8 bytes), número de bits (uint64 little
+ * endian) y los bits empaquetados MSB primero. Cada bit es un resultado
+ * entregado al juego, tanto de qiskit_random_bit() como de las medidas, en
+ * el orden en que se pidieron. */
+static unsigned char *tape_data = NULL;
+static unsigned long long tape_bits = 0;
+static unsigned long long tape_pos = 0;
+static bool tape_exhausted = false;
+
+static bool tape_load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    unsigned char header[16];
+    bool ok = fread(header, 1, sizeof(header), f) == sizeof(header) &&
+              memcmp(header, QISKIT_TAPE_MAGIC, 8) == 0;
+    if (ok) {
+        tape_bits = 0;
+        for (int i = 7; i >= 0; i--) {
+            tape_bits = (tape_bits << 8) | header[8 + i];
+        }
+        size_t bytes = (size_t)((tape_bits + 7) / 8);
+        tape_data = malloc(bytes > 0 ? bytes : 1);
+        ok = tape_data && fread(tape_data, 1, bytes, f) == bytes;
     }
+    fclose(f);
 
-    /* Parse failed — fallback */
-    last_connected = false;
-    return rand() % 2;
-#else
-    last_connected = false;
-    return rand() % 2;
-#endif
+    if (!ok) {
+        free(tape_data);
+        tape_data = NULL;
+        tape_bits = 0;
+    }
+    tape_pos = 0;
+    tape_exhausted = false;
+    return ok;
+}
+
+static void tape_init(void) {
+    const char *path = getenv(QISKIT_ENV_TAPE);
+    if (!path || !tape_load(path)) {
+        printf("[Qiskit] Could not read tape '%s', using local simulator\n",
+               path ? path : "");
+        tape_exhausted = true;
+    } else {
+        printf("[Qiskit] Replaying %llu bits from %s\n", tape_bits, path);
+    }
+    sim_seed_from_env();
+}
+
+static void tape_shutdown(void) {
+    printf("[Qiskit] Tape: %llu/%llu bits replayed\n",
+           tape_pos < tape_bits ? tape_pos : tape_bits, tape_bits);
+    free(tape_data);
+    tape_data = NULL;
+    tape_bits = 0;
+}
+
+/* Siguiente bit grabado; al acabarse la cinta sigue el simulador con
+ * semilla, así que la partida continúa de forma reproducible */
+static int tape_next_bit(void) {
+    if (tape_pos < tape_bits) {
+        unsigned long long i = tape_pos++;
+        return (tape_data[i >> 3] >> (7 - (i & 7))) & 1;
+    }
+    if (!tape_exhausted) {
+        tape_exhausted = true;
+        printf("[Qiskit] Tape exhausted after %llu bits, continuing with "
+               "local simulator\n",
+               tape_bits);
+    }
+    return sim_random_bit();
 }
 
+static int tape_measure(float p) {
+    if (tape_pos < tape_bits)
+        return tape_next_bit();
+    return sim_measure(p);
+}
+
+static const QiskitBackend tape_backend = {"tape", tape_init, tape_shutdown,
+                                           tape_next_bit, tape_measure};
+
+static const QiskitBackend *backend = &remote_backend;
+
+/* ----- Grabación ----- */
+
+static FILE *record_file = NULL;
+static unsigned char record_byte = 0;
+static int record_fill = 0;
+static unsigned long long record_count = 0;
+
+static void record_open(const char *path) {
+    record_file = fopen(path, "wb");
+    if (!record_file) {
+        printf("[Qiskit] Could not open tape '%s' for recording\n", path);
+        return;
+    }
+    unsigned char header[16] = {0};
+    memcpy(header, QISKIT_TAPE_MAGIC, 8);
+    fwrite(header, 1, sizeof(header), record_file);
+    record_byte = 0;
+    record_fill = 0;
+    record_count = 0;
+    printf("[Qiskit] Recording results to %s\n", path);
+}
+
+static int record_bit(int bit) {
+    if (record_file) {
+        record_byte = (unsigned char)((record_byte << 1) | (bit & 1));
+        if (++record_fill == 8) {
+            fputc(record_byte, record_file);
+            record_byte = 0;
+            record_fill = 0;
+        }
+        record_count++;
+    }
+    return bit;
+}
+
+static void record_close(void) {
+    if (!record_file)
+        return;
+    if (record_fill > 0) {
+        fputc((unsigned char)(record_byte << (8 - record_fill)), record_file);
+    }
+
+    /* Cabecera con el número final de bits */
+    unsigned char count[8];
+    for (int i = 0; i < 8; i++) {
+        count[i] = (unsigned char)(record_count >> (8 * i));
+    }
+    fseek(record_file, 8, SEEK_SET);
+    fwrite(count, 1, sizeof(count), record_file);
+    fclose(record_file);
+    record_file = NULL;
+    printf("[Qiskit] Recorded %llu bits\n", record_count);
+}
+
+/* ===== API PÚBLICA ===== */
+
+void qiskit_init(void) {
+    const char *env_backend = getenv(QISKIT_ENV_BACKEND);
+    if (env_backend && strcmp(env_backend, sim_backend.name) == 0) {
+        backend = &sim_backend;
+    } else if (env_backend && strcmp(env_backend, tape_backend.name) == 0) {
+        backend = &tape_backend;
+    } else {
+        if (env_backend && env_backend[0] &&
+            strcmp(env_backend, remote_backend.name) != 0) {
+            printf("[Qiskit] Unknown backend '%s', using remote\n",
+                   env_backend);
+        }
+        backend = &remote_backend;
+    }
+
+    const char *record_path = getenv(QISKIT_ENV_RECORD);
+    if (record_path && record_path[0]) {
+        record_open(record_path);
+    }
+
+    backend->init();
+}
+
+void qiskit_shutdown(void) {
+    backend->shutdown();
+    record_close();
+
+    const char *stats_path = getenv(QISKIT_ENV_STATS);
+    if (stats_path && stats_path[0] && qiskit_dump_stats(stats_path)) {
+        printf("[Qiskit] Stats written to %s\n", stats_path);
+    }
+}
+
+/* Todo bit que llega al juego pasa por aquí: cuenta para el turno y se
+ * graba en la cinta si hay grabación */
+static int qiskit_deliver(int bit) {
+    turn_bits++;
+    return record_bit(bit);
+}
+
+int qiskit_random_bit(void) { return qiskit_deliver(backend->random_bit()); }
+
 float qiskit_random_float(void) {
     /* Construir float de múltiples bits cuánticos para mejor resolución */
     int bits = 0;
@@ -120,4 +1555,239 @@ float qiskit_random_float(void) {
     return (float)bits / 256.0f;
 }
 
-bool qiskit_is_connected(void) { return last_connected; }
+QiskitMeasureTicket qiskit_measure_async(float p) {
+    QiskitMeasureTicket ticket;
+    ticket.p = p;
+    ticket.slot = -1;
+    ticket.pending = p > 0.0f && p < 1.0f;
+    ticket.outcome = p >= 1.0f;
+
+    /* Sólo el backend remoto tiene latencia que solapar; los locales
+     * resuelven en el commit para consumir bits en el mismo orden que la
+     * API síncrona (y que la cinta grabada) */
+    if (ticket.pending && backend == &remote_backend)
+        ticket.slot = qiskit_measure_submit(p);
+    return ticket;
+}
+
+bool qiskit_measure_ready(const QiskitMeasureTicket *ticket) {
+    return !ticket->pending || ticket->slot < 0 ||
+           qiskit_measure_done(ticket->slot);
+}
+
+int qiskit_measure_resolve(QiskitMeasureTicket *ticket) {
+    if (!ticket->pending)
+        return ticket->outcome;
+
+    int bit = ticket->slot >= 0 ? remote_measure_finish(ticket->slot, ticket->p)
+                                : backend->measure(ticket->p);
+    ticket->slot = -1;
+    ticket->pending = false;
+    ticket->outcome = qiskit_deliver(bit);
+    return ticket->outcome;
+}
+
+int qiskit_measure_resolve_now(QiskitMeasureTicket *ticket) {
+    if (!ticket->pending)
+        return ticket->outcome;
+
+    if (ticket->slot >= 0 && qiskit_measure_done(ticket->slot)) {
+        int bit = remote_measure_finish(ticket->slot, ticket->p);
+        ticket->outcome = qiskit_deliver(bit);
+    } else {
+        /* Sin respuesta todavía: se abandona la petición */
+        if (ticket->slot >= 0) {
+            qiskit_measure_release(ticket->slot);
+            stat_measure_late++;
+        }
+        ticket->outcome = qiskit_measure_now(ticket->p);
+    }
+    ticket->slot = -1;
+    ticket->pending = false;
+    return ticket->outcome;
+}
+
+void qiskit_measure_cancel(QiskitMeasureTicket *ticket) {
+    if (ticket->pending && ticket->slot >= 0) {
+        qiskit_measure_release(ticket->slot);
+        stat_measure_dropped++;
+    }
+    ticket->slot = -1;
+    ticket->pending = false;
+}
+
+int qiskit_measure_now(float p) {
+    if (p <= 0.0f || p >= 1.0f)
+        return p >= 1.0f;
+    /* El backend remoto no va a la red, los locales nunca la tocan */
+    int bit = backend == &remote_backend ? remote_measure_pool(p)
+                                         : backend->measure(p);
+    return qiskit_deliver(bit);
+}
+
+void qiskit_set_local_only(bool enabled) {
+    backend = enabled ? &sim_backend : &remote_backend;
+}
+
+void qiskit_seed_local(unsigned long long seed) { sim_seed(seed); }
+
+const char *qiskit_backend_name(void) { return backend->name; }
+
+bool qiskit_is_connected(void) {
+    return backend == &remote_backend && last_connected;
+}
+
+void qiskit_get_pool_stats(QiskitPoolStats *out) {
+    unsigned int tail = __atomic_load_n(&pool_tail, __ATOMIC_RELAXED);
+    unsigned int head = __atomic_load_n(&pool_head, __ATOMIC_ACQUIRE);
+
+    out->bits_served = stat_served;
+    out->bits_fallback = stat_fallback;
+    out->bits_fetched = __atomic_load_n(&stat_fetched, __ATOMIC_RELAXED);
+    out->fetch_errors = __atomic_load_n(&stat_fetch_errors, __ATOMIC_RELAXED);
+    out->pool_level = (int)(head - tail) * 8 + consumer_bits_left;
+    out->pool_capacity = QISKIT_POOL_BYTES * 8;
+    out->measure_remote =
+        __atomic_load_n(&stat_measure_remote, __ATOMIC_RELAXED);
+    out->measure_local = stat_measure_local;
+    out->measure_used = stat_measure_used;
+    out->measure_late = stat_measure_late;
+    out->measure_dropped = stat_measure_dropped;
+}
+
+void qiskit_mark_turn(void) {
+    int bucket = turn_bits < QISKIT_TURN_BUCKETS - 1 ? turn_bits
+                                                     : QISKIT_TURN_BUCKETS - 1;
+    turn_hist[bucket]++;
+    stat_turns++;
+    stat_turn_bits += (unsigned long long)turn_bits;
+    if (turn_bits > turn_bits_max)
+        turn_bits_max = turn_bits;
+    turn_bits = 0;
+}
+
+void qiskit_get_client_stats(QiskitClientStats *out) {
+    memset(out, 0, sizeof(*out));
+
+    for (int k = 0; k < QISKIT_REQ_COUNT; k++) {
+        QiskitRequestHist *hist = &request_hist[k];
+        QiskitRequestStats *req = &out->requests[k];
+        unsigned long count[QISKIT_HIST_BUCKETS];
+        for (int i = 0; i < QISKIT_HIST_BUCKETS; i++) {
+            count[i] = __atomic_load_n(&hist->count[i], __ATOMIC_RELAXED);
+        }
+
+        req->requests = __atomic_load_n(&hist->requests, __ATOMIC_RELAXED);
+        req->timeouts = __atomic_load_n(&hist->timeouts, __ATOMIC_RELAXED);
+        req->errors = __atomic_load_n(&hist->errors, __ATOMIC_RELAXED);
+        req->parse_failures =
+            __atomic_load_n(&hist->parse_failures, __ATOMIC_RELAXED);
+        req->max_ms =
+            (float)__atomic_load_n(&hist->max_us, __ATOMIC_RELAXED) / 1000.0f;
+
+        static const double quantiles[3] = {0.50, 0.95, 0.99};
+        float *dest[3] = {&req->p50_ms, &req->p95_ms, &req->p99_ms};
+        for (int q = 0; q < 3; q++) {
+            int bucket = qiskit_hist_rank(count, QISKIT_HIST_BUCKETS,
+                                          quantiles[q]);
+            *dest[q] = bucket < 0
+                           ? 0.0f
+                           : (float)qiskit_hist_upper(bucket) / 1000.0f;
+            if (*dest[q] > req->max_ms)
+                *dest[q] = req->max_ms;
+        }
+    }
+
+    long long until = __atomic_load_n(&breaker_open_until, __ATOMIC_ACQUIRE);
+    long long now = qiskit_now_ms();
+    if (until == 0) {
+        out->breaker = QISKIT_BREAKER_CLOSED;
+    } else if (now < until) {
+        out->breaker = QISKIT_BREAKER_OPEN;
+        out->breaker_retry_ms = (int)(until - now);
+    } else {
+        out->breaker = QISKIT_BREAKER_HALF_OPEN;
+    }
+    out->breaker_trips =
+        __atomic_load_n(&stat_breaker_trips, __ATOMIC_RELAXED);
+
+    out->turns = stat_turns;
+    out->bits_per_turn_mean =
+        stat_turns > 0 ? (float)((double)stat_turn_bits / (double)stat_turns)
+                       : 0.0f;
+    out->bits_per_turn_p50 = qiskit_hist_rank(turn_hist, QISKIT_TURN_BUCKETS,
+                                              0.50);
+    out->bits_per_turn_p95 = qiskit_hist_rank(turn_hist, QISKIT_TURN_BUCKETS,
+                                              0.95);
+    out->bits_per_turn_p99 = qiskit_hist_rank(turn_hist, QISKIT_TURN_BUCKETS,
+                                              0.99);
+    if (stat_turns == 0) {
+        out->bits_per_turn_p50 = 0;
+        out->bits_per_turn_p95 = 0;
+        out->bits_per_turn_p99 = 0;
+    }
+    out->bits_per_turn_max = turn_bits_max;
+}
+
+int qiskit_format_stats(char *buf, int size) {
+    static const char *kind_names[QISKIT_REQ_COUNT] = {"batch", "bit",
+                                                       "measure"};
+    static const char *breaker_names[] = {"closed", "open", "half-open"};
+
+    QiskitClientStats stats;
+    QiskitPoolStats pool;
+    qiskit_get_client_stats(&stats);
+    qiskit_get_pool_stats(&pool);
+
+    int len = 0;
+#define QISKIT_APPEND(...)                                                     \
+    do {                                                                       \
+        if (len < size)                                                        \
+            len += snprintf(buf + len, (size_t)(size - len), __VA_ARGS__);     \
+    } while (0)
+
+    QISKIT_APPEND("Qiskit backend: %s (%s)\n", backend->name,
+                  qiskit_is_connected() ? "connected" : "local");
+    QISKIT_APPEND("breaker: %s", breaker_names[stats.breaker]);
+    if (stats.breaker == QISKIT_BREAKER_OPEN)
+        QISKIT_APPEND(", retry in %d ms", stats.breaker_retry_ms);
+    QISKIT_APPEND(", %lu trips\n", stats.breaker_trips);
+
+    QISKIT_APPEND("%-8s %7s %7s %7s %7s %8s %8s %8s %8s\n", "request",
+                  "count", "timeout", "error", "parse", "p50 ms", "p95 ms",
+                  "p99 ms", "max ms");
+    for (int k = 0; k < QISKIT_REQ_COUNT; k++) {
+        const QiskitRequestStats *req = &stats.requests[k];
+        QISKIT_APPEND("%-8s %7lu %7lu %7lu %7lu %8.2f %8.2f %8.2f %8.2f\n",
+                      kind_names[k], req->requests, req->timeouts,
+                      req->errors, req->parse_failures, req->p50_ms,
+                      req->p95_ms, req->p99_ms, req->max_ms);
+    }
+
+    QISKIT_APPEND("pool: %d/%d bits, %lu served, %lu fallback, %lu fetched\n",
+                  pool.pool_level, pool.pool_capacity, pool.bits_served,
+                  pool.bits_fallback, pool.bits_fetched);
+    QISKIT_APPEND("measure: %lu remote (%lu used, %lu late, %lu dropped), "
+                  "%lu local\n",
+                  pool.measure_remote, pool.measure_used, pool.measure_late,
+                  pool.measure_dropped, pool.measure_local);
+    QISKIT_APPEND("bits/turn: mean %.2f, p50 %d, p95 %d, p99 %d, max %d "
+                  "(%lu turns)\n",
+                  stats.bits_per_turn_mean, stats.bits_per_turn_p50,
+                  stats.bits_per_turn_p95, stats.bits_per_turn_p99,
+                  stats.bits_per_turn_max, stats.turns);
+#undef QISKIT_APPEND
+
+    return len < size ? len : size - 1;
+}
+
+bool qiskit_dump_stats(const char *path) {
+    char text[2048];
+    qiskit_format_stats(text, sizeof(text));
+
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+    bool ok = fputs(text, f) >= 0;
+    return fclose(f) == 0 && ok;
+}
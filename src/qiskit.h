@@ -3,21 +3,148 @@
 
 #include <stdbool.h>
 
-/* Inicializar conexión Qiskit (llamar una vez al inicio) */
+/* Estadísticas del pool de entropía cuántica */
+typedef struct {
+    unsigned long bits_served;   /* Bits entregados desde el pool */
+    unsigned long bits_fallback; /* Bits generados con rand() (pool vacío) */
+    unsigned long bits_fetched;  /* Bits recibidos del servidor */
+    unsigned long fetch_errors;  /* Peticiones fallidas del productor */
+    int pool_level;              /* Bits disponibles ahora mismo */
+    int pool_capacity;
+    unsigned long measure_remote;  /* Medidas sesgadas hechas en el servidor */
+    unsigned long measure_local;   /* Medidas sesgadas resueltas con el pool */
+    unsigned long measure_used;    /* Respuestas del servidor usadas */
+    unsigned long measure_late;    /* Tickets sin respuesta en el commit */
+    unsigned long measure_dropped; /* Tickets cancelados sin usarse */
+} QiskitPoolStats;
+
+/* Tipos de petición al servidor con histograma de latencias propio */
+typedef enum {
+    QISKIT_REQ_BATCH,   /* Ráfaga de lotes a /generate_bits (productor) */
+    QISKIT_REQ_BIT,     /* Ráfaga a /generate_bit (servidores antiguos) */
+    QISKIT_REQ_MEASURE, /* /measure (hilo de medidas) */
+    QISKIT_REQ_COUNT
+} QiskitRequestKind;
+
+typedef enum {
+    QISKIT_BREAKER_CLOSED,   /* Peticiones normales */
+    QISKIT_BREAKER_OPEN,     /* Servidor lento o caído: sin peticiones */
+    QISKIT_BREAKER_HALF_OPEN /* Ventana cumplida: se deja pasar una prueba */
+} QiskitBreakerState;
+
+typedef struct {
+    unsigned long requests;
+    unsigned long timeouts;
+    unsigned long errors;         /* Fallos de red que no son timeout */
+    unsigned long parse_failures; /* Respuestas 200 con cuerpo inválido */
+    float p50_ms;
+    float p95_ms;
+    float p99_ms;
+    float max_ms;
+} QiskitRequestStats;
+
+/* Instrumentación del cliente (debug overlay, volcado a fichero) */
+typedef struct {
+    QiskitRequestStats requests[QISKIT_REQ_COUNT];
+    QiskitBreakerState breaker;
+    int breaker_retry_ms; /* Hasta la siguiente prueba si está abierto */
+    unsigned long breaker_trips;
+    unsigned long turns;
+    float bits_per_turn_mean;
+    int bits_per_turn_p50;
+    int bits_per_turn_p95;
+    int bits_per_turn_p99;
+    int bits_per_turn_max;
+} QiskitClientStats;
+
+/* Inicializar el backend elegido con PHASE_SHIFT_QISKIT_BACKEND (llamar una
+ * vez al inicio):
+ *   remote  servidor Qiskit por HTTP con pool precargado (por defecto)
+ *   sim     simulador local con semilla PHASE_SHIFT_QISKIT_SEED, sin red
+ *   tape    reproduce la cinta PHASE_SHIFT_QISKIT_TAPE bit a bit
+ * Con PHASE_SHIFT_QISKIT_RECORD=<fichero> se graba en una cinta cada
+ * resultado entregado al juego, sea cual sea el backend, y con
+ * PHASE_SHIFT_QISKIT_STATS=<fichero> se vuelcan las estadísticas al salir. */
 void qiskit_init(void);
 
-/* Cerrar conexión Qiskit (llamar una vez al limpiar) */
+/* Cerrar el backend y la cinta de grabación (llamar una vez al limpiar) */
 void qiskit_shutdown(void);
 
-/* Obtener bit aleatorio cuántico (0 o 1) del servidor Qiskit.
- * Usa rand() local si servidor no disponible. */
+/* Obtener bit aleatorio cuántico (0 o 1) del pool precargado.
+ * Nunca bloquea: usa rand() local si el pool está vacío. */
 int qiskit_random_bit(void);
 
 /* Obtener float aleatorio cuántico [0.0, 1.0) del servidor Qiskit.
  * Usa bit cuántico como fuente de aleatoriedad. */
 float qiskit_random_float(void);
 
-/* Devuelve verdadero si última llamada usó servidor Qiskit real */
+/* Medida pendiente (future). Se pide al principio del turno con
+ * qiskit_measure_async() y se recoge en el punto de commit con
+ * qiskit_measure_resolve_now(): mientras tanto la petición a /measure viaja
+ * en un hilo aparte y el turno sigue simulando. Cada ticket debe resolverse o
+ * cancelarse una vez. */
+typedef struct {
+    float p;
+    int slot;     /* Hueco de la cola de medidas, -1 si no hay petición */
+    bool pending; /* Falta resolver o cancelar */
+    int outcome;  /* Resultado una vez resuelto */
+} QiskitMeasureTicket;
+
+/* Encolar la medida sin bloquear. Con p <= 0 o p >= 1 no se hace petición. */
+QiskitMeasureTicket qiskit_measure_async(float p);
+
+/* Devuelve verdadero si qiskit_measure_resolve() no va a esperar a la red */
+bool qiskit_measure_ready(const QiskitMeasureTicket *ticket);
+
+/* Obtener el resultado (0 o 1). Si la respuesta aún no ha llegado espera
+ * como mucho 300 ms (timeout de /measure más margen) y después resuelve con
+ * el pool. Sólo para herramientas que pueden esperar; el juego no la usa. */
+int qiskit_measure_resolve(QiskitMeasureTicket *ticket);
+
+/* Como qiskit_measure_resolve() pero sin esperar nunca: si la respuesta no
+ * ha llegado se cancela la petición y se resuelve ya con bits del pool
+ * (probabilidad exacta). Es la que usa el hilo de juego. */
+int qiskit_measure_resolve_now(QiskitMeasureTicket *ticket);
+
+/* Descartar una medida que ya no hace falta; no consume bits ni se graba */
+void qiskit_measure_cancel(QiskitMeasureTicket *ticket);
+
+/* Medir ya un qubit que vale 1 con probabilidad p, sin pedir nada al
+ * servidor: con el backend remoto se resuelve con bits del pool
+ * (probabilidad exacta). Para medidas que se necesitan en el acto y no
+ * tienen un turno con el que solapar la petición, como las del simulador de
+ * statevector. */
+int qiskit_measure_now(float p);
+
+/* Usar el simulador local con semilla en vez del servidor (para
+ * herramientas y benchmarks que no llaman a qiskit_init) */
+void qiskit_set_local_only(bool enabled);
+
+/* Reiniciar el simulador local con otra semilla: a partir de aquí da la
+ * misma secuencia que si hubiera arrancado con ella (QISKIT_SEED) */
+void qiskit_seed_local(unsigned long long seed);
+
+/* Nombre del backend activo: "remote", "sim" o "tape" */
+const char *qiskit_backend_name(void);
+
+/* Devuelve verdadero si el último bit entregado vino del servidor Qiskit */
 bool qiskit_is_connected(void);
 
+/* Copia las estadísticas actuales del pool */
+void qiskit_get_pool_stats(QiskitPoolStats *out);
+
+/* Cierra el turno actual en el histograma de bits consumidos por turno */
+void qiskit_mark_turn(void);
+
+/* Copia latencias, contadores de fallos, estado del circuit breaker y bits
+ * por turno */
+void qiskit_get_client_stats(QiskitClientStats *out);
+
+/* Escribe un informe legible de las estadísticas en `buf` (varias líneas).
+ * Devuelve la longitud escrita. */
+int qiskit_format_stats(char *buf, int size);
+
+/* Vuelca el informe de qiskit_format_stats() a un fichero */
+bool qiskit_dump_stats(const char *path);
+
 #endif
@@ -1,109 +1,654 @@
 #include "quantum.h"
+#include "events.h"
 #include "qiskit.h"
 #include "utils.h"
 #include <math.h>
 
-/* ===== QUBIT LOGIC ===== */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QSIM_X86 1
+#include <immintrin.h>
+#endif
 
-void init_qubit(Qubit *q) {
-    q->alpha_real = 1.0f;
-    q->alpha_imag = 0.0f;
-    q->beta_real = 0.0f;
-    q->beta_imag = 0.0f;
-    q->is_measured = false;
-    q->measured_value = 0;
-    q->active = true;
+/* ===== STATEVECTOR KERNELS ===== */
+
+#define QSIM_MAX_QUBITS 30
+#define QSIM_ALIGNMENT 32
+
+#define QSIM_INV_SQRT2 0.70710678118654752f
+
+const QGate QGATE_HADAMARD = {
+    {QSIM_INV_SQRT2, QSIM_INV_SQRT2, QSIM_INV_SQRT2, -QSIM_INV_SQRT2},
+    {0.0f, 0.0f, 0.0f, 0.0f}};
+const QGate QGATE_PAULI_X = {{0.0f, 1.0f, 1.0f, 0.0f},
+                             {0.0f, 0.0f, 0.0f, 0.0f}};
+
+/* Todos los kernels recorren los pares (i, i | stride) con el bit `target`
+ * a 0 en i y aplican la puerta sólo si i contiene todos los bits de
+ * `cmask` (controles; 0 = puerta sin control). */
+
+static void qsim_kernel_scalar(float *re, float *im, int num_qubits,
+                               int target, unsigned cmask, const QGate *g) {
+    unsigned n = 1u << num_qubits;
+    unsigned stride = 1u << target;
+
+    for (unsigned base = 0; base < n; base += 2 * stride) {
+        for (unsigned i = base; i < base + stride; i++) {
+            if ((i & cmask) != cmask)
+                continue;
+            unsigned j = i + stride;
+            float r0 = re[i], i0 = im[i], r1 = re[j], i1 = im[j];
+
+            re[i] = g->re[0] * r0 - g->im[0] * i0 + g->re[1] * r1 -
+                    g->im[1] * i1;
+            im[i] = g->re[0] * i0 + g->im[0] * r0 + g->re[1] * i1 +
+                    g->im[1] * r1;
+            re[j] = g->re[2] * r0 - g->im[2] * i0 + g->re[3] * r1 -
+                    g->im[3] * i1;
+            im[j] = g->re[2] * i0 + g->im[2] * r0 + g->re[3] * i1 +
+                    g->im[3] * r1;
+        }
+    }
 }
 
-void apply_hadamard_gate(Qubit *q) {
-    if (q->is_measured)
+#ifdef QSIM_X86
+/* 4 amplitudes por registro SIMD: requiere stride >= 4 (target >= 2). Los
+ * controles por debajo del bit 2 varían dentro del registro y se resuelven
+ * con una máscara por carril; los de arriba, por bloque. Cargas sin
+ * alinear: GameState puede vivir en la pila o en memoria de malloc(). */
+__attribute__((target("sse"))) static void
+qsim_kernel_sse(float *re, float *im, int num_qubits, int target,
+                unsigned cmask, const QGate *g) {
+    unsigned n = 1u << num_qubits;
+    unsigned stride = 1u << target;
+    unsigned hi_mask = cmask & ~3u;
+    unsigned lo_mask = cmask & 3u;
+
+    union {
+        unsigned bits[4];
+        float f[4];
+    } lanes;
+    for (unsigned l = 0; l < 4; l++) {
+        lanes.bits[l] = (l & lo_mask) == lo_mask ? 0xFFFFFFFFu : 0u;
+    }
+    __m128 lane = _mm_loadu_ps(lanes.f);
+
+    __m128 u0r = _mm_set1_ps(g->re[0]), u0i = _mm_set1_ps(g->im[0]);
+    __m128 u1r = _mm_set1_ps(g->re[1]), u1i = _mm_set1_ps(g->im[1]);
+    __m128 u2r = _mm_set1_ps(g->re[2]), u2i = _mm_set1_ps(g->im[2]);
+    __m128 u3r = _mm_set1_ps(g->re[3]), u3i = _mm_set1_ps(g->im[3]);
+
+    for (unsigned base = 0; base < n; base += 2 * stride) {
+        for (unsigned i = base; i < base + stride; i += 4) {
+            if ((i & hi_mask) != hi_mask)
+                continue;
+            unsigned j = i + stride;
+            __m128 r0 = _mm_loadu_ps(re + i), i0 = _mm_loadu_ps(im + i);
+            __m128 r1 = _mm_loadu_ps(re + j), i1 = _mm_loadu_ps(im + j);
+
+            __m128 nr0 = _mm_add_ps(
+                _mm_sub_ps(_mm_mul_ps(u0r, r0), _mm_mul_ps(u0i, i0)),
+                _mm_sub_ps(_mm_mul_ps(u1r, r1), _mm_mul_ps(u1i, i1)));
+            __m128 ni0 = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(u0r, i0), _mm_mul_ps(u0i, r0)),
+                _mm_add_ps(_mm_mul_ps(u1r, i1), _mm_mul_ps(u1i, r1)));
+            __m128 nr1 = _mm_add_ps(
+                _mm_sub_ps(_mm_mul_ps(u2r, r0), _mm_mul_ps(u2i, i0)),
+                _mm_sub_ps(_mm_mul_ps(u3r, r1), _mm_mul_ps(u3i, i1)));
+            __m128 ni1 = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(u2r, i0), _mm_mul_ps(u2i, r0)),
+                _mm_add_ps(_mm_mul_ps(u3r, i1), _mm_mul_ps(u3i, r1)));
+
+            if (lo_mask) {
+                nr0 = _mm_or_ps(_mm_and_ps(lane, nr0), _mm_andnot_ps(lane, r0));
+                ni0 = _mm_or_ps(_mm_and_ps(lane, ni0), _mm_andnot_ps(lane, i0));
+                nr1 = _mm_or_ps(_mm_and_ps(lane, nr1), _mm_andnot_ps(lane, r1));
+                ni1 = _mm_or_ps(_mm_and_ps(lane, ni1), _mm_andnot_ps(lane, i1));
+            }
+
+            _mm_storeu_ps(re + i, nr0);
+            _mm_storeu_ps(im + i, ni0);
+            _mm_storeu_ps(re + j, nr1);
+            _mm_storeu_ps(im + j, ni1);
+        }
+    }
+}
+
+/* Igual que qsim_kernel_sse() con 8 carriles: requiere target >= 3 */
+__attribute__((target("avx2"))) static void
+qsim_kernel_avx2(float *re, float *im, int num_qubits, int target,
+                 unsigned cmask, const QGate *g) {
+    unsigned n = 1u << num_qubits;
+    unsigned stride = 1u << target;
+    unsigned hi_mask = cmask & ~7u;
+    unsigned lo_mask = cmask & 7u;
+
+    int lanes[8];
+    for (int l = 0; l < 8; l++) {
+        lanes[l] = ((unsigned)l & lo_mask) == lo_mask ? -1 : 0;
+    }
+    __m256 lane = _mm256_castsi256_ps(
+        _mm256_loadu_si256((const __m256i *)lanes));
+
+    __m256 u0r = _mm256_set1_ps(g->re[0]), u0i = _mm256_set1_ps(g->im[0]);
+    __m256 u1r = _mm256_set1_ps(g->re[1]), u1i = _mm256_set1_ps(g->im[1]);
+    __m256 u2r = _mm256_set1_ps(g->re[2]), u2i = _mm256_set1_ps(g->im[2]);
+    __m256 u3r = _mm256_set1_ps(g->re[3]), u3i = _mm256_set1_ps(g->im[3]);
+
+    for (unsigned base = 0; base < n; base += 2 * stride) {
+        for (unsigned i = base; i < base + stride; i += 8) {
+            if ((i & hi_mask) != hi_mask)
+                continue;
+            unsigned j = i + stride;
+            __m256 r0 = _mm256_loadu_ps(re + i), i0 = _mm256_loadu_ps(im + i);
+            __m256 r1 = _mm256_loadu_ps(re + j), i1 = _mm256_loadu_ps(im + j);
+
+            __m256 nr0 = _mm256_add_ps(
+                _mm256_sub_ps(_mm256_mul_ps(u0r, r0), _mm256_mul_ps(u0i, i0)),
+                _mm256_sub_ps(_mm256_mul_ps(u1r, r1), _mm256_mul_ps(u1i, i1)));
+            __m256 ni0 = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(u0r, i0), _mm256_mul_ps(u0i, r0)),
+                _mm256_add_ps(_mm256_mul_ps(u1r, i1), _mm256_mul_ps(u1i, r1)));
+            __m256 nr1 = _mm256_add_ps(
+                _mm256_sub_ps(_mm256_mul_ps(u2r, r0), _mm256_mul_ps(u2i, i0)),
+                _mm256_sub_ps(_mm256_mul_ps(u3r, r1), _mm256_mul_ps(u3i, i1)));
+            __m256 ni1 = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(u2r, i0), _mm256_mul_ps(u2i, r0)),
+                _mm256_add_ps(_mm256_mul_ps(u3r, i1), _mm256_mul_ps(u3i, r1)));
+
+            if (lo_mask) {
+                nr0 = _mm256_blendv_ps(r0, nr0, lane);
+                ni0 = _mm256_blendv_ps(i0, ni0, lane);
+                nr1 = _mm256_blendv_ps(r1, nr1, lane);
+                ni1 = _mm256_blendv_ps(i1, ni1, lane);
+            }
+
+            _mm256_storeu_ps(re + i, nr0);
+            _mm256_storeu_ps(im + i, ni0);
+            _mm256_storeu_ps(re + j, nr1);
+            _mm256_storeu_ps(im + j, ni1);
+        }
+    }
+}
+
+/* 0 = escalar, 1 = SSE, 2 = AVX2. Se detecta una vez en tiempo de
+ * ejecución: el binario sigue funcionando en CPUs sin AVX2. */
+static int qsim_simd_level(void) {
+    static int level = -1;
+    if (level < 0) {
+        __builtin_cpu_init();
+        level = __builtin_cpu_supports("avx2")  ? 2
+                : __builtin_cpu_supports("sse") ? 1
+                                                : 0;
+    }
+    return level;
+}
+#endif
+
+static void qsim_apply(float *re, float *im, int num_qubits, int target,
+                       unsigned cmask, const QGate *g) {
+#ifdef QSIM_X86
+    int level = qsim_simd_level();
+    if (level >= 2 && target >= 3) {
+        qsim_kernel_avx2(re, im, num_qubits, target, cmask, g);
+        return;
+    }
+    if (level >= 1 && target >= 2) {
+        qsim_kernel_sse(re, im, num_qubits, target, cmask, g);
         return;
+    }
+#endif
+    qsim_kernel_scalar(re, im, num_qubits, target, cmask, g);
+}
 
-    // H = 1/sqrt(2) * [[1, 1], [1, -1]]
-    float s = 1.0f / sqrtf(2.0f);
+static float qsim_probability(const float *re, const float *im,
+                              int num_qubits, int target) {
+    unsigned n = 1u << num_qubits;
+    unsigned stride = 1u << target;
+    float p1 = 0.0f;
+    for (unsigned base = stride; base < n; base += 2 * stride) {
+        for (unsigned i = base; i < base + stride; i++) {
+            p1 += re[i] * re[i] + im[i] * im[i];
+        }
+    }
+    return p1;
+}
 
-    float new_alpha_r = s * (q->alpha_real + q->beta_real);
-    float new_alpha_i = s * (q->alpha_imag + q->beta_imag);
-    float new_beta_r = s * (q->alpha_real - q->beta_real);
-    float new_beta_i = s * (q->alpha_imag - q->beta_imag);
+/* Mide `target` con un bit cuántico sesgado y proyecta el estado sobre el
+ * resultado, renormalizando el resto de amplitudes. Se llama desde el hilo
+ * de juego y se necesita ya: se mide con el pool, sin ir a la red. */
+static int qsim_measure(float *re, float *im, int num_qubits, int target) {
+    float p1 = qsim_probability(re, im, num_qubits, target);
+    int outcome = qiskit_measure_now(p1);
 
-    q->alpha_real = new_alpha_r;
-    q->alpha_imag = new_alpha_i;
-    q->beta_real = new_beta_r;
-    q->beta_imag = new_beta_i;
+    /* El redondeo puede dejar una rama con probabilidad ~0: no dividir */
+    float p = outcome ? p1 : 1.0f - p1;
+    if (p < 1e-12f) {
+        outcome = !outcome;
+        p = 1.0f - p;
+    }
 
-    if (IsAudioSoundValid(qubit_rotate_sound)) {
-        PlayAudioSound(qubit_rotate_sound);
+    unsigned n = 1u << num_qubits;
+    unsigned bit = 1u << target;
+    float scale = 1.0f / sqrtf(p);
+    for (unsigned i = 0; i < n; i++) {
+        if (((i & bit) != 0) == outcome) {
+            re[i] *= scale;
+            im[i] *= scale;
+        } else {
+            re[i] = 0.0f;
+            im[i] = 0.0f;
+        }
     }
+    return outcome;
 }
 
-void apply_pauli_x_gate(Qubit *q) {
-    if (q->is_measured)
+/* ===== STATEVECTOR ===== */
+
+StateVector *statevector_create(int num_qubits) {
+    if (num_qubits < 0 || num_qubits > QSIM_MAX_QUBITS)
+        return NULL;
+
+    /* Al menos 8 floats por array para que los kernels SIMD no se salgan */
+    size_t states = (size_t)1 << num_qubits;
+    size_t bytes = (states < 8 ? 8 : states) * sizeof(float);
+
+    StateVector *sv = malloc(sizeof(StateVector));
+    if (!sv)
+        return NULL;
+    sv->num_qubits = num_qubits;
+    sv->re = aligned_malloc(bytes, QSIM_ALIGNMENT);
+    sv->im = aligned_malloc(bytes, QSIM_ALIGNMENT);
+    if (!sv->re || !sv->im) {
+        statevector_free(sv);
+        return NULL;
+    }
+    statevector_reset(sv);
+    return sv;
+}
+
+void statevector_free(StateVector *sv) {
+    if (!sv)
         return;
+    aligned_free(sv->re);
+    aligned_free(sv->im);
+    free(sv);
+}
 
-    // X = [[0, 1], [1, 0]]
-    float temp_r = q->alpha_real;
-    float temp_i = q->alpha_imag;
-    q->alpha_real = q->beta_real;
-    q->alpha_imag = q->beta_imag;
-    q->beta_real = temp_r;
-    q->beta_imag = temp_i;
+void statevector_reset(StateVector *sv) {
+    size_t bytes = ((size_t)1 << sv->num_qubits) * sizeof(float);
+    memset(sv->re, 0, bytes);
+    memset(sv->im, 0, bytes);
+    sv->re[0] = 1.0f;
+}
 
-    if (IsAudioSoundValid(qubit_rotate_sound)) {
-        PlayAudioSound(qubit_rotate_sound);
+void statevector_apply_gate(StateVector *sv, int target, const QGate *gate) {
+    if (target < 0 || target >= sv->num_qubits)
+        return;
+    qsim_apply(sv->re, sv->im, sv->num_qubits, target, 0, gate);
+}
+
+void statevector_apply_controlled_gate(StateVector *sv, int control,
+                                       int target, const QGate *gate) {
+    if (target < 0 || target >= sv->num_qubits || control < 0 ||
+        control >= sv->num_qubits || control == target)
+        return;
+    qsim_apply(sv->re, sv->im, sv->num_qubits, target, 1u << control, gate);
+}
+
+float statevector_probability(const StateVector *sv, int target) {
+    if (target < 0 || target >= sv->num_qubits)
+        return 0.0f;
+    return qsim_probability(sv->re, sv->im, sv->num_qubits, target);
+}
+
+int statevector_measure(StateVector *sv, int target) {
+    if (target < 0 || target >= sv->num_qubits)
+        return 0;
+    return qsim_measure(sv->re, sv->im, sv->num_qubits, target);
+}
+
+/* ===== STABILIZER TABLEAU (CHP) ===== */
+
+/* Filas 0..n-1: destabilizadores, n..2n-1: estabilizadores, 2n: auxiliar.
+ * Cada columna de x/z es el bit de un qubit en todas las filas. */
+
+#define STAB_COL(st, m, q) ((st)->m + (size_t)(q) * (size_t)(st)->words)
+
+static int stab_get(const uint64_t *col, int row) {
+    return (int)((col[row >> 6] >> (row & 63)) & 1u);
+}
+
+static void stab_set(uint64_t *col, int row, int value) {
+    uint64_t bit = (uint64_t)1 << (row & 63);
+    if (value)
+        col[row >> 6] |= bit;
+    else
+        col[row >> 6] &= ~bit;
+}
+
+StabilizerState *stabilizer_create(int num_qubits) {
+    if (num_qubits <= 0)
+        return NULL;
+
+    StabilizerState *st = calloc(1, sizeof(StabilizerState));
+    if (!st)
+        return NULL;
+    st->num_qubits = num_qubits;
+    st->words = (2 * num_qubits + 1 + 63) / 64;
+
+    size_t col_words = (size_t)num_qubits * (size_t)st->words;
+    st->x = calloc(col_words, sizeof(uint64_t));
+    st->z = calloc(col_words, sizeof(uint64_t));
+    st->r = calloc(st->words, sizeof(uint64_t));
+    st->tmp = calloc(3 * (size_t)st->words, sizeof(uint64_t));
+    st->row = calloc(2 * (size_t)num_qubits, sizeof(uint8_t));
+    if (!st->x || !st->z || !st->r || !st->tmp || !st->row) {
+        stabilizer_free(st);
+        return NULL;
     }
+    stabilizer_reset(st);
+    return st;
 }
 
-void apply_cnot_gate(Qubit *control, Qubit *target) {
-    if (control->is_measured || target->is_measured)
+void stabilizer_free(StabilizerState *st) {
+    if (!st)
         return;
+    free(st->x);
+    free(st->z);
+    free(st->r);
+    free(st->tmp);
+    free(st->row);
+    free(st);
+}
 
-    float p1 = get_qubit_probability(control, 1);
-    if (p1 > 0.99f) {
-        apply_pauli_x_gate(target);
-    } else if (p1 > 0.01f) {
+void stabilizer_reset(StabilizerState *st) {
+    int n = st->num_qubits;
+    size_t col_words = (size_t)n * (size_t)st->words;
+    memset(st->x, 0, col_words * sizeof(uint64_t));
+    memset(st->z, 0, col_words * sizeof(uint64_t));
+    memset(st->r, 0, st->words * sizeof(uint64_t));
 
-        measure_qubit(control);
-        if (control->measured_value == 1) {
-            apply_pauli_x_gate(target);
-        }
+    /* |0...0>: destabilizador i = X_i, estabilizador i = Z_i */
+    for (int i = 0; i < n; i++) {
+        stab_set(STAB_COL(st, x, i), i, 1);
+        stab_set(STAB_COL(st, z, i), n + i, 1);
     }
 }
 
-void measure_qubit(Qubit *q) {
-    if (q->is_measured)
+void stabilizer_hadamard(StabilizerState *st, int q) {
+    uint64_t *x = STAB_COL(st, x, q);
+    uint64_t *z = STAB_COL(st, z, q);
+    for (int w = 0; w < st->words; w++) {
+        uint64_t xw = x[w], zw = z[w];
+        st->r[w] ^= xw & zw;
+        x[w] = zw;
+        z[w] = xw;
+    }
+}
+
+void stabilizer_phase(StabilizerState *st, int q) {
+    uint64_t *x = STAB_COL(st, x, q);
+    uint64_t *z = STAB_COL(st, z, q);
+    for (int w = 0; w < st->words; w++) {
+        st->r[w] ^= x[w] & z[w];
+        z[w] ^= x[w];
+    }
+}
+
+void stabilizer_pauli_x(StabilizerState *st, int q) {
+    /* X anticonmuta con Z: cambia el signo de las filas con z_q = 1 */
+    uint64_t *z = STAB_COL(st, z, q);
+    for (int w = 0; w < st->words; w++) {
+        st->r[w] ^= z[w];
+    }
+}
+
+void stabilizer_cnot(StabilizerState *st, int control, int target) {
+    if (control == target)
         return;
+    uint64_t *xa = STAB_COL(st, x, control);
+    uint64_t *za = STAB_COL(st, z, control);
+    uint64_t *xb = STAB_COL(st, x, target);
+    uint64_t *zb = STAB_COL(st, z, target);
+    for (int w = 0; w < st->words; w++) {
+        st->r[w] ^= xa[w] & zb[w] & ~(xb[w] ^ za[w]);
+        xb[w] ^= xa[w];
+        za[w] ^= zb[w];
+    }
+}
 
-    float p0 = get_qubit_probability(q, 0);
-    float r = qiskit_random_float();
+/* rowsum(h, p) de CHP para todas las filas h de `mask` a la vez. La fase
+ * de cada fila (mod 4) se acumula en un contador de dos bits repartido en
+ * dos palabras (lo/hi), así que cada columna cuesta O(words). */
+static void stab_rowsum_rows(StabilizerState *st, const uint64_t *mask,
+                             int p) {
+    int words = st->words;
+    uint64_t *lo = st->tmp + words;
+    uint64_t *hi = st->tmp + 2 * words;
+    uint64_t rp = stab_get(st->r, p) ? ~(uint64_t)0 : 0;
 
-    if (r < p0) {
-        q->measured_value = 0;
-        q->alpha_real = 1.0f;
-        q->alpha_imag = 0.0f;
-        q->beta_real = 0.0f;
-        q->beta_imag = 0.0f;
-    } else {
-        q->measured_value = 1;
-        q->alpha_real = 0.0f;
-        q->alpha_imag = 0.0f;
-        q->beta_real = 1.0f;
-        q->beta_imag = 0.0f;
+    for (int w = 0; w < words; w++) {
+        lo[w] = 0;
+        hi[w] = (st->r[w] ^ rp) & mask[w]; /* 2*r_h + 2*r_p */
     }
 
-    q->is_measured = true;
+    for (int j = 0; j < st->num_qubits; j++) {
+        uint64_t *xj = STAB_COL(st, x, j);
+        uint64_t *zj = STAB_COL(st, z, j);
+        int a = stab_get(xj, p), b = stab_get(zj, p);
+        if (!a && !b)
+            continue;
+
+        for (int w = 0; w < words; w++) {
+            uint64_t xw = xj[w] & mask[w], zw = zj[w] & mask[w];
+            uint64_t plus, minus;
+
+            /* g(x_p, z_p, x_h, z_h) en {-1, 0, +1} */
+            if (a && b) { /* Y: z_h - x_h */
+                plus = zw & ~xw;
+                minus = xw & ~zw;
+            } else if (a) { /* X: z_h * (2x_h - 1) */
+                plus = zw & xw;
+                minus = zw & ~xw;
+            } else { /* Z: x_h * (1 - 2z_h) */
+                plus = xw & ~zw;
+                minus = xw & zw;
+            }
+
+            /* +1 en `plus`, +3 (= -1 mod 4) en `minus` */
+            uint64_t one = plus | minus;
+            hi[w] ^= (lo[w] & one) ^ minus;
+            lo[w] ^= one;
 
-    if (IsAudioSoundValid(measurement_sound)) {
-        PlayAudioSound(measurement_sound);
+            if (a)
+                xj[w] ^= mask[w];
+            if (b)
+                zj[w] ^= mask[w];
+        }
+    }
+
+    /* El resultado es 0 o 2 (mod 4): la fase nueva es el bit alto */
+    for (int w = 0; w < words; w++) {
+        st->r[w] = (st->r[w] & ~mask[w]) | hi[w];
     }
 }
 
-float get_qubit_probability(Qubit *q, int outcome) {
-    if (outcome == 0) {
-        return q->alpha_real * q->alpha_real + q->alpha_imag * q->alpha_imag;
+/* Resultado determinista de medir q (sin alterar el tableau): producto de
+ * los estabilizadores n+i cuyo destabilizador i anticonmuta con Z_q. */
+static int stab_deterministic_outcome(StabilizerState *st, int q) {
+    int n = st->num_qubits;
+    uint8_t *sx = st->row;
+    uint8_t *sz = st->row + n;
+    int phase = 0;
+    memset(st->row, 0, 2 * (size_t)n);
+
+    const uint64_t *xq = STAB_COL(st, x, q);
+    for (int i = 0; i < n; i++) {
+        if (!stab_get(xq, i))
+            continue;
+
+        int row = n + i;
+        phase += 2 * stab_get(st->r, row);
+        for (int j = 0; j < n; j++) {
+            int x1 = stab_get(STAB_COL(st, x, j), row);
+            int z1 = stab_get(STAB_COL(st, z, j), row);
+            int x2 = sx[j], z2 = sz[j];
+            if (x1 && z1)
+                phase += z2 - x2;
+            else if (x1)
+                phase += z2 * (2 * x2 - 1);
+            else if (z1)
+                phase += x2 * (1 - 2 * z2);
+            sx[j] = (uint8_t)(x2 ^ x1);
+            sz[j] = (uint8_t)(z2 ^ z1);
+        }
+    }
+    return (phase & 3) == 2;
+}
+
+/* Primer estabilizador con x_q = 1 (el resultado es aleatorio), o -1 */
+static int stab_find_random_row(const StabilizerState *st, int q) {
+    int n = st->num_qubits;
+    const uint64_t *xq = STAB_COL(st, x, q);
+    for (int w = n >> 6; w <= (2 * n - 1) >> 6; w++) {
+        int first = w << 6;
+        uint64_t bits = xq[w];
+        if (first < n)
+            bits &= ~(uint64_t)0 << (n - first);
+        if (first + 64 > 2 * n)
+            bits &= ((uint64_t)1 << (2 * n - first)) - 1;
+        if (bits)
+            return first + __builtin_ctzll(bits);
+    }
+    return -1;
+}
+
+float stabilizer_probability(StabilizerState *st, int q) {
+    if (q < 0 || q >= st->num_qubits)
+        return 0.0f;
+    if (stab_find_random_row(st, q) >= 0)
+        return 0.5f;
+    return stab_deterministic_outcome(st, q) ? 1.0f : 0.0f;
+}
+
+int stabilizer_measure(StabilizerState *st, int q) {
+    if (q < 0 || q >= st->num_qubits)
+        return 0;
+
+    int n = st->num_qubits;
+    int p = stab_find_random_row(st, q);
+    if (p < 0)
+        return stab_deterministic_outcome(st, q);
+
+    /* Resultado aleatorio 50/50 con un bit del pool */
+    int outcome = qiskit_random_bit();
+
+    /* Todas las filas (salvo p) que anticonmutan con Z_q se multiplican por
+     * la fila p en una sola pasada por columnas */
+    uint64_t *mask = st->tmp;
+    const uint64_t *xq = STAB_COL(st, x, q);
+    for (int w = 0; w < st->words; w++) {
+        mask[w] = xq[w];
+    }
+    stab_set(mask, p, 0);
+    stab_set(mask, 2 * n, 0);
+    stab_rowsum_rows(st, mask, p);
+
+    /* Destabilizador p-n = fila p; fila p = (-1)^outcome Z_q */
+    for (int j = 0; j < n; j++) {
+        uint64_t *xj = STAB_COL(st, x, j);
+        uint64_t *zj = STAB_COL(st, z, j);
+        stab_set(xj, p - n, stab_get(xj, p));
+        stab_set(zj, p - n, stab_get(zj, p));
+        stab_set(xj, p, 0);
+        stab_set(zj, p, j == q);
+    }
+    stab_set(st->r, p - n, stab_get(st->r, p));
+    stab_set(st->r, p, outcome);
+    return outcome;
+}
+
+/* ===== QUBIT LOGIC ===== */
+
+void init_quantum_register(QuantumRegister *reg) {
+    memset(reg->re, 0, sizeof(reg->re));
+    memset(reg->im, 0, sizeof(reg->im));
+    reg->re[0] = 1.0f;
+    reg->num_qubits = 0;
+}
+
+bool qreg_add_qubit(QuantumRegister *reg, Qubit *q) {
+    if (reg->num_qubits >= MAX_QUBITS)
+        return false;
+
+    /* Los qubits aún no usados del registro están en |0>: ampliar el
+     * registro es el producto tensorial con |0>, no hay que tocar nada */
+    init_qubit(q);
+    q->reg = reg;
+    q->wire = reg->num_qubits++;
+    return true;
+}
+
+void init_qubit(Qubit *q) {
+    q->reg = NULL;
+    q->wire = -1;
+    q->is_measured = false;
+    q->measured_value = 0;
+    q->active = true;
+}
+
+/* Puerta de un qubit sobre el registro que contiene a `q` */
+static bool qubit_apply_gate(Qubit *q, const QGate *gate) {
+    if (q->is_measured || !q->reg)
+        return false;
+    qsim_apply(q->reg->re, q->reg->im, q->reg->num_qubits, q->wire, 0, gate);
+    return true;
+}
+
+bool apply_hadamard_gate(Qubit *q) {
+    return qubit_apply_gate(q, &QGATE_HADAMARD);
+}
+
+bool apply_pauli_x_gate(Qubit *q) {
+    return qubit_apply_gate(q, &QGATE_PAULI_X);
+}
+
+bool apply_cnot_gate(Qubit *control, Qubit *target) {
+    if (control->is_measured || target->is_measured)
+        return false;
+    /* Sólo se pueden entrelazar qubits del mismo registro */
+    if (!control->reg || control->reg != target->reg ||
+        control->wire == target->wire)
+        return false;
+
+    QuantumRegister *reg = control->reg;
+    qsim_apply(reg->re, reg->im, reg->num_qubits, target->wire,
+               1u << control->wire, &QGATE_PAULI_X);
+    return true;
+}
+
+bool measure_qubit(Qubit *q) {
+    if (q->is_measured)
+        return false;
+
+    if (q->reg) {
+        q->measured_value =
+            qsim_measure(q->reg->re, q->reg->im, q->reg->num_qubits, q->wire);
     } else {
-        return q->beta_real * q->beta_real + q->beta_imag * q->beta_imag;
+        q->measured_value = 0;
+    }
+
+    q->is_measured = true;
+    return true;
+}
+
+float get_qubit_probability(Qubit *q, int outcome) {
+    float p1 = 0.0f;
+    if (q->reg) {
+        p1 = qsim_probability(q->reg->re, q->reg->im, q->reg->num_qubits,
+                              q->wire);
     }
+    return outcome == 0 ? 1.0f - p1 : p1;
 }
 
 /* ===== PORTAL LOGIC ===== */
@@ -137,10 +682,11 @@ bool can_use_portal(GameState *game, int portal_idx) {
 void handle_portal_teleport(GameState *game) {
     // Check if player is on a portal
     int p_idx = -1;
-    for (int i = 0; i < MAX_PORTALS; i++) {
-        if (game->portals[i].active &&
-            ivec2_eq(game->player.position, game->portals[i].position)) {
-            p_idx = i;
+    for (EntityRef ref = entity_index_at(game, game->player.position); ref;
+         ref = entity_index_next(game, ref)) {
+        if (ENTITY_REF_KIND(ref) == ENTITY_PORTAL &&
+            game->portals[ENTITY_REF_INDEX(ref)].active) {
+            p_idx = ENTITY_REF_INDEX(ref);
             break;
         }
     }
@@ -160,8 +706,6 @@ void handle_portal_teleport(GameState *game) {
         // Teleport
         game->player.position = game->portals[dest_idx].position;
 
-        if (IsAudioSoundValid(teleport_sound)) {
-            PlayAudioSound(teleport_sound);
-        }
+        emit_sound(game, SOUND_TELEPORT);
     }
 }
@@ -2,13 +2,69 @@
 #define QUANTUM_H
 
 #include "common.h"
+#include <stdint.h>
+
+// Puerta de un qubit: matriz 2x2 compleja [u00, u01, u10, u11]
+typedef struct {
+    float re[4];
+    float im[4];
+} QGate;
+
+extern const QGate QGATE_HADAMARD;
+extern const QGate QGATE_PAULI_X;
+
+// Vector de estado de n qubits en memoria dinámica alineada a 32 bytes.
+// Para registros grandes; el jugador usa QuantumRegister (sin reservas).
+typedef struct {
+    float *re;
+    float *im;
+    int num_qubits;
+} StateVector;
+
+StateVector *statevector_create(int num_qubits);
+void statevector_free(StateVector *sv);
+void statevector_reset(StateVector *sv); // |00...0>
+void statevector_apply_gate(StateVector *sv, int target, const QGate *gate);
+void statevector_apply_controlled_gate(StateVector *sv, int control,
+                                       int target, const QGate *gate);
+float statevector_probability(const StateVector *sv, int target); // P(1)
+int statevector_measure(StateVector *sv, int target); // Colapsa el qubit
+
+// Simulador de estabilizadores (tableau CHP de Aaronson-Gottesman) para
+// circuitos Clifford (H, S, X, CNOT) de cientos de qubits. Tableau por
+// columnas: cada qubit guarda los bits x/z de sus 2n+1 filas empaquetados
+// en palabras de 64 bits, así que cada puerta es un XOR/AND por palabra.
+typedef struct {
+    int num_qubits;
+    int words;     // Palabras de 64 bits por columna (2n + 1 filas)
+    uint64_t *x;   // x[q * words + w]
+    uint64_t *z;   // z[q * words + w]
+    uint64_t *r;   // Bit de fase de cada fila
+    uint64_t *tmp; // 3 * words: máscara y contador de fase por filas
+    uint8_t *row;  // 2 * n: fila auxiliar para medidas deterministas
+} StabilizerState;
+
+StabilizerState *stabilizer_create(int num_qubits);
+void stabilizer_free(StabilizerState *st);
+void stabilizer_reset(StabilizerState *st); // |00...0>
+void stabilizer_hadamard(StabilizerState *st, int q);
+void stabilizer_phase(StabilizerState *st, int q); // S
+void stabilizer_pauli_x(StabilizerState *st, int q);
+void stabilizer_cnot(StabilizerState *st, int control, int target);
+float stabilizer_probability(StabilizerState *st, int q); // 0, 0.5 o 1
+int stabilizer_measure(StabilizerState *st, int q);       // O(n^2)
+
+// Registro cuántico del jugador
+void init_quantum_register(QuantumRegister *reg);
+bool qreg_add_qubit(QuantumRegister *reg, Qubit *q); // Nuevo qubit en |0>
 
 // Gestión de Qubits
 void init_qubit(Qubit *q);
-void apply_hadamard_gate(Qubit *q);
-void apply_pauli_x_gate(Qubit *q);
-void apply_cnot_gate(Qubit *control, Qubit *target); // CNOT Simplificado
-void measure_qubit(Qubit *q);
+// Devuelven false si la puerta/medida no se aplicó (qubit ya medido, etc.)
+bool apply_hadamard_gate(Qubit *q);
+bool apply_pauli_x_gate(Qubit *q);
+bool apply_cnot_gate(Qubit *control, Qubit *target); // Entrelaza de verdad
+bool measure_qubit(Qubit *q);
 float get_qubit_probability(Qubit *q, int outcome);
 
 // Gestión de Portales
@@ -1,5 +1,7 @@
 #include "render.h"
+#include "qiskit.h"
 #include <stdio.h> // for sprintf
+#include <string.h>
 
 /* === POST-PROCESSING SHADER SYSTEM === */
 Shader post_shader = {0};
@@ -129,9 +131,10 @@ void render_game_cells(GameState *game) {
         game->player.phase_system.state == PHASE_STATE_SUPERPOSITION;
 
     for (int y = 0; y < game->map->rows; y++) {
+        const uint8_t *row = &MAP_AT(game->map, 0, y);
         for (int x = 0; x < game->map->cols; x++) {
             Vector2 pos = {x * CELL_SIZE, y * CELL_SIZE};
-            Cell cell = game->map->data[y][x];
+            Cell cell = (Cell)row[x];
             Color color = get_cell_color(cell, phase, in_superposition);
             DrawRectangleV(pos, (Vector2){CELL_SIZE, CELL_SIZE}, color);
 
@@ -580,10 +583,42 @@ void render_hud(GameState *game) {
                (Color){120, 140, 180, 200});
 }
 
+/* Debug overlay with the Qiskit client stats (F8 in DEBUG_MODE) */
+void render_qiskit_overlay(void) {
+    char text[2048];
+    qiskit_format_stats(text, sizeof(text));
+
+    const float font_size = 18.0f;
+    const float line_height = 22.0f;
+    int line_count = 0;
+    for (const char *c = text; *c; c++) {
+        if (*c == '\n')
+            line_count++;
+    }
+
+    float x = 20.0f;
+    float y = (float)GetScreenHeight() - 20.0f - line_count * line_height;
+    DrawRectangle((int)x - 10, (int)y - 10, 760,
+                  (int)(line_count * line_height) + 20, (Color){0, 0, 0, 180});
+
+    char *line = text;
+    while (*line) {
+        char *end = strchr(line, '\n');
+        if (end)
+            *end = '\0';
+        DrawTextEx(GetFontDefault(), line, (Vector2){x, y}, font_size, 2,
+                   GREEN);
+        y += line_height;
+        if (!end)
+            break;
+        line = end + 1;
+    }
+}
+
 void render_grid_lines(GameState *game) {
     for (int y = 0; y < game->map->rows; y++) {
         for (int x = 0; x < game->map->cols; x++) {
-            if (game->map->data[y][x] == CELL_FLOOR) {
+            if (MAP_AT(game->map, x, y) == CELL_FLOOR) {
                 Vector2 pos = {x * CELL_SIZE, y * CELL_SIZE};
                 DrawRectangleLinesEx(
                     (Rectangle){pos.x, pos.y, CELL_SIZE, CELL_SIZE}, 0.5f,
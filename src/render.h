@@ -32,6 +32,7 @@ void render_dialog(GameState *game);
 void render_win_screen(void);
 void render_level_transition(GameState *game);
 void render_encyclopedia(GameState *game);
+void render_qiskit_overlay(void);
 
 // Helpers
 Vector2 interpolate_positions(IVector2 prev, IVector2 curr, float t);
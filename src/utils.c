@@ -1,32 +1,13 @@
 #include "utils.h"
 #include "quantum.h"
+#include <limits.h>
+#include <stdint.h>
 
 // Global Definitions
 Color PALETTE[25];
 const IVector2 DIRECTION_VECTORS[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-AudioSound footstep_sounds[4];
-AudioSound blast_sound;
-AudioSound key_pickup_sound;
-AudioSound bomb_pickup_sound;
-AudioSound checkpoint_sound;
-AudioSound phase_shift_sound;
-AudioMusic ambient_music;
 Font game_font;
 
-// New sound globals
-AudioSound teleport_sound;
-AudioSound measurement_sound;
-AudioSound entangle_sound;
-AudioSound qubit_rotate_sound;
-AudioSound oracle_sound;
-AudioSound ice_slide_sound;
-AudioSound mirror_reflect_sound;
-AudioSound decoherence_sound;
-AudioSound portal_activate_sound;
-AudioSound level_complete_sound;
-AudioSound guard_step_sound;
-AudioSound open_door_sound;
-AudioSound plant_bomb_sound;
 Texture2D title_icon;
 
 IVector2 ivec2(int x, int y) { return (IVector2){x, y}; }
@@ -57,53 +38,84 @@ Vector2 vec2_add(Vector2 a, Vector2 b) {
 
 IVector2 ivec2_scale(IVector2 v, int s) { return (IVector2){v.x * s, v.y * s}; }
 
+/* Todo el bloque (borde y relleno de cada fila) empieza como CELL_WALL y
+ * el interior como CELL_NONE, igual que el antiguo calloc por filas */
 Map *map_create(int rows, int cols) {
     Map *map = malloc(sizeof(Map));
+    if (!map)
+        return NULL;
     map->rows = rows;
     map->cols = cols;
-    map->data = malloc(rows * sizeof(Cell *));
-    for (int i = 0; i < rows; i++) {
-        map->data[i] = calloc(cols, sizeof(Cell));
+    map->stride = (cols + 2 * MAP_BORDER + MAP_STRIDE_ALIGN - 1) &
+                  ~(MAP_STRIDE_ALIGN - 1);
+
+    size_t bytes = (size_t)map->stride * (rows + 2 * MAP_BORDER);
+    map->block = aligned_malloc(bytes, 64);
+    if (!map->block) {
+        free(map);
+        return NULL;
     }
+    memset(map->block, CELL_WALL, bytes);
+    map->cells = map->block + (size_t)MAP_BORDER * map->stride + MAP_BORDER;
+    map_clear(map);
     return map;
 }
 
+/* Vuelve a dejar el interior en CELL_NONE; el borde no se toca */
+void map_clear(Map *map) {
+    for (int y = 0; y < map->rows; y++)
+        memset(&MAP_AT(map, 0, y), CELL_NONE, (size_t)map->cols);
+}
+
 void map_free(Map *map) {
     if (!map)
         return;
-    for (int i = 0; i < map->rows; i++) {
-        free(map->data[i]);
-    }
-    free(map->data);
+    aligned_free(map->block);
     free(map);
 }
 
-int **path_create(int rows, int cols) {
-    int **path = malloc(rows * sizeof(int *));
-    for (int i = 0; i < rows; i++) {
-        path[i] = malloc(cols * sizeof(int));
-        for (int j = 0; j < cols; j++) {
-            path[i][j] = -1;
-        }
-    }
-    return path;
+/* Reserva con alineación arbitraria (potencia de dos) sin depender de
+ * posix_memalign/_aligned_malloc: el puntero original se guarda justo antes
+ * del bloque alineado. Liberar siempre con aligned_free(). */
+void *aligned_malloc(size_t size, size_t alignment) {
+    void *raw = malloc(size + alignment + sizeof(void *));
+    if (!raw)
+        return NULL;
+    uintptr_t addr = (uintptr_t)raw + sizeof(void *);
+    addr = (addr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    ((void **)addr)[-1] = raw;
+    return (void *)addr;
 }
 
-void path_free(int **path, int rows) {
-    if (!path)
-        return;
-    for (int i = 0; i < rows; i++) {
-        free(path[i]);
-    }
-    free(path);
+void aligned_free(void *ptr) {
+    if (ptr)
+        free(((void **)ptr)[-1]);
 }
 
-void path_reset(int **path, int rows, int cols) {
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            path[i][j] = -1;
-        }
-    }
+bool arena_init(Arena *arena, size_t size) {
+    arena->base = aligned_malloc(size, ARENA_ALIGNMENT);
+    arena->size = arena->base ? size : 0;
+    arena->used = 0;
+    return arena->base != NULL;
+}
+
+/* alignment debe ser potencia de dos y <= ARENA_ALIGNMENT. NULL si no cabe:
+ * el tamaño de la arena se calcula al cargar el nivel, no crece. */
+void *arena_alloc(Arena *arena, size_t size, size_t alignment) {
+    size_t offset = (arena->used + alignment - 1) & ~(alignment - 1);
+    if (!arena->base || offset + size > arena->size)
+        return NULL;
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+void arena_reset(Arena *arena) { arena->used = 0; }
+
+void arena_free(Arena *arena) {
+    aligned_free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
 }
 
 Vector2 Vector2LerpCustom(Vector2 v1, Vector2 v2, float amount) {
@@ -126,31 +138,310 @@ bool inside_of_rect(IVector2 start, IVector2 size, IVector2 point) {
 bool colapsor_can_stand_here(GameState *game, IVector2 start,
                              int colapsor_idx) {
     ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    const PassabilityBoards *boards = &game->passability;
+    int cols = game->map->cols;
+
+    if (start.x < 0 || start.y < 0 || start.x + colapsor->size.x > cols ||
+        start.y + colapsor->size.y > game->map->rows)
+        return false;
+
+    /* Terreno: una ventana de bits por fila de la huella */
+    uint64_t mask = BOARD_ROW_MASK(colapsor->size.x);
+    for (int dy = 0; dy < colapsor->size.y; dy++) {
+        const uint64_t *row =
+            boards->walkable + (size_t)(start.y + dy) * boards->words;
+        if ((board_window(row, start.x) & mask) != mask)
+            return false;
+    }
 
     for (int dx = 0; dx < colapsor->size.x; dx++) {
         for (int dy = 0; dy < colapsor->size.y; dy++) {
             IVector2 pos = ivec2(start.x + dx, start.y + dy);
 
-            if (!within_map(game, pos))
+            /* Huellas que cubren la casilla, sin contar la propia */
+            int others = game->occupancy[pos.y * cols + pos.x];
+            if (!colapsor->dead &&
+                inside_of_rect(colapsor->position, colapsor->size, pos))
+                others--;
+            if (others > 0)
                 return false;
+        }
+    }
+    return true;
+}
 
-            Cell cell = game->map->data[pos.y][pos.x];
-            if (cell != CELL_FLOOR && cell != CELL_EXPLOSION) {
-                return false;
-            }
+/* Rejilla de ocupación: cuántas huellas de colapsores vivos cubren cada
+ * casilla. Se mantiene al aparecer, moverse y morir, así que las colisiones
+ * son lecturas directas en vez de recorrer MAX_COLAPSORES.
+ *
+ * Basta con contar, no hace falta saber quién: colapsor_can_stand_here sólo
+ * pregunta si queda alguna huella ajena, y la propia se descuenta con la
+ * posición y el tamaño del que pregunta. Las huellas pueden solaparse (al
+ * aparecer no se comprueba), así que una casilla tendría que guardar una
+ * lista de IDs; un contador cabe en un byte. Cada colapsor vivo suma como
+ * mucho 1 por casilla, así que la cuenta no pasa de MAX_COLAPSORES. */
+typedef char occupancy_count_fits[MAX_COLAPSORES <= UCHAR_MAX ? 1 : -1];
+
+/* Si alguien se salta colapsor_occupy/move/kill la cuenta se satura en vez
+ * de dar la vuelta: una casilla que vuelve a 0 al pasar de 255 dejaría
+ * atravesar a un colapsor, y una que baja de 0 a 255 quedaría bloqueada
+ * para siempre */
+static void occupancy_add(GameState *game, IVector2 start, IVector2 size,
+                          int delta) {
+    int cols = game->map->cols;
+    for (int dy = 0; dy < size.y; dy++) {
+        for (int dx = 0; dx < size.x; dx++) {
+            IVector2 pos = ivec2(start.x + dx, start.y + dy);
+            if (!within_map(game, pos))
+                continue;
+            unsigned char *count = &game->occupancy[pos.y * cols + pos.x];
+            if (delta > 0 ? *count < UCHAR_MAX : *count > 0)
+                *count += delta;
+        }
+    }
+}
+
+void colapsor_occupy(GameState *game, int colapsor_idx) {
+    ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    occupancy_add(game, colapsor->position, colapsor->size, 1);
+}
+
+void colapsor_move(GameState *game, int colapsor_idx, IVector2 pos) {
+    ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    if (!colapsor->dead) {
+        occupancy_add(game, colapsor->position, colapsor->size, -1);
+        occupancy_add(game, pos, colapsor->size, 1);
+    }
+    colapsor->position = pos;
+}
+
+void colapsor_kill(GameState *game, int colapsor_idx) {
+    ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    if (colapsor->dead)
+        return;
+    occupancy_add(game, colapsor->position, colapsor->size, -1);
+    colapsor->dead = true;
+}
+
+/* ===== BITBOARDS DE PASO ===== */
+
+static int passability_words(int cols) { return (cols + 63) / 64 + 1; }
+
+static void board_set(uint64_t *board, int words, IVector2 pos, bool value) {
+    uint64_t *word = &board[(size_t)pos.y * words + (pos.x >> 6)];
+    uint64_t bit = (uint64_t)1 << (pos.x & 63);
+    *word = (*word & ~bit) | (((uint64_t)0 - (uint64_t)value) & bit);
+}
+
+/* Bits de cell_bits: uno por fase estable, luego superposición y suelo de
+ * colapsores. Las reglas siguen siendo las de is_cell_solid_for_phase: la
+ * tabla sólo guarda su resultado para cada tipo de casilla. */
+#define PASS_BIT_SUPERPOSED (1u << PHASE_COUNT)
+#define PASS_BIT_WALKABLE (1u << (PHASE_COUNT + 1))
+#define PASS_LOW_BITS 0x0101010101010101ull // Bit 0 de cada byte
+#define PASS_GATHER 0x0102040810204080ull   // Bit 0 del byte j -> bit 56+j
+
+static void passability_init_cell_bits(PassabilityBoards *boards) {
+    for (int cell = 0; cell <= CELL_EXIT; cell++) {
+        unsigned bits = 0;
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            if (!is_cell_solid_for_phase((Cell)cell, (PhaseKind)phase, false))
+                bits |= 1u << phase;
+        }
+        if (!is_cell_solid_for_phase((Cell)cell, PHASE_RED, true))
+            bits |= PASS_BIT_SUPERPOSED;
+        if (cell == CELL_FLOOR || cell == CELL_EXPLOSION)
+            bits |= PASS_BIT_WALKABLE;
+        boards->cell_bits[cell] = (unsigned char)bits;
+    }
+}
+
+static void passability_update(GameState *game, IVector2 pos, Cell cell) {
+    PassabilityBoards *boards = &game->passability;
+    unsigned bits = boards->cell_bits[cell];
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        board_set(boards->passable[phase], boards->words, pos,
+                  (bits >> phase) & 1u);
+    }
+    board_set(boards->passable_superposed, boards->words, pos,
+              (bits & PASS_BIT_SUPERPOSED) != 0);
+    board_set(boards->walkable, boards->words, pos,
+              (bits & PASS_BIT_WALKABLE) != 0);
+}
+
+static void explosion_mark(GameState *game, IVector2 pos) {
+    if (game->explosion_count < game->explosion_capacity)
+        game->explosion_cells[game->explosion_count++] = pos;
+    else
+        game->explosion_overflow = true;
+}
+
+uint64_t zobrist_key(uint64_t index, unsigned value) {
+    uint64_t z = ((index << 8) | (value & 0xFFu)) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static THREAD_LOCAL bool rand_seeded = false;
+static THREAD_LOCAL uint64_t rand_state = 0;
+
+int game_rand(void) {
+    if (!rand_seeded)
+        return rand();
+    rand_state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = rand_state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (int)((z ^ (z >> 31)) >> 33);
+}
+
+void game_rand_seed(uint64_t seed) {
+    rand_seeded = true;
+    rand_state = seed;
+}
+
+uint64_t map_cell_hash(GameState *game) {
+    if (!game->cell_hash_valid) {
+        uint64_t hash = 0;
+        int cols = game->map->cols;
+        for (int y = 0; y < game->map->rows; y++) {
+            const uint8_t *row = &MAP_AT(game->map, 0, y);
+            for (int x = 0; x < cols; x++)
+                hash ^= zobrist_key((uint64_t)y * cols + x, row[x]);
+        }
+        game->cell_hash = hash;
+        game->cell_hash_valid = true;
+    }
+    return game->cell_hash;
+}
 
-            for (int i = 0; i < MAX_COLAPSORES; i++) {
-                if (i == colapsor_idx || game->colapsores[i].dead)
-                    continue;
+void map_set_cell(GameState *game, IVector2 pos, Cell cell) {
+    uint8_t *slot = &MAP_AT(game->map, pos.x, pos.y);
+    if (cell == CELL_EXPLOSION && *slot != CELL_EXPLOSION)
+        explosion_mark(game, pos);
+    if ((cell == CELL_MIRROR) != (*slot == CELL_MIRROR))
+        game->beam_generation++; // Los rayos que pasan por aquí cambian
+    if (game->cell_hash_valid) {
+        uint64_t index = (uint64_t)pos.y * game->map->cols + pos.x;
+        game->cell_hash ^=
+            zobrist_key(index, *slot) ^ zobrist_key(index, cell);
+    }
+    *slot = cell;
+    passability_update(game, pos, cell);
+}
 
-                ColapsarState *other = &game->colapsores[i];
-                if (inside_of_rect(other->position, other->size, pos)) {
-                    return false;
+/* Tras construir un nivel escribiendo el mapa directamente */
+void map_rebuild_passability(GameState *game) {
+    PassabilityBoards *boards = &game->passability;
+    size_t bytes =
+        (size_t)game->map->rows * boards->words * sizeof(uint64_t);
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        memset(boards->passable[phase], 0, bytes);
+    memset(boards->passable_superposed, 0, bytes);
+    memset(boards->walkable, 0, bytes);
+    memset(boards->footprint, 0, bytes);
+    passability_init_cell_bits(boards);
+    game->beam_generation++;
+    game->explosion_count = 0;
+    game->explosion_overflow = false;
+    game->cell_hash_valid = false;
+
+    /* Palabra a palabra: los 64 bits de cada tablero se montan en registros
+     * y se escriben una vez (cargar un mapa grande es sobre todo esto). De
+     * cada 8 casillas se juntan sus cell_bits, un byte por casilla, y el
+     * producto por PASS_GATHER lleva el bit b de cada byte al byte alto */
+    int cols = game->map->cols;
+    for (int y = 0; y < game->map->rows; y++) {
+        const uint8_t *row = &MAP_AT(game->map, 0, y);
+        size_t row_word = (size_t)y * boards->words;
+        for (int x0 = 0; x0 < cols; x0 += 64) {
+            int n = cols - x0 < 64 ? cols - x0 : 64;
+            uint64_t acc[PHASE_COUNT + 2] = {0};
+            for (int i = 0; i < n; i += 8) {
+                uint64_t packed = 0;
+                for (int j = 0; j < 8 && i + j < n; j++) {
+                    uint8_t cell = row[x0 + i + j];
+                    packed |= (uint64_t)boards->cell_bits[cell] << (8 * j);
+                    if (cell == CELL_EXPLOSION)
+                        explosion_mark(game, ivec2(x0 + i + j, y));
+                }
+                for (int b = 0; b < PHASE_COUNT + 2; b++) {
+                    uint64_t low = (packed >> b) & PASS_LOW_BITS;
+                    acc[b] |= ((low * PASS_GATHER) >> 56) << i;
                 }
             }
+            size_t word = row_word + (x0 >> 6);
+            for (int phase = 0; phase < PHASE_COUNT; phase++)
+                boards->passable[phase][word] = acc[phase];
+            boards->passable_superposed[word] = acc[PHASE_COUNT];
+            boards->walkable[word] = acc[PHASE_COUNT + 1];
         }
     }
-    return true;
+}
+
+uint64_t board_window(const uint64_t *row, int x) {
+    int shift = x & 63;
+    row += x >> 6;
+    if (shift == 0)
+        return row[0];
+    return (row[0] >> shift) | (row[1] << (64 - shift));
+}
+
+/* Tablero que decide por dónde puede pasar el jugador ahora mismo */
+const uint64_t *player_passability(GameState *game) {
+    const QuantumPhaseSystem *phase = &game->player.phase_system;
+    if (phase->state == PHASE_STATE_SUPERPOSITION)
+        return game->passability.passable_superposed;
+    return game->passability.passable[phase->current_phase];
+}
+
+/* ===== ÍNDICE ESPACIAL DE ENTIDADES ===== */
+
+static EntityRef *entity_link(GameState *game, EntityRef ref) {
+    int index = ENTITY_REF_INDEX(ref);
+    switch (ENTITY_REF_KIND(ref)) {
+    case ENTITY_ITEM:
+        return &game->items[index].next_at_cell;
+    case ENTITY_BUTTON:
+        return &game->buttons[index].next_at_cell;
+    case ENTITY_PORTAL:
+        return &game->portals[index].next_at_cell;
+    case ENTITY_ORACLE:
+        return &game->oracles[index].next_at_cell;
+    default:
+        return NULL;
+    }
+}
+
+void entity_index_insert(GameState *game, EntityRef ref, IVector2 pos) {
+    if (!within_map(game, pos))
+        return;
+    EntityRef *link = &game->entity_heads[pos.y * game->map->cols + pos.x];
+    while (*link && *link < ref)
+        link = entity_link(game, *link);
+    *entity_link(game, ref) = *link;
+    *link = ref;
+}
+
+void entity_index_remove(GameState *game, EntityRef ref, IVector2 pos) {
+    if (!within_map(game, pos))
+        return;
+    EntityRef *link = &game->entity_heads[pos.y * game->map->cols + pos.x];
+    while (*link && *link != ref)
+        link = entity_link(game, *link);
+    if (*link)
+        *link = *entity_link(game, ref);
+}
+
+EntityRef entity_index_at(GameState *game, IVector2 pos) {
+    if (!within_map(game, pos))
+        return 0;
+    return game->entity_heads[pos.y * game->map->cols + pos.x];
+}
+
+EntityRef entity_index_next(GameState *game, EntityRef ref) {
+    return *entity_link(game, ref);
 }
 
 Color get_cell_color(Cell cell, PhaseKind current_phase,
@@ -285,6 +576,41 @@ void init_palette(void) {
     PALETTE[24] = (Color){255, 0, 255, 255};  /* Púrpura Lógico */
 }
 
+/* Memoria que cuelga del nivel: la arena se dimensiona aquí para todo el
+ * scratch que la simulación pide al cargarlo */
+static size_t level_arena_bytes(int rows, int cols) {
+    size_t cells = (size_t)rows * (size_t)cols;
+    size_t board = (size_t)rows * passability_words(cols) * sizeof(uint64_t);
+    return 2 * cells * sizeof(IVector2) + ARENA_ALIGNMENT +
+           (MAX_DISTANCE_FIELDS + 1) *
+               (cells * (sizeof(uint16_t) + 2 * sizeof(uint32_t)) +
+                3 * ARENA_ALIGNMENT) +
+           cells * sizeof(unsigned char) + 2 * ARENA_ALIGNMENT +
+           cells * sizeof(EntityRef) + ARENA_ALIGNMENT +
+           (2 * PHASE_COUNT + 3) * (board + ARENA_ALIGNMENT);
+}
+
+void free_level_state(GameState *game) {
+    if (game->map) {
+        map_free(game->map);
+        game->map = NULL;
+    }
+    arena_free(&game->level_arena);
+    qiskit_measure_cancel(&game->tunnel_ticket);
+    game->bfs_queue = NULL;
+    game->bfs_capacity = 0;
+    memset(game->distance_fields, 0, sizeof(game->distance_fields));
+    memset(&game->colapsor_field, 0, sizeof(game->colapsor_field));
+    game->occupancy = NULL;
+    game->entity_heads = NULL;
+    memset(game->beam_coverage, 0, sizeof(game->beam_coverage));
+    memset(&game->passability, 0, sizeof(game->passability));
+    game->explosion_cells = NULL;
+    game->explosion_count = 0;
+    game->explosion_capacity = 0;
+    game->explosion_overflow = false;
+}
+
 void init_game_state(GameState *game, int rows, int cols) {
     // Respaldar estado persistente
     int saved_level = game->current_level;
@@ -301,16 +627,28 @@ void init_game_state(GameState *game, int rows, int cols) {
     int saved_entanglements = game->player.entanglements_created;
     int saved_phase_shifts = game->player.phase_shifts;
 
-    if (game->map) {
-        map_free(game->map);
+    GameEventSink saved_sink = game->event_sink;
+    void *saved_user = game->event_user;
+
+    /* Reiniciar un nivel (o cargar otro del mismo tamaño) reutiliza el mapa
+     * y la arena: sin free/malloc, y todo lo que vive en la arena se vuelve
+     * a reservar o a rellenar abajo. Las rejillas de distancias que ya se
+     * reservaron se quedan donde estaban, con su generación: no se vuelven
+     * a poner a 0 */
+    Map *reused_map = NULL;
+    Arena reused_arena = {0};
+    DistanceField reused_fields[MAX_DISTANCE_FIELDS];
+    DistanceField reused_colapsor_field;
+    if (game->map && game->map->rows == rows && game->map->cols == cols &&
+        game->level_arena.base) {
+        reused_map = game->map;
+        reused_arena = game->level_arena;
+        memcpy(reused_fields, game->distance_fields, sizeof(reused_fields));
+        reused_colapsor_field = game->colapsor_field;
         game->map = NULL;
+        game->level_arena = (Arena){0};
     }
-    for (int i = 0; i < MAX_COLAPSORES; i++) {
-        if (game->colapsores[i].path) {
-            path_free(game->colapsores[i].path, game->colapsores[i].path_rows);
-            game->colapsores[i].path = NULL;
-        }
-    }
+    free_level_state(game);
 
     memset(game, 0, sizeof(GameState));
 
@@ -328,7 +666,62 @@ void init_game_state(GameState *game, int rows, int cols) {
     game->player.entanglements_created = saved_entanglements;
     game->player.phase_shifts = saved_phase_shifts;
 
-    game->map = map_create(rows, cols);
+    game->event_sink = saved_sink;
+    game->event_user = saved_user;
+
+    if (reused_map) {
+        game->map = reused_map;
+        map_clear(game->map);
+        game->level_arena = reused_arena;
+        arena_reset(&game->level_arena);
+    } else {
+        game->map = map_create(rows, cols);
+        arena_init(&game->level_arena, level_arena_bytes(rows, cols));
+    }
+    game->bfs_queue = arena_alloc(&game->level_arena,
+                                  (size_t)rows * cols * sizeof(IVector2),
+                                  sizeof(IVector2));
+    game->bfs_capacity = game->bfs_queue ? rows * cols : 0;
+    game->explosion_cells = arena_alloc(&game->level_arena,
+                                        (size_t)rows * cols * sizeof(IVector2),
+                                        ARENA_ALIGNMENT);
+    game->explosion_capacity = game->explosion_cells ? rows * cols : 0;
+    game->occupancy =
+        arena_alloc(&game->level_arena, (size_t)rows * cols, ARENA_ALIGNMENT);
+    if (game->occupancy)
+        memset(game->occupancy, 0, (size_t)rows * cols);
+    game->entity_heads =
+        arena_alloc(&game->level_arena, (size_t)rows * cols * sizeof(EntityRef),
+                    ARENA_ALIGNMENT);
+    if (game->entity_heads)
+        memset(game->entity_heads, 0, (size_t)rows * cols * sizeof(EntityRef));
+    PassabilityBoards *boards = &game->passability;
+    boards->words = passability_words(cols);
+    size_t board_bytes = (size_t)rows * boards->words * sizeof(uint64_t);
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        boards->passable[phase] =
+            arena_alloc(&game->level_arena, board_bytes, ARENA_ALIGNMENT);
+    }
+    boards->passable_superposed =
+        arena_alloc(&game->level_arena, board_bytes, ARENA_ALIGNMENT);
+    boards->walkable =
+        arena_alloc(&game->level_arena, board_bytes, ARENA_ALIGNMENT);
+    boards->footprint =
+        arena_alloc(&game->level_arena, board_bytes, ARENA_ALIGNMENT);
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        game->beam_coverage[phase] =
+            arena_alloc(&game->level_arena, board_bytes, ARENA_ALIGNMENT);
+    }
+    if (reused_map) {
+        /* Lo de arriba ha caído donde estaba; detrás van las rejillas */
+        game->level_arena.used = reused_arena.used;
+        memcpy(game->distance_fields, reused_fields, sizeof(reused_fields));
+        game->colapsor_field = reused_colapsor_field;
+        for (int i = 0; i < MAX_DISTANCE_FIELDS; i++)
+            game->distance_fields[i].valid = false;
+        game->colapsor_field.valid = false;
+    }
+    game->beam_generation = 1; // Ningún detector tiene aún su rayo al día
     game->player.position = ivec2(1, 1);
     game->player.prev_position = game->player.position;
     game->player.eyes = EYES_OPEN;
@@ -356,9 +749,6 @@ void init_game_state(GameState *game, int rows, int cols) {
 
     for (int i = 0; i < MAX_COLAPSORES; i++) {
         game->colapsores[i].dead = true;
-        game->colapsores[i].path = path_create(rows, cols);
-        game->colapsores[i].path_rows = rows;
-        game->colapsores[i].path_cols = cols;
     }
 
     for (int i = 0; i < MAX_ECHOS; i++) {
@@ -377,6 +767,7 @@ void init_game_state(GameState *game, int rows, int cols) {
 
     // Init player qubits
     game->player.qubit_count = 0;
+    init_quantum_register(&game->player.qreg);
     for (int i = 0; i < MAX_QUBITS; i++) {
         init_qubit(&game->player.qubits[i]);
         game->player.qubits[i].active = false;
@@ -385,13 +776,9 @@ void init_game_state(GameState *game, int rows, int cols) {
     game->exit_position = ivec2(-1, -1);
     game->has_checkpoint = false;
 
-    int sw = GetScreenWidth();
-    int sh = GetScreenHeight();
-    if (sw <= 0)
-        sw = SCREEN_WIDTH;
-    if (sh <= 0)
-        sh = SCREEN_HEIGHT;
-    game->camera.offset = (Vector2){sw * 0.5f, sh * 0.5f};
+    // El bucle principal ajusta el offset a la ventana real cada frame
+    game->camera.offset =
+        (Vector2){SCREEN_WIDTH * 0.5f, SCREEN_HEIGHT * 0.5f};
     game->camera.target =
         (Vector2){cols * CELL_SIZE * 0.5f, rows * CELL_SIZE * 0.5f};
     game->camera.rotation = 0.0f;
@@ -14,21 +14,66 @@ Vector2 vec2_add(Vector2 a, Vector2 b);
 IVector2 ivec2_scale(IVector2 v, int s);
 
 Map *map_create(int rows, int cols);
+void map_clear(Map *map);
 void map_free(Map *map);
-int **path_create(int rows, int cols);
-void path_free(int **path, int rows);
-void path_reset(int **path, int rows, int cols);
+
+void *aligned_malloc(size_t size, size_t alignment);
+void aligned_free(void *ptr);
+
+bool arena_init(Arena *arena, size_t size);
+void *arena_alloc(Arena *arena, size_t size, size_t alignment);
+void arena_reset(Arena *arena);
+void arena_free(Arena *arena);
 
 Vector2 Vector2LerpCustom(Vector2 v1, Vector2 v2, float amount);
 
 bool within_map(GameState *game, IVector2 pos);
 bool inside_of_rect(IVector2 start, IVector2 size, IVector2 point);
 bool colapsor_can_stand_here(GameState *game, IVector2 start, int colapsor_idx);
+// Mantienen la rejilla de ocupación (GameState.occupancy): usar siempre
+// estas en vez de escribir position/dead de un colapsor a mano
+void colapsor_occupy(GameState *game, int colapsor_idx);
+void colapsor_move(GameState *game, int colapsor_idx, IVector2 pos);
+void colapsor_kill(GameState *game, int colapsor_idx);
+
+// Índice espacial de entidades (GameState.entity_heads). Las listas de
+// cada casilla van ordenadas por referencia, así que recorrerlas visita
+// cada tipo en el mismo orden que el array.
+void entity_index_insert(GameState *game, EntityRef ref, IVector2 pos);
+void entity_index_remove(GameState *game, EntityRef ref, IVector2 pos);
+EntityRef entity_index_at(GameState *game, IVector2 pos);
+EntityRef entity_index_next(GameState *game, EntityRef ref);
+
+// Bitboards de paso (GameState.passability). BOARD_BIT lee la casilla
+// (x, y) de un tablero; board_window devuelve los 64 bits de una fila a
+// partir de la columna x (x < cols).
+#define BOARD_BIT(board, words, x, y)                                          \
+    (((board)[(size_t)(y) * (words) + ((x) >> 6)] >> ((x) & 63)) & 1u)
+#define BOARD_ROW_MASK(width)                                                  \
+    ((width) >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << (width)) - 1))
+void map_set_cell(GameState *game, IVector2 pos, Cell cell);
+// Tras construir un mapa escribiendo celdas a mano (load_level ya lo hace)
+void map_rebuild_passability(GameState *game);
+uint64_t board_window(const uint64_t *row, int x);
+const uint64_t *player_passability(GameState *game);
+
+// Claves Zobrist implícitas (SplitMix64 de índice y valor): no hay tabla que
+// reservar ni que dimensionar con el mapa
+uint64_t zobrist_key(uint64_t index, unsigned value);
+// Hash de todas las casillas; la primera llamada tras cargar el nivel lo
+// calcula entero y a partir de ahí map_set_cell lo actualiza
+uint64_t map_cell_hash(GameState *game);
+
+// Azar de la lógica de juego. Es rand() hasta que el hilo llama a
+// game_rand_seed; desde entonces ese hilo usa su propio generador
+int game_rand(void);
+void game_rand_seed(uint64_t seed);
 
 Color get_cell_color(Cell cell, PhaseKind current_phase, bool in_superposition);
 bool is_cell_solid_for_phase(Cell cell, PhaseKind phase, bool in_superposition);
 
 void init_palette(void);
 void init_game_state(GameState *game, int rows, int cols);
+void free_level_state(GameState *game);
 
 #endif
\ No newline at end of file
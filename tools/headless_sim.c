@@ -0,0 +1,119 @@
+/* Simulación sin ventana ni audio: juega comandos aleatorios en todos los
+ * niveles enlazando sólo libphaseshift_core y mide turnos por segundo.
+ *
+ *   make bench-headless
+ *   ./headless_sim [turnos_por_nivel] [semilla]
+ *
+ * El generador cuántico usa el simulador local con semilla (no hace falta
+ * el servidor); QISKIT_SEED cambia la semilla de ese simulador. */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "events.h"
+#include "levels.h"
+#include "logic.h"
+#include "qiskit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define HEADLESS_DEFAULT_TURNS 2000
+
+typedef struct {
+    long events[EVENT_PLAYER_DIED + 1];
+} HeadlessEventCounts;
+
+static double headless_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* Sink de prueba: sólo cuenta lo que el front-end tendría que presentar */
+static void headless_count_event(const GameEvent *event, void *user) {
+    HeadlessEventCounts *counts = (HeadlessEventCounts *)user;
+    counts->events[event->kind]++;
+}
+
+static Command headless_random_command(void) {
+    static const CommandKind kinds[] = {
+        CMD_STEP,          CMD_STEP,      CMD_STEP,    CMD_STEP,
+        CMD_PHASE_CHANGE,  CMD_WAIT,      CMD_PLANT,   CMD_ENTANGLE,
+        CMD_SUPERPOSITION, CMD_INTERACT};
+    Command cmd = {0};
+    cmd.kind = kinds[rand() % (int)(sizeof(kinds) / sizeof(kinds[0]))];
+    cmd.dir = (Direction)(rand() % 4);
+    return cmd;
+}
+
+int main(int argc, char **argv) {
+    int turns_per_level = argc > 1 ? atoi(argv[1]) : HEADLESS_DEFAULT_TURNS;
+    unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10)
+                                 : 1u;
+    if (turns_per_level <= 0)
+        turns_per_level = HEADLESS_DEFAULT_TURNS;
+    srand(seed);
+    qiskit_set_local_only(true);
+
+    static GameState game;
+    HeadlessEventCounts counts = {0};
+    game.pending_next_level = -1;
+    game.state_kind = GAME_STATE_PLAYING;
+    game_set_event_sink(&game, headless_count_event, &counts);
+
+    printf("Simulacion headless: %d turnos por nivel, semilla %u, backend %s\n",
+           turns_per_level, seed, qiskit_backend_name());
+    printf("%-6s %10s %8s %8s %12s\n", "nivel", "turnos", "muertes",
+           "salidas", "turnos/s");
+
+    long total_turns = 0;
+    double total_time = 0.0;
+    for (int level = 0; level < MAX_LEVELS; level++) {
+        game.current_level = level;
+        load_level(&game, level);
+
+        int deaths = 0, exits = 0;
+        double start = headless_now();
+        for (int t = 0; t < turns_per_level; t++) {
+            execute_turn(&game, headless_random_command());
+            if (game.player.dead || check_level_complete(&game)) {
+                if (game.player.dead)
+                    deaths++;
+                else
+                    exits++;
+                load_level(&game, level);
+            }
+        }
+        double elapsed = headless_now() - start;
+
+        total_turns += turns_per_level;
+        total_time += elapsed;
+        printf("%-6d %10d %8d %8d %12.0f\n", level + 1, turns_per_level,
+               deaths, exits, elapsed > 0.0 ? turns_per_level / elapsed : 0.0);
+    }
+
+    printf("total: %ld turnos en %.3f s (%.0f turnos/s)\n", total_turns,
+           total_time, total_time > 0.0 ? total_turns / total_time : 0.0);
+    printf("eventos: %ld sonidos, %ld chispas, %ld textos, %ld muertes\n",
+           counts.events[EVENT_SOUND], counts.events[EVENT_SPARKS],
+           counts.events[EVENT_FLOATING_TEXT] +
+               counts.events[EVENT_CENTERED_TEXT],
+           counts.events[EVENT_PLAYER_DIED]);
+
+    free_level_state(&game);
+    qiskit_shutdown();
+    return 0;
+}
@@ -0,0 +1,145 @@
+/* Compila los niveles escritos en C (load_level_N) al formato binario .psl
+ * que load_level mapea en memoria (src/level_file.h). Cada fichero se vuelve
+ * a cargar y se compara con el nivel construido en C antes de darlo por
+ * bueno.
+ *
+ *   make levels
+ *   ./level_compiler [directorio]      (por defecto assets/levels)
+ *
+ * Los .psl no se versionan. Llevan la huella de src/levels.c, así que al
+ * tocar un load_level_N el juego los descarta hasta regenerarlos. */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "level_file.h"
+#include "levels.h"
+#include "logic.h"
+#include "qiskit.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+#define COMPILER_TIMING_RUNS 200
+
+static double compiler_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static bool compiler_make_dir(const char *dir) {
+#ifdef _WIN32
+    return _mkdir(dir) == 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(dir, 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+#define SAME_ARRAY(field) (memcmp(a->field, b->field, sizeof(a->field)) == 0)
+
+/* El nivel cargado del .psl tiene que ser idéntico al construido en C */
+static const char *compiler_compare(GameState *a, GameState *b) {
+    if (a->map->rows != b->map->rows || a->map->cols != b->map->cols)
+        return "tamaño";
+    for (int y = 0; y < a->map->rows; y++) {
+        if (memcmp(&MAP_AT(a->map, 0, y), &MAP_AT(b->map, 0, y),
+                   (size_t)a->map->cols) != 0)
+            return "casillas";
+    }
+    if (!SAME_ARRAY(items) || !SAME_ARRAY(buttons) || !SAME_ARRAY(portals) ||
+        !SAME_ARRAY(oracles) || !SAME_ARRAY(detectors) ||
+        !SAME_ARRAY(tunnels) || !SAME_ARRAY(colapsores))
+        return "entidades";
+    size_t heads = (size_t)a->map->rows * a->map->cols * sizeof(EntityRef);
+    if (memcmp(a->entity_heads, b->entity_heads, heads) != 0 ||
+        memcmp(a->occupancy, b->occupancy,
+               (size_t)a->map->rows * a->map->cols) != 0)
+        return "índices";
+    if (a->trigger_count != b->trigger_count ||
+        a->trigger_cell_count != b->trigger_cell_count ||
+        !SAME_ARRAY(triggers) || !SAME_ARRAY(trigger_cells))
+        return "disparadores";
+    if (memcmp(&a->player, &b->player, sizeof(a->player)) != 0 ||
+        !ivec2_eq(a->exit_position, b->exit_position) ||
+        a->current_level != b->current_level ||
+        a->beam_generation != b->beam_generation ||
+        strcmp(a->level_name, b->level_name) != 0)
+        return "estado del nivel";
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : LEVEL_FILE_DIR;
+    static GameState built, loaded;
+    qiskit_set_local_only(true);
+
+    if (!compiler_make_dir(dir)) {
+        printf("No se puede crear %s\n", dir);
+        return 1;
+    }
+
+    printf("%-6s %-38s %9s %10s %10s\n", "nivel", "nombre", "bytes",
+           "C (us)", "psl (us)");
+    int failures = 0;
+    for (int level = 0; level < MAX_LEVELS; level++) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/level_%02d.psl", dir, level + 1);
+
+        build_level(&built, level);
+        show_level_dialog(&built);
+        if (!level_file_write(&built, built.dialog.pages[0].text, path)) {
+            failures++;
+            continue;
+        }
+
+        const char *diff = level_file_load(&loaded, path)
+                               ? compiler_compare(&built, &loaded)
+                               : "no se puede cargar";
+        if (diff) {
+            printf("%s: distinto del nivel en C (%s)\n", path, diff);
+            remove(path);
+            failures++;
+            continue;
+        }
+
+        double start = compiler_now();
+        for (int i = 0; i < COMPILER_TIMING_RUNS; i++)
+            build_level(&built, level);
+        double c_us = (compiler_now() - start) * 1e6 / COMPILER_TIMING_RUNS;
+        start = compiler_now();
+        for (int i = 0; i < COMPILER_TIMING_RUNS; i++)
+            level_file_load(&loaded, path);
+        double psl_us = (compiler_now() - start) * 1e6 / COMPILER_TIMING_RUNS;
+
+        FILE *file = fopen(path, "rb");
+        long bytes = 0;
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            bytes = ftell(file);
+            fclose(file);
+        }
+        printf("%-6d %-38s %9ld %10.2f %10.2f\n", level + 1, built.level_name,
+               bytes, c_us, psl_us);
+    }
+
+    free_level_state(&built);
+    free_level_state(&loaded);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,2237 @@
+/* Resuelve los niveles con una búsqueda A* sobre los turnos de
+ * execute_turn: encuentra la secuencia de comandos más corta hasta la
+ * salida (o dice que no la hay dentro de los límites) para comprobar que un
+ * nivel sigue teniendo solución después de tocarlo.
+ *
+ *   make solve
+ *   ./level_solver [nivel] [max_nodos] [bits_tabla] [hilos] [determinista]
+ *                  [max_MB]
+ *
+ * Sin nivel se resuelven los MAX_LEVELS. Un nivel queda verificado si se
+ * resuelve y la solución llega a la salida con todas las secuencias de
+ * azar con que se prueba; el límite de nodos, la memoria llena o una
+ * solución que sólo vale con su semilla lo dejan sin verificar, y entonces
+ * sale con 1. Sin máximo de nodos (o con 0) cada nivel se busca con el de
+ * SOLVER_EXPECTED y los turnos se comparan además con los apuntados: si
+ * cambian también sale con 1. La memoria de la búsqueda (nodos, cubos con
+ * los deltas pendientes, imágenes) no pasa de max_MB; al llegar el nivel
+ * sale como "sin memoria".
+ *
+ * Cada estado se identifica con game_state_hash (las casillas y los
+ * objetos llevan hashes Zobrist que se mantienen al cambiar; el resto del
+ * estado, vector de estado y ecos incluidos, se recorre en cada llamada) en
+ * una tabla de transposición de tamaño fijo, 2^bits_tabla entradas: si se
+ * llena la búsqueda se corta y el nivel sale como "tabla llena", no se
+ * agranda. La coherencia se queda fuera de la clave: sólo importa al llegar
+ * a 0, así que un estado ya visto con no más turnos y no menos coherencia
+ * gana al nuevo.
+ *
+ * La heurística es la distancia a la salida en un mapa relajado: todo lo
+ * que no es CELL_WALL se puede pisar (fases, puertas, barricadas...), y
+ * resbalar por hielo, los portales y los túneles no cuestan turnos. Si con
+ * las puertas o las casillas de un disparador cerradas no se llega, el
+ * jugador tiene que pasar antes por una llave o por los botones, y se
+ * cuenta el recorrido más corto que los toca. Nunca sobreestima, así que
+ * la primera solución que sale es la más corta.
+ *
+ * Los turnos tienen azar (colapsores que deambulan, medidas cuánticas):
+ * antes de cada turno se siembran game_rand() y el simulador local de
+ * qiskit del hilo con el hash del estado y el comando, así que un turno
+ * es función del estado y la solución encontrada se repite igual al
+ * volver a jugarla (y se comprueba así antes de darla por buena). Eso sólo
+ * demuestra que se llega con esa suerte: después se juega con otras
+ * SOLVER_STREAMS secuencias de azar y, si con alguna no llega, el nivel
+ * sale como "solo con semilla". No se buscan soluciones que valgan para
+ * cualquier resultado del azar.
+ *
+ * De cada estado pendiente sólo se guarda en qué difiere del estado inicial,
+ * por palabras de 64 bits, sobre una imagen con los campos del GameState y
+ * los arrays del nivel que escriben los turnos (solver_build_segments).
+ *
+ * Busca con varios hilos, por defecto uno por núcleo. Cada uno tiene su
+ * partida y sus cubos; la tabla y los nodos son comunes. Los cubos se
+ * recorren todos a la vez por orden de f: cada hilo saca los estados del
+ * cubo actual de su cola doble y, cuando se le acaba, roba por el otro
+ * extremo de la de otro hilo. Los deltas sólo valen en la partida del hilo
+ * que los apiló: el que roba un estado vuelve a jugar su camino desde su
+ * propio estado inicial. La tabla está partida en fragmentos y se escribe
+ * con CAS, sin cerrojos.
+ *
+ * La primera solución que sale sigue siendo de las más cortas, pero cuál
+ * depende de qué hilo llega antes. En modo determinista cada cubo se parte
+ * también por turnos y se recorre en tres fases separadas por barreras:
+ * expandir sin escribir en la tabla, escribir los hijos (a igual número de
+ * turnos gana la mayor coherencia y después un desempate que sale del padre
+ * y el comando, no del orden de llegada) y apilar los que ganaron. Así la
+ * solución y los nodos son los mismos con cualquier número de hilos. */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "levels.h"
+#include "logic.h"
+#include "qiskit.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#define SOLVER_STREAMS 32 // Secuencias de azar con que se prueba la solución
+#define SOLVER_DEFAULT_TABLE_BITS 22
+#define SOLVER_DEFAULT_MEMORY_MB 2048
+#define SOLVER_TABLE_MAX_LOAD 0.75 // Más lleno, las sondas se disparan
+#define SOLVER_NO_PARENT 0xFFFFFFFFu
+#define SOLVER_UNREACHABLE 0xFFFF // Heurística: la salida no se alcanza
+#define SOLVER_MAX_DEPTH 0xFFFE
+#define SOLVER_MAX_GATES 4
+#define SOLVER_MAX_LANDMARKS 16
+#define SOLVER_MAX_GROUPS 4
+#define SOLVER_MAX_THREADS 64
+#define SOLVER_MAX_BUCKETS (1 << 24)
+
+typedef enum {
+    SOLVER_SOLVED,
+    SOLVER_EXHAUSTED, // No hay salida alcanzable
+    SOLVER_NODE_LIMIT,
+    SOLVER_TABLE_FULL,
+    SOLVER_NO_MEMORY
+} SolverResult;
+
+static const char *const SOLVER_RESULT_NAMES[] = {
+    "resuelto", "sin salida", "limite de nodos", "tabla llena", "sin memoria"};
+
+/* Resuelto, pero la solución no llega a la salida con todas las
+ * secuencias de azar con que se prueba */
+#define SOLVER_SEEDED_NAME "solo con semilla"
+
+/* Lo que da cada nivel sin máximo de nodos en la línea de órdenes, en
+ * modo rápido y en determinista: con cuántos nodos se busca (de sobra para
+ * lo que hace falta hoy) y los turnos de la solución, aunque sólo llegue
+ * con su semilla (-1: no sale ninguna dentro del presupuesto; la
+ * heurística se queda corta y la búsqueda no cabe en memoria). Esto no da
+ * nada por bueno: un nivel sin verificar hace fallar la prueba igual. Que
+ * los turnos dejen de coincidir dice que se ha roto algo o que hay que
+ * poner esto al día */
+typedef struct {
+    long max_nodes;
+    int turns;
+} SolverExpected;
+
+static const SolverExpected SOLVER_EXPECTED[2][MAX_LEVELS] = {
+    {{1000, 17},    {5000, 24},   {5000, 18},   {20000, -1},  {1000, 36},
+     {20000, -1},   {20000, -1},  {20000, -1},  {300000, 40}, {1000, 19},
+     {1000, 25},    {1000, 23},   {20000, -1},  {1000, 17},   {20000, -1},
+     {1000, 31},    {1000, 18},   {5000, 46},   {100000, 31}, {20000, -1}},
+    {{1000, 17},    {15000, 24},  {10000, 18},  {20000, -1},  {1000, 36},
+     {20000, -1},   {20000, -1},  {20000, -1},  {20000, -1},  {1000, 19},
+     {1000, 25},    {1000, 23},   {20000, -1},  {1000, 17},   {20000, -1},
+     {100000, 31},  {5000, 18},   {50000, 46},  {20000, -1},  {20000, -1}}};
+
+/* Comandos que se prueban en cada estado, con la letra con la que salen en
+ * la solución */
+static const Command SOLVER_COMMANDS[] = {
+    {CMD_STEP, DIR_UP},       {CMD_STEP, DIR_DOWN},
+    {CMD_STEP, DIR_LEFT},     {CMD_STEP, DIR_RIGHT},
+    {CMD_WAIT, DIR_UP},       {CMD_PHASE_CHANGE, DIR_UP},
+    {CMD_INTERACT, DIR_UP},   {CMD_PLANT, DIR_UP},
+    {CMD_ENTANGLE, DIR_UP},   {CMD_SUPERPOSITION, DIR_UP}};
+static const char SOLVER_COMMAND_LETTERS[] = "UDLR.FIPES";
+#define SOLVER_COMMAND_COUNT                                                   \
+    ((int)(sizeof(SOLVER_COMMANDS) / sizeof(SOLVER_COMMANDS[0])))
+#define SOLVER_WAIT_COMMAND 4
+
+/* Trozo de memoria que forma parte de la imagen del estado */
+typedef struct {
+    unsigned char *data;
+    size_t words;
+} SolverSegment;
+
+#define SOLVER_MAX_SEGMENTS 64
+
+/* Las imágenes se comparan y se restauran por bloques de palabras, cada uno
+ * dentro de un solo segmento */
+#define SOLVER_BLOCK_WORDS 8
+
+typedef struct {
+    uint64_t *live; // Dónde está en la partida
+    uint32_t start; // Primera palabra en la imagen
+    uint32_t words;
+} SolverBlock;
+
+/* Estados pendientes con el mismo coste estimado (f = turnos + heurística):
+ * deltas contra la imagen inicial seguidos en un único buffer, usado como
+ * pila (a igual f se sigue por el más profundo). Cada delta son tramos
+ * {palabra inicial, nº de palabras} con sus palabras detrás, terminados en
+ * un tramo vacío. */
+typedef struct {
+    uint64_t *words;
+    size_t used, capacity;
+    size_t *offsets; // Inicio del delta de cada estado
+    uint32_t *ids;   // Nodo de cada estado (índice en parents)
+    size_t count, slots;
+} SolverBucket;
+
+/* Algo cerrado que hay que abrir para llegar a la salida: las puertas (con
+ * una llave) o las casillas de un disparador (pisando sus botones) */
+typedef struct {
+    int trigger;      // -1: las puertas
+    int door_count;   // Puertas al cargar el nivel
+    uint16_t *closed; // Distancia a la salida sin abrirlo
+} SolverGate;
+
+/* Casilla por la que abre una puerta: una llave o un botón */
+typedef struct {
+    IVector2 position;
+    int gate;           // Índice en Solver.gates
+    uint16_t *distance; // Turnos de cada casilla hasta aquí
+} SolverLandmark;
+
+/* Nodo del árbol de búsqueda: de dónde viene, para sacar el camino */
+typedef struct {
+    uint32_t parent;
+    uint16_t depth;
+    unsigned char command;
+} SolverNode;
+
+/* Los nodos van en bloques que no se mueven: hasta 2^31 */
+#define SOLVER_NODE_CHUNK_BITS 14
+#define SOLVER_NODE_CHUNK (1u << SOLVER_NODE_CHUNK_BITS)
+#define SOLVER_MAX_NODE_CHUNKS (1u << 17)
+
+/* Entrada de la tabla en una sola palabra, para cambiarla con un CAS:
+ * turnos, coherencia y el desempate del modo determinista */
+#define SOLVER_ENTRY(depth, coherence, tie)                                    \
+    ((uint64_t)(depth) << 48 | (uint64_t)(uint16_t)(coherence) << 32 |        \
+     (uint32_t)(tie))
+#define SOLVER_ENTRY_DEPTH(entry) ((int)((entry) >> 48))
+#define SOLVER_ENTRY_COHERENCE(entry) ((int)(int16_t)((entry) >> 32))
+#define SOLVER_ENTRY_TIE(entry) ((uint32_t)(entry))
+#define SOLVER_ENTRY_NONE SOLVER_ENTRY(0xFFFF, INT16_MIN, 0xFFFFFFFFu)
+
+/* Fragmento de la tabla de transposición (lo eligen los bits altos del
+ * hash): direccionamiento abierto con su propia cuenta de ocupación, que
+ * así no es un contador que se disputen todos los hilos */
+typedef struct {
+    uint64_t *keys;    // Hashes, 0 = libre
+    uint64_t *entries; // SOLVER_ENTRY
+    size_t mask, limit;
+    size_t used;                 // Atómico
+    unsigned char padding[24]; // Cada fragmento en su línea de caché
+} SolverShard;
+
+#define SOLVER_SHARD_BITS 6
+#define SOLVER_SHARD_COUNT (1 << SOLVER_SHARD_BITS)
+
+/* Cola doble de Chase-Lev con los nodos del cubo que se está recorriendo:
+ * el dueño apila y saca por abajo, los demás hilos roban por arriba. Los
+ * índices sólo crecen dentro del cubo y son los del SolverBucket. El
+ * ladrón sólo lee el nodo: al crecer, el array viejo se guarda en
+ * Solver.retired hasta el siguiente cubo. */
+typedef struct {
+    uint32_t *items; // Atómico
+    size_t capacity;
+    int64_t top;    // Atómico
+    int64_t bottom; // Atómico
+} SolverDeque;
+
+/* Modo determinista: hijo pendiente de escribir en la tabla. Su delta va
+ * en Solver.pending con el mismo índice */
+typedef struct {
+    uint64_t key;
+    uint64_t entry;
+    uint32_t parent;
+    unsigned char command;
+    int priority; // Cubo al que va si gana
+} SolverCandidate;
+
+typedef struct {
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif
+    int count, waiting;
+    unsigned generation;
+    const int *watch; // Se lee al soltar a todos
+    int seen;
+} SolverBarrier;
+
+typedef struct SolverShared SolverShared;
+
+/* Un hilo de búsqueda: su partida con las imágenes, la heurística y sus
+ * cubos de estados pendientes */
+typedef struct {
+    SolverShared *shared;
+    int index;
+    GameState game;
+    SolverSegment segments[SOLVER_MAX_SEGMENTS];
+    int segment_count;
+    size_t image_words;
+    uint64_t *root;   // Imagen del estado inicial
+    uint64_t *parent; // Imagen del estado que se está expandiendo
+    SolverBlock *blocks;
+    uint32_t *word_block; // Bloque de cada palabra de la imagen
+    size_t block_count;
+    uint32_t *parent_blocks; // Bloques en que el padre difiere de la raíz
+    uint32_t *dirty;         // y los que tocó el último turno
+    size_t parent_block_count, dirty_count;
+    unsigned char *replay; // Camino de un nodo robado que hay que rejugar
+    uint16_t *heuristic;   // Por casilla, turnos mínimos hasta la salida
+    SolverGate gates[SOLVER_MAX_GATES];
+    SolverLandmark landmarks[SOLVER_MAX_LANDMARKS];
+    int gate_count, landmark_count;
+
+    SolverBucket *buckets; // Indexado por solver_priority
+    int bucket_count;
+    SolverDeque deque;
+    void **retired; // Arrays que crecieron en el cubo actual
+    size_t retired_count, retired_slots, retired_bytes;
+    SolverBucket pending; // Deltas de los candidatos
+    SolverCandidate *candidates;
+    size_t candidate_count, candidate_slots;
+    bool has_goal; // Salida vista en la fase (modo determinista)
+    uint64_t goal_key;
+    uint32_t goal;
+    int next_priority;
+
+    SolverNode *chunk; // Bloque de nodos que se está llenando
+    uint32_t chunk_base, chunk_used;
+    size_t node_count;
+    uint64_t random; // Víctima de los robos
+    size_t memory, peak_memory;
+    long expanded, steals, replayed;
+    double idle; // Segundos sin nada que expandir
+} Solver;
+
+/* Lo común a todos los hilos */
+struct SolverShared {
+    SolverShard shards[SOLVER_SHARD_COUNT];
+    SolverNode **chunks;
+    uint32_t chunk_count; // Atómico
+    Solver *workers;
+    int thread_count;
+    bool deterministic;
+    long max_nodes;
+    size_t memory_limit; // Bytes de toda la búsqueda (solver_grow)
+    size_t memory_used;  // Atómico: lo que llevan reservado los hilos
+    int start_priority;
+    long expanded; // Atómico
+    long pending;  // Atómico: nodos del cubo actual sin terminar
+    int stop;      // Atómico: quien lo pone a 1 escribe result y goal
+    SolverResult result;
+    uint32_t goal;
+    SolverBarrier barrier;
+    size_t memory; // La tabla
+};
+
+static double solver_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* realloc con la cuenta de memoria de la búsqueda */
+static bool solver_grow(Solver *solver, void **ptr, size_t old_bytes,
+                        size_t new_bytes) {
+    /* Un solo tope para todos: con uno por hilo, el que se lleva la parte
+     * gorda de la frontera se queda sin memoria mientras a los demás les
+     * sobra */
+    SolverShared *shared = solver->shared;
+    size_t added = new_bytes - old_bytes; // Si encoge, módulo 2^n
+    size_t used =
+        __atomic_add_fetch(&shared->memory_used, added, __ATOMIC_RELAXED);
+    if (new_bytes > old_bytes && used > shared->memory_limit) {
+        __atomic_sub_fetch(&shared->memory_used, added, __ATOMIC_RELAXED);
+        return false;
+    }
+    void *grown = realloc(*ptr, new_bytes);
+    if (!grown) {
+        __atomic_sub_fetch(&shared->memory_used, added, __ATOMIC_RELAXED);
+        return false;
+    }
+    *ptr = grown;
+    solver->memory += new_bytes - old_bytes;
+    if (solver->memory > solver->peak_memory)
+        solver->peak_memory = solver->memory;
+    return true;
+}
+
+/* Lo mismo para lo que pueden estar leyendo otros hilos (la cola doble): el
+ * array viejo no se libera hasta el siguiente cubo (solver_release_retired) */
+static bool solver_grow_stable(Solver *solver, void **ptr, size_t old_bytes,
+                               size_t new_bytes) {
+    if (!*ptr)
+        return solver_grow(solver, ptr, 0, new_bytes);
+    if (solver->retired_count == solver->retired_slots) {
+        size_t slots = solver->retired_slots ? solver->retired_slots * 2 : 8;
+        if (!solver_grow(solver, (void **)&solver->retired,
+                         solver->retired_slots * sizeof(void *),
+                         slots * sizeof(void *)))
+            return false;
+        solver->retired_slots = slots;
+    }
+    void *grown = NULL;
+    if (!solver_grow(solver, &grown, 0, new_bytes))
+        return false;
+    memcpy(grown, *ptr, old_bytes);
+    solver->retired[solver->retired_count++] = *ptr;
+    solver->retired_bytes += old_bytes;
+    __atomic_store_n(ptr, grown, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void solver_release_retired(Solver *solver) {
+    for (size_t r = 0; r < solver->retired_count; r++)
+        free(solver->retired[r]);
+    solver->memory -= solver->retired_bytes;
+    __atomic_sub_fetch(&solver->shared->memory_used, solver->retired_bytes,
+                       __ATOMIC_RELAXED);
+    solver->retired_count = 0;
+    solver->retired_bytes = 0;
+}
+
+/* ----- Turnos deterministas ----- */
+
+/* La coherencia sólo cuenta al llegar a 0, y tener más nunca es peor: se
+ * deja fuera de la clave del estado y la tabla guarda la mejor con la que se
+ * llegó. En ticks, para que baje con cada turno de decay_counter */
+static int solver_coherence(const GameState *game) {
+    const CoherenceSystem *coherence = &game->player.coherence;
+    int ticks = (int)(coherence->current * 5.0f) - coherence->decay_counter;
+    return ticks < INT16_MIN ? INT16_MIN : ticks > INT16_MAX ? INT16_MAX
+                                                             : ticks;
+}
+
+/* game_state_hash sin la coherencia (y nunca 0, que en la tabla es un
+ * hueco libre) */
+static uint64_t solver_state_key(GameState *game) {
+    CoherenceSystem saved = game->player.coherence;
+    game->player.coherence.current = 0.0f;
+    game->player.coherence.decay_counter = 0;
+    uint64_t key = game_state_hash(game);
+    game->player.coherence = saved;
+    return key ? key : 1;
+}
+
+static uint64_t solver_turn_seed(uint64_t key, int command) {
+    return zobrist_key(key, (unsigned)command + 1);
+}
+
+/* La búsqueda juega con la secuencia 0; las demás sólo sirven para ver si
+ * la solución depende de la suerte */
+static void solver_play(GameState *game, uint64_t key, int command,
+                        unsigned stream) {
+    uint64_t seed = solver_turn_seed(key, command);
+    if (stream)
+        seed = zobrist_key(seed, stream);
+    game_rand_seed(seed);
+    qiskit_seed_local(seed);
+    execute_turn(game, SOLVER_COMMANDS[command]);
+}
+
+static bool solver_is_goal(GameState *game) {
+    return !game->player.dead && check_level_complete(game);
+}
+
+/* Con el jugador atascado execute_turn no mira el comando */
+static int solver_command_count(const GameState *game) {
+    return game->player.is_stuck ? 1 : SOLVER_COMMAND_COUNT;
+}
+
+static int solver_command(const GameState *game, int i) {
+    return game->player.is_stuck ? SOLVER_WAIT_COMMAND : i;
+}
+
+/* ----- Heurística ----- */
+
+/* Disparadores que abren casillas al pulsar botones: hasta entonces esas
+ * casillas son puertas que sólo abre quien pise los botones */
+static bool solver_gating_trigger(const LevelTrigger *t) {
+    return t->action == TRIGGER_OPEN_CELLS && t->cell_count > 0 &&
+           (t->condition == TRIGGER_ALL_BUTTONS ||
+            t->condition == TRIGGER_ANY_BUTTON);
+}
+
+/* Qué se da por cerrado al medir distancias: nada, las puertas o las
+ * casillas de un disparador (SOLVER_CLOSED_TRIGGER + índice) */
+#define SOLVER_CLOSED_NONE -2
+#define SOLVER_CLOSED_DOORS -1
+#define SOLVER_CLOSED_TRIGGER 0
+
+/* Relajado: se puede pisar todo lo que no es muro salvo lo que `closed`
+ * deja cerrado, los disparadores pueden abrir muros y un portal deja al
+ * jugador en su casilla aunque sea muro */
+static bool solver_relaxed_passable(GameState *game, int x, int y, int closed) {
+    if (x < 0 || y < 0 || x >= game->map->cols || y >= game->map->rows)
+        return false;
+    Cell cell = MAP_AT(game->map, x, y);
+    if (cell == CELL_DOOR && closed == SOLVER_CLOSED_DOORS)
+        return false;
+    for (int i = 0; i < game->trigger_count; i++) {
+        const LevelTrigger *t = &game->triggers[i];
+        for (int c = t->cell_start; c < t->cell_start + t->cell_count; c++) {
+            if (game->trigger_cells[c].x == x && game->trigger_cells[c].y == y)
+                return closed != SOLVER_CLOSED_TRIGGER + i;
+        }
+    }
+    if (cell != CELL_WALL)
+        return true;
+    for (int i = 0; i < MAX_PORTALS; i++) {
+        if (game->portals[i].linked_portal_index >= 0 &&
+            ivec2_eq(game->portals[i].position, ivec2(x, y)))
+            return true;
+    }
+    return false;
+}
+
+static void solver_relax(uint16_t *dist, int from, int to, int cost) {
+    if (dist[to] != SOLVER_UNREACHABLE && dist[to] + cost < dist[from])
+        dist[from] = (uint16_t)(dist[to] + cost);
+}
+
+/* Turnos mínimos de cada casilla hasta `target` en el mapa relajado, donde
+ * resbalar por hielo, los portales y los túneles no cuestan. Se relaja
+ * hasta que no cambia nada: los mapas son pequeños y así las aristas de
+ * coste 0 no necesitan un Dijkstra */
+static void solver_distance_map(GameState *game, IVector2 target, int closed,
+                                uint16_t *dist) {
+    int rows = game->map->rows, cols = game->map->cols;
+    for (int i = 0; i < rows * cols; i++)
+        dist[i] = SOLVER_UNREACHABLE;
+    if (!within_map(game, target))
+        return;
+    dist[target.y * cols + target.x] = 0;
+
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int y = 0; y < rows; y++) {
+            for (int x = 0; x < cols; x++) {
+                int from = y * cols + x;
+                if (!solver_relaxed_passable(game, x, y, closed))
+                    continue;
+                uint16_t before = dist[from];
+                int step = MAP_AT(game->map, x, y) == CELL_ICE ? 0 : 1;
+                for (int dir = 0; dir < 4; dir++) {
+                    int nx = x + DIRECTION_VECTORS[dir].x;
+                    int ny = y + DIRECTION_VECTORS[dir].y;
+                    if (solver_relaxed_passable(game, nx, ny, closed))
+                        solver_relax(dist, from, ny * cols + nx, step);
+                }
+                for (int i = 0; i < MAX_PORTALS; i++) {
+                    const QuantumPortal *portal = &game->portals[i];
+                    int linked = portal->linked_portal_index;
+                    if (ivec2_eq(portal->position, ivec2(x, y)) &&
+                        linked >= 0 && linked < MAX_PORTALS) {
+                        IVector2 to = game->portals[linked].position;
+                        if (within_map(game, to))
+                            solver_relax(dist, from, to.y * cols + to.x, 0);
+                    }
+                }
+                for (int i = 0; i < MAX_TUNNELS; i++) {
+                    const QuantumTunnel *tunnel = &game->tunnels[i];
+                    IVector2 to =
+                        ivec2_add(tunnel->position, tunnel->target_offset);
+                    if (inside_of_rect(tunnel->position, tunnel->size,
+                                       ivec2(x, y)) &&
+                        within_map(game, to))
+                        solver_relax(dist, from, to.y * cols + to.x, 0);
+                }
+                changed |= dist[from] != before;
+            }
+        }
+    }
+}
+
+static uint16_t *solver_new_distance_map(Solver *solver, IVector2 target,
+                                         int closed) {
+    uint16_t *dist = NULL;
+    size_t bytes = (size_t)solver->game.map->rows * solver->game.map->cols *
+                   sizeof(uint16_t);
+    if (!solver_grow(solver, (void **)&dist, 0, bytes))
+        return NULL;
+    solver_distance_map(&solver->game, target, closed, dist);
+    return dist;
+}
+
+static int solver_door_count(const GameState *game) {
+    int count = 0;
+    for (int y = 0; y < game->map->rows; y++) {
+        for (int x = 0; x < game->map->cols; x++)
+            count += MAP_AT(game->map, x, y) == CELL_DOOR;
+    }
+    return count;
+}
+
+static bool solver_add_landmark(Solver *solver, IVector2 position, int gate) {
+    if (solver->landmark_count == SOLVER_MAX_LANDMARKS)
+        return true; // Sin mapa no se exige pasar por él
+    uint16_t *dist =
+        solver_new_distance_map(solver, position, SOLVER_CLOSED_NONE);
+    if (!dist)
+        return false;
+    SolverLandmark *landmark = &solver->landmarks[solver->landmark_count++];
+    landmark->position = position;
+    landmark->gate = gate;
+    landmark->distance = dist;
+    return true;
+}
+
+/* Distancias a la salida con todo abierto y con cada cosa cerrada (las
+ * puertas, las casillas de cada disparador de botones), y a cada llave y
+ * botón del nivel */
+static bool solver_build_heuristic(Solver *solver) {
+    GameState *game = &solver->game;
+    IVector2 exit = game->exit_position;
+    solver->heuristic =
+        solver_new_distance_map(solver, exit, SOLVER_CLOSED_NONE);
+    if (!solver->heuristic)
+        return false;
+    solver->gate_count = 0;
+    solver->landmark_count = 0;
+
+    int doors = solver_door_count(game);
+    if (doors) {
+        SolverGate *gate = &solver->gates[solver->gate_count++];
+        gate->trigger = -1;
+        gate->door_count = doors;
+        gate->closed =
+            solver_new_distance_map(solver, exit, SOLVER_CLOSED_DOORS);
+        if (!gate->closed)
+            return false;
+        for (int i = 0; i < MAX_ITEMS; i++) {
+            if (game->items[i].kind == ITEM_KEY &&
+                !solver_add_landmark(solver, game->items[i].position, 0))
+                return false;
+        }
+    }
+    for (int t = 0; t < game->trigger_count; t++) {
+        const LevelTrigger *trigger = &game->triggers[t];
+        if (!solver_gating_trigger(trigger) ||
+            solver->gate_count == SOLVER_MAX_GATES)
+            continue;
+        int g = solver->gate_count++;
+        SolverGate *gate = &solver->gates[g];
+        gate->trigger = t;
+        gate->closed = solver_new_distance_map(solver, exit,
+                                               SOLVER_CLOSED_TRIGGER + t);
+        if (!gate->closed)
+            return false;
+        for (int i = 0; i < MAX_BUTTONS; i++) {
+            if ((trigger->buttons & 1u << i) &&
+                !solver_add_landmark(solver, game->buttons[i].position, g))
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Un botón que ya pisa (o pisará) un eco no obliga al jugador a ir */
+static bool solver_button_covered(const GameState *game, IVector2 pos) {
+    const PlayerState *player = &game->player;
+    if (player->is_recording_echo) {
+        for (int f = 0; f < player->recording_frame; f++) {
+            if (ivec2_eq(player->current_recording[f].position, pos))
+                return true;
+        }
+    }
+    for (int e = 0; e < MAX_ECHOS; e++) {
+        const QuantumEcho *echo = &game->echos[e];
+        if (!echo->active)
+            continue;
+        if (ivec2_eq(echo->position, pos))
+            return true;
+        IVector2 replay = echo->position;
+        for (int f = echo->playback_index; f < echo->recording_index; f++) {
+            if (echo->recording[f].action.kind == CMD_STEP)
+                replay = ivec2_add(
+                    replay, DIRECTION_VECTORS[echo->recording[f].action.dir]);
+            if (ivec2_eq(replay, pos))
+                return true;
+        }
+    }
+    return false;
+}
+
+/* Si la puerta sigue exigiendo que el jugador pase por sus marcas (una
+ * llave, los botones) antes de llegar a la salida. Deja de valer cuando ya
+ * se abrió algo, cuando puede aparecer otra llave (los gnomos la sueltan al
+ * morir) o cuando otro puede pisar los botones o volar la barricada */
+static bool solver_gate_required(const Solver *solver, GameState *game,
+                                 const SolverGate *gate, int cell) {
+    if (gate->closed[cell] != SOLVER_UNREACHABLE)
+        return false;
+    if (gate->trigger < 0) {
+        if (game->player.keys > 0 ||
+            solver_door_count(game) != gate->door_count)
+            return false;
+        int keys = 0;
+        for (int i = 0; i < MAX_ITEMS; i++)
+            keys += game->items[i].kind == ITEM_KEY;
+        int known = 0;
+        for (int l = 0; l < solver->landmark_count; l++) {
+            const SolverLandmark *landmark = &solver->landmarks[l];
+            if (landmark->gate != 0)
+                continue;
+            for (EntityRef ref = entity_index_at(game, landmark->position);
+                 ref; ref = entity_index_next(game, ref)) {
+                if (ENTITY_REF_KIND(ref) == ENTITY_ITEM &&
+                    game->items[ENTITY_REF_INDEX(ref)].kind == ITEM_KEY) {
+                    known++;
+                    break;
+                }
+            }
+        }
+        for (int i = 0; i < MAX_COLAPSORES; i++) {
+            if (!game->colapsores[i].dead &&
+                game->colapsores[i].kind == COLAPSOR_GNOME)
+                return false;
+        }
+        return keys == known;
+    }
+
+    const LevelTrigger *t = &game->triggers[gate->trigger];
+    for (int c = t->cell_start; c < t->cell_start + t->cell_count; c++) {
+        IVector2 pos = game->trigger_cells[c];
+        if (MAP_AT(game->map, pos.x, pos.y) != t->from)
+            return false;
+    }
+    for (int i = 0; i < MAX_COLAPSORES; i++) {
+        if (!game->colapsores[i].dead)
+            return false;
+    }
+    if (t->from == CELL_BARRICADE) {
+        if (game->player.bombs > 0)
+            return false;
+        for (int i = 0; i < MAX_BOMBS; i++) {
+            if (game->bombs[i].countdown > 0)
+                return false;
+        }
+        for (int i = 0; i < MAX_ITEMS; i++) {
+            if (game->items[i].kind == ITEM_BOMB_REFILL)
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Si el jugador tiene que pasar por la marca: una llave que sigue en el
+ * suelo, o un botón que no cubre un eco (los ecos sólo repiten caminos del
+ * jugador, así que los demás los tiene que pisar él) */
+static bool solver_landmark_pending(const Solver *solver, GameState *game,
+                                    const SolverLandmark *landmark) {
+    if (solver->gates[landmark->gate].trigger >= 0)
+        return !solver_button_covered(game, landmark->position);
+    for (EntityRef ref = entity_index_at(game, landmark->position); ref;
+         ref = entity_index_next(game, ref)) {
+        if (ENTITY_REF_KIND(ref) == ENTITY_ITEM &&
+            game->items[ENTITY_REF_INDEX(ref)].kind == ITEM_KEY)
+            return true;
+    }
+    return false;
+}
+
+static int solver_estimate(const Solver *solver, GameState *game) {
+    IVector2 pos = game->player.position;
+    int cols = game->map->cols;
+    int cell = pos.y * cols + pos.x;
+    int estimate = solver->heuristic[cell];
+    if (!solver->gate_count || estimate == SOLVER_UNREACHABLE)
+        return estimate;
+
+    /* Grupos de marcas que hay que visitar antes de la salida: una llave
+     * cualquiera, uno de los botones de un disparador "alguno", cada botón
+     * de un disparador "todos" */
+    int group_of[SOLVER_MAX_LANDMARKS];
+    int groups = 0, marks = 0;
+    int landmarks[SOLVER_MAX_LANDMARKS];
+    for (int g = 0; g < solver->gate_count; g++) {
+        const SolverGate *gate = &solver->gates[g];
+        if (!solver_gate_required(solver, game, gate, cell))
+            continue;
+        bool any = gate->trigger < 0 ||
+                   game->triggers[gate->trigger].condition ==
+                       TRIGGER_ANY_BUTTON;
+        int first = marks;
+        bool satisfied = false;
+        for (int l = 0; l < solver->landmark_count; l++) {
+            const SolverLandmark *landmark = &solver->landmarks[l];
+            if (landmark->gate != g)
+                continue;
+            if (!solver_landmark_pending(solver, game, landmark)) {
+                satisfied |= any && gate->trigger >= 0;
+                continue;
+            }
+            if (!any && groups == SOLVER_MAX_GROUPS)
+                break;
+            landmarks[marks] = l;
+            group_of[marks++] = any ? groups : groups++;
+        }
+        if (any && marks > first) {
+            if (satisfied || groups == SOLVER_MAX_GROUPS)
+                marks = first;
+            else
+                groups++;
+        }
+    }
+    if (!groups)
+        return estimate;
+
+    /* El recorrido más corto que toca un grupo tras otro y acaba en la
+     * salida, por subconjuntos de grupos */
+    uint16_t best[1 << SOLVER_MAX_GROUPS][SOLVER_MAX_LANDMARKS];
+    int full = (1 << groups) - 1;
+    for (int mask = 1; mask <= full; mask++) {
+        for (int m = 0; m < marks; m++)
+            best[mask][m] = SOLVER_UNREACHABLE;
+    }
+    for (int m = 0; m < marks; m++)
+        best[1 << group_of[m]][m] =
+            solver->landmarks[landmarks[m]].distance[cell];
+    int tour = SOLVER_UNREACHABLE;
+    for (int mask = 1; mask <= full; mask++) {
+        for (int m = 0; m < marks; m++) {
+            int cost = best[mask][m];
+            if (cost == SOLVER_UNREACHABLE || !(mask & 1 << group_of[m]))
+                continue;
+            IVector2 at = solver->landmarks[landmarks[m]].position;
+            int from = at.y * cols + at.x;
+            if (mask == full) {
+                int rest = solver->heuristic[from];
+                if (rest != SOLVER_UNREACHABLE && cost + rest < tour)
+                    tour = cost + rest;
+                continue;
+            }
+            for (int n = 0; n < marks; n++) {
+                if (mask & 1 << group_of[n])
+                    continue;
+                int step = solver->landmarks[landmarks[n]].distance[from];
+                int next = mask | 1 << group_of[n];
+                if (step != SOLVER_UNREACHABLE && cost + step < best[next][n])
+                    best[next][n] = (uint16_t)(cost + step);
+            }
+        }
+    }
+    return tour > estimate ? tour : estimate;
+}
+
+/* ----- Imágenes del estado ----- */
+
+static void solver_add_segment(Solver *solver, const void *start,
+                               size_t bytes) {
+    /* Redondeando hacia fuera a palabras: todo lo que se toca está dentro
+     * de la reserva (GameState y los bloques de aligned_malloc están
+     * alineados a más de 8) y los punteros, alineados a 8, no comparten
+     * palabra con nada. Lo que empieza donde acaba el anterior (campos
+     * seguidos del GameState) se le junta */
+    uintptr_t from = (uintptr_t)start & ~(uintptr_t)7;
+    uintptr_t to = ((uintptr_t)start + bytes + 7) & ~(uintptr_t)7;
+    SolverSegment *last = solver->segment_count
+                              ? &solver->segments[solver->segment_count - 1]
+                              : NULL;
+    if (last && from >= (uintptr_t)last->data &&
+        from <= (uintptr_t)last->data + last->words * 8) {
+        uintptr_t end = (uintptr_t)last->data + last->words * 8;
+        if (to > end) {
+            last->words += (to - end) / 8;
+            solver->image_words += (to - end) / 8;
+        }
+        return;
+    }
+    solver->segments[solver->segment_count++] =
+        (SolverSegment){(unsigned char *)from, (to - from) / 8};
+    solver->image_words += (to - from) / 8;
+}
+
+#define SOLVER_FIELD(game, field)                                              \
+    solver_add_segment(solver, &(game)->field, sizeof((game)->field))
+
+/* Qué memoria forma el estado, campo a campo: lo que escribe un turno.
+ * Fuera quedan lo que sólo toca el front-end (diálogos, enciclopedia,
+ * partículas, atmósfera, textos flotantes), los punteros del nivel, que
+ * ningún turno cambia, y el scratch: la cola de BFS, los campos de
+ * distancias con sus generaciones (sólo suben, así que una rejilla de otra
+ * rama nunca vale) y el tablero de huellas. player.qubits[].reg apunta a
+ * player.qreg de esta partida: la imagen sólo vale en su hilo, por eso un
+ * estado robado se vuelve a jugar (solver_replay). Un campo nuevo que
+ * escriban los turnos tiene que entrar aquí */
+static void solver_build_segments(Solver *solver) {
+    GameState *game = &solver->game;
+    solver->segment_count = 0;
+    solver->image_words = 0;
+    SOLVER_FIELD(game, player);
+    SOLVER_FIELD(game, colapsores);
+    SOLVER_FIELD(game, turn_animation);
+    SOLVER_FIELD(game, items);
+    SOLVER_FIELD(game, bombs);
+    SOLVER_FIELD(game, echos);
+    SOLVER_FIELD(game, entangled);
+    SOLVER_FIELD(game, detectors);
+    SOLVER_FIELD(game, tunnels);
+    SOLVER_FIELD(game, tunnel_ticket);
+    SOLVER_FIELD(game, portals);
+    SOLVER_FIELD(game, oracles);
+    SOLVER_FIELD(game, buttons);
+    SOLVER_FIELD(game, buttons_pressed);
+    SOLVER_FIELD(game, triggers);
+    SOLVER_FIELD(game, trigger_count);
+    SOLVER_FIELD(game, trigger_cells);
+    SOLVER_FIELD(game, trigger_cell_count);
+    SOLVER_FIELD(game, trigger_buttons_seen);
+    SOLVER_FIELD(game, glitch_intensity);
+    SOLVER_FIELD(game, game_over);
+    SOLVER_FIELD(game, turn_count);
+    SOLVER_FIELD(game, state_kind);
+    SOLVER_FIELD(game, current_level);
+    SOLVER_FIELD(game, highest_level_unlocked);
+    SOLVER_FIELD(game, exit_position);
+    SOLVER_FIELD(game, checkpoint_pos);
+    SOLVER_FIELD(game, has_checkpoint);
+    SOLVER_FIELD(game, has_teleport_device);
+    SOLVER_FIELD(game, current_length);
+    SOLVER_FIELD(game, alpha_real);
+    SOLVER_FIELD(game, alpha_imag);
+    SOLVER_FIELD(game, beta_real);
+    SOLVER_FIELD(game, beta_imag);
+    SOLVER_FIELD(game, screen_shake);
+    SOLVER_FIELD(game, flash_intensity);
+    SOLVER_FIELD(game, pending_next_level);
+    SOLVER_FIELD(game, beam_generation);
+    SOLVER_FIELD(game, beam_coverage_generation);
+    SOLVER_FIELD(game, explosion_count);
+    SOLVER_FIELD(game, explosion_overflow);
+    SOLVER_FIELD(game, cell_hash);
+    SOLVER_FIELD(game, cell_hash_valid);
+    SOLVER_FIELD(game, item_hash);
+
+    /* Arrays del nivel, por su tamaño */
+    const Map *map = game->map;
+    size_t cells = (size_t)map->rows * map->cols;
+    size_t board = (size_t)map->rows * game->passability.words *
+                   sizeof(uint64_t);
+    solver_add_segment(solver, map->block,
+                       (size_t)map->stride * (map->rows + 2 * MAP_BORDER));
+    solver_add_segment(solver, game->occupancy, cells);
+    solver_add_segment(solver, game->entity_heads, cells * sizeof(EntityRef));
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        solver_add_segment(solver, game->passability.passable[phase], board);
+    solver_add_segment(solver, game->passability.passable_superposed, board);
+    solver_add_segment(solver, game->passability.walkable, board);
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        solver_add_segment(solver, game->beam_coverage[phase], board);
+    solver_add_segment(solver, game->explosion_cells,
+                       (size_t)game->explosion_capacity * sizeof(IVector2));
+}
+
+/* Trocea los segmentos en bloques (el último de cada segmento puede ser
+ * más corto) */
+static bool solver_build_blocks(Solver *solver) {
+    size_t count = 0;
+    for (int s = 0; s < solver->segment_count; s++)
+        count += (solver->segments[s].words + SOLVER_BLOCK_WORDS - 1) /
+                 SOLVER_BLOCK_WORDS;
+    if (!solver_grow(solver, (void **)&solver->blocks, 0,
+                     count * sizeof(SolverBlock)) ||
+        !solver_grow(solver, (void **)&solver->dirty, 0,
+                     count * sizeof(uint32_t)) ||
+        !solver_grow(solver, (void **)&solver->parent_blocks, 0,
+                     count * sizeof(uint32_t)) ||
+        !solver_grow(solver, (void **)&solver->word_block, 0,
+                     solver->image_words * sizeof(uint32_t)))
+        return false;
+
+    size_t b = 0, start = 0;
+    for (int s = 0; s < solver->segment_count; s++) {
+        uint64_t *live = (uint64_t *)solver->segments[s].data;
+        size_t words = solver->segments[s].words;
+        for (size_t w = 0; w < words; w += SOLVER_BLOCK_WORDS, b++) {
+            size_t n = words - w < SOLVER_BLOCK_WORDS ? words - w
+                                                      : SOLVER_BLOCK_WORDS;
+            solver->blocks[b] =
+                (SolverBlock){live + w, (uint32_t)start, (uint32_t)n};
+            for (size_t i = 0; i < n; i++)
+                solver->word_block[start + i] = (uint32_t)b;
+            start += n;
+        }
+    }
+    solver->block_count = count;
+    solver->parent_block_count = 0;
+    solver->dirty_count = 0;
+    return true;
+}
+
+static void solver_image_read(Solver *solver, uint64_t *image) {
+    for (int s = 0; s < solver->segment_count; s++) {
+        memcpy(image, solver->segments[s].data,
+               solver->segments[s].words * sizeof(uint64_t));
+        image += solver->segments[s].words;
+    }
+}
+
+/* Sin llamar a memcmp el compilador vectoriza la comparación y recorrer
+ * toda la imagen sale barato */
+static bool solver_block_same(const SolverBlock *block,
+                              const uint64_t *image) {
+    const uint64_t *live = block->live;
+    image += block->start;
+    uint64_t diff = 0;
+    if (block->words == SOLVER_BLOCK_WORDS) {
+        for (int i = 0; i < SOLVER_BLOCK_WORDS; i++)
+            diff |= live[i] ^ image[i];
+    } else {
+        for (uint32_t i = 0; i < block->words; i++)
+            diff |= live[i] ^ image[i];
+    }
+    return diff == 0;
+}
+
+static void solver_block_copy(const SolverBlock *block,
+                              const uint64_t *image) {
+    memcpy(block->live, image + block->start,
+           block->words * sizeof(uint64_t));
+}
+
+/* Devuelve la partida a `image` copiando sólo los bloques que cambiaron */
+static void solver_image_restore(Solver *solver, const uint64_t *image) {
+    for (size_t b = 0; b < solver->block_count; b++) {
+        if (!solver_block_same(&solver->blocks[b], image))
+            solver_block_copy(&solver->blocks[b], image);
+    }
+}
+
+/* Qué bloques tocó el turno que se acaba de jugar desde el padre: con eso
+ * sale el delta del hijo y se vuelve al padre sin recorrer otra vez la
+ * imagen */
+static void solver_find_dirty(Solver *solver) {
+    size_t count = 0;
+    for (size_t b = 0; b < solver->block_count; b++) {
+        if (!solver_block_same(&solver->blocks[b], solver->parent))
+            solver->dirty[count++] = (uint32_t)b;
+    }
+    solver->dirty_count = count;
+}
+
+static void solver_restore_dirty(Solver *solver) {
+    for (size_t i = 0; i < solver->dirty_count; i++)
+        solver_block_copy(&solver->blocks[solver->dirty[i]], solver->parent);
+}
+
+static void solver_apply_delta(uint64_t *image, const uint64_t *delta) {
+    for (;;) {
+        uint64_t start = delta[0] >> 32, count = delta[0] & 0xFFFFFFFFu;
+        delta++;
+        if (!count)
+            return;
+        memcpy(image + start, delta, count * sizeof(uint64_t));
+        delta += count;
+    }
+}
+
+static bool solver_bucket_reserve(Solver *solver, SolverBucket *bucket,
+                                  size_t words) {
+    if (bucket->used + words <= bucket->capacity)
+        return true;
+    size_t capacity = bucket->capacity ? bucket->capacity : 1 << 12;
+    while (capacity < bucket->used + words)
+        capacity *= 2;
+    size_t old_bytes = bucket->capacity * sizeof(uint64_t);
+    size_t new_bytes = capacity * sizeof(uint64_t);
+    if (!solver_grow(solver, (void **)&bucket->words, old_bytes, new_bytes))
+        return false;
+    bucket->capacity = capacity;
+    return true;
+}
+
+/* Cierra el tramo que empieza en words[header] y acaba antes de `end` */
+static void solver_close_run(SolverBucket *bucket, size_t header,
+                             size_t end) {
+    bucket->words[header] |= end - (bucket->words[header] >> 32);
+}
+
+/* Hueco para un estado más en el cubo: su delta empieza en bucket->used */
+static bool solver_bucket_slot(Solver *solver, SolverBucket *bucket,
+                               uint32_t id) {
+    if (bucket->count == bucket->slots) {
+        size_t slots = bucket->slots ? bucket->slots * 2 : 256;
+        size_t old_bytes = bucket->slots * sizeof(size_t);
+        size_t new_bytes = slots * sizeof(size_t);
+        if (!solver_grow(solver, (void **)&bucket->offsets, old_bytes,
+                         new_bytes) ||
+            !solver_grow(solver, (void **)&bucket->ids,
+                         bucket->slots * sizeof(uint32_t),
+                         slots * sizeof(uint32_t)))
+            return false;
+        bucket->slots = slots;
+    }
+    bucket->offsets[bucket->count] = bucket->used;
+    bucket->ids[bucket->count] = id;
+    return true;
+}
+
+/* Apila el estado de la partida como delta contra la raíz. Sólo puede
+ * diferir de ella en los bloques en que ya difería el padre y en los que
+ * tocó el turno */
+static bool solver_bucket_push(Solver *solver, SolverBucket *bucket,
+                               uint32_t id) {
+    if (!solver_bucket_slot(solver, bucket, id))
+        return false;
+
+    const uint64_t *root = solver->root;
+    const uint32_t *parent = solver->parent_blocks, *dirty = solver->dirty;
+    size_t p = 0, d = 0;
+    size_t parent_count = solver->parent_block_count;
+    size_t dirty_count = solver->dirty_count;
+    bool open = false; // Hay un tramo empezado
+    size_t header = 0, run_end = 0;
+    while (p < parent_count || d < dirty_count) {
+        uint32_t b;
+        if (d == dirty_count || (p < parent_count && parent[p] < dirty[d])) {
+            b = parent[p++];
+        } else {
+            b = dirty[d++];
+            if (p < parent_count && parent[p] == b)
+                p++;
+        }
+
+        const SolverBlock *block = &solver->blocks[b];
+        if (!solver_bucket_reserve(solver, bucket, block->words + 1))
+            return false;
+        for (uint32_t w = 0; w < block->words; w++) {
+            size_t at = block->start + w;
+            if (block->live[w] == root[at])
+                continue;
+            if (!open || at != run_end) {
+                if (open)
+                    solver_close_run(bucket, header, run_end);
+                header = bucket->used++;
+                bucket->words[header] = (uint64_t)at << 32;
+                open = true;
+            }
+            bucket->words[bucket->used++] = block->live[w];
+            run_end = at + 1;
+        }
+    }
+    if (open)
+        solver_close_run(bucket, header, run_end);
+    if (!solver_bucket_reserve(solver, bucket, 1))
+        return false;
+    bucket->words[bucket->used++] = 0;
+    bucket->count++;
+    return true;
+}
+
+/* Apila un delta ya hecho (el de un candidato del modo determinista) */
+static bool solver_bucket_push_delta(Solver *solver, SolverBucket *bucket,
+                                     uint32_t id, const uint64_t *delta) {
+    size_t words = 0;
+    while (delta[words] & 0xFFFFFFFFu)
+        words += 1 + (delta[words] & 0xFFFFFFFFu);
+    words++;
+    if (!solver_bucket_slot(solver, bucket, id) ||
+        !solver_bucket_reserve(solver, bucket, words))
+        return false;
+    memcpy(bucket->words + bucket->used, delta, words * sizeof(uint64_t));
+    bucket->used += words;
+    bucket->count++;
+    return true;
+}
+
+/* Rehace sobre solver->parent el estado de `delta`, apuntando en qué
+ * bloques difiere de la raíz */
+static void solver_load_delta(Solver *solver, const uint64_t *delta) {
+    memcpy(solver->parent, solver->root,
+           solver->image_words * sizeof(uint64_t));
+    solver_apply_delta(solver->parent, delta);
+
+    size_t count = 0;
+    for (;;) {
+        uint64_t start = delta[0] >> 32, words = delta[0] & 0xFFFFFFFFu;
+        if (!words)
+            break;
+        uint32_t first = solver->word_block[start];
+        uint32_t last = solver->word_block[start + words - 1];
+        if (count && solver->parent_blocks[count - 1] >= first)
+            first = solver->parent_blocks[count - 1] + 1;
+        for (uint32_t b = first; b <= last; b++)
+            solver->parent_blocks[count++] = b;
+        delta += 1 + words;
+    }
+    solver->parent_block_count = count;
+}
+
+/* El estado `n` del cubo del hilo. Su delta y los de encima quedan libres */
+static void solver_bucket_load(Solver *solver, SolverBucket *bucket,
+                               size_t n) {
+    solver_load_delta(solver, bucket->words + bucket->offsets[n]);
+    bucket->used = bucket->offsets[n];
+}
+
+static SolverBucket *solver_bucket(Solver *solver, int f) {
+    if (f >= SOLVER_MAX_BUCKETS)
+        return NULL;
+    if (f >= solver->bucket_count) {
+        int count = solver->bucket_count ? solver->bucket_count : 64;
+        while (count <= f)
+            count *= 2;
+        if (!solver_grow(solver, (void **)&solver->buckets,
+                         solver->bucket_count * sizeof(SolverBucket),
+                         count * sizeof(SolverBucket)))
+            return NULL;
+        memset(solver->buckets + solver->bucket_count, 0,
+               (count - solver->bucket_count) * sizeof(SolverBucket));
+        solver->bucket_count = count;
+    }
+    return &solver->buckets[f];
+}
+
+/* ----- Tabla de transposición ----- */
+
+static SolverShard *solver_shard(SolverShared *shared, uint64_t key) {
+    return &shared->shards[key >> (64 - SOLVER_SHARD_BITS)];
+}
+
+static size_t solver_shard_slot(const SolverShard *shard, uint64_t key) {
+    return (size_t)(key ^ (key >> 29)) & shard->mask;
+}
+
+/* Entrada de `key`, o SOLVER_ENTRY_NONE si no está */
+static uint64_t solver_table_get(SolverShared *shared, uint64_t key) {
+    SolverShard *shard = solver_shard(shared, key);
+    for (size_t slot = solver_shard_slot(shard, key);;
+         slot = (slot + 1) & shard->mask) {
+        uint64_t found = __atomic_load_n(&shard->keys[slot], __ATOMIC_ACQUIRE);
+        if (found == key)
+            return __atomic_load_n(&shard->entries[slot], __ATOMIC_ACQUIRE);
+        if (!found)
+            return SOLVER_ENTRY_NONE;
+    }
+}
+
+/* Entrada de `key`, reservando el hueco si no estaba; NULL si el fragmento
+ * está lleno */
+static uint64_t *solver_table_claim(SolverShared *shared, uint64_t key) {
+    SolverShard *shard = solver_shard(shared, key);
+    for (size_t slot = solver_shard_slot(shard, key);;
+         slot = (slot + 1) & shard->mask) {
+        uint64_t found = __atomic_load_n(&shard->keys[slot], __ATOMIC_ACQUIRE);
+        if (!found) {
+            if (__atomic_load_n(&shard->used, __ATOMIC_RELAXED) >=
+                shard->limit)
+                return NULL;
+            if (__atomic_compare_exchange_n(&shard->keys[slot], &found, key,
+                                            false, __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE)) {
+                __atomic_add_fetch(&shard->used, 1, __ATOMIC_RELAXED);
+                return &shard->entries[slot];
+            }
+        }
+        if (found == key)
+            return &shard->entries[slot];
+    }
+}
+
+/* La entrada gana a (depth, coherence) si llegó con no más turnos y no
+ * menos coherencia */
+static bool solver_entry_dominates(uint64_t entry, int depth, int coherence) {
+    return SOLVER_ENTRY_DEPTH(entry) <= depth &&
+           SOLVER_ENTRY_COHERENCE(entry) >= coherence;
+}
+
+/* 1 si el estado es nuevo o no lo gana lo que ya había, 0 si no, -1 si la
+ * tabla está llena */
+static int solver_table_visit(SolverShared *shared, uint64_t key, int depth,
+                              int coherence) {
+    uint64_t *slot = solver_table_claim(shared, key);
+    if (!slot)
+        return -1;
+    uint64_t entry = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    do {
+        if (solver_entry_dominates(entry, depth, coherence))
+            return 0;
+    } while (!__atomic_compare_exchange_n(slot, &entry,
+                                          SOLVER_ENTRY(depth, coherence, 0),
+                                          true, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+    return 1;
+}
+
+/* Si desde que se apiló se llegó al estado con menos turnos o más
+ * coherencia, ése ya está en la cola y éste sobra */
+static bool solver_table_superseded(SolverShared *shared, uint64_t key,
+                                    int depth, int coherence) {
+    uint64_t entry = solver_table_get(shared, key);
+    return solver_entry_dominates(entry, depth, coherence) &&
+           (SOLVER_ENTRY_DEPTH(entry) != depth ||
+            SOLVER_ENTRY_COHERENCE(entry) != coherence);
+}
+
+/* Modo determinista: entre candidatos con los mismos turnos gana el de más
+ * coherencia y, a igual coherencia, el de menor desempate */
+static bool solver_entry_better(uint64_t entry, uint64_t than) {
+    int coherence = SOLVER_ENTRY_COHERENCE(entry);
+    int other = SOLVER_ENTRY_COHERENCE(than);
+    return coherence > other ||
+           (coherence == other &&
+            SOLVER_ENTRY_TIE(entry) < SOLVER_ENTRY_TIE(than));
+}
+
+/* Escribe el candidato si gana a lo que hay. Lo que llegó con otros turnos
+ * ya se miró al expandir (no lo gana), así que sólo se compite con los de
+ * la misma fase; false si la tabla está llena */
+static bool solver_table_offer(SolverShared *shared,
+                               const SolverCandidate *candidate) {
+    uint64_t *slot = solver_table_claim(shared, candidate->key);
+    if (!slot)
+        return false;
+    int depth = SOLVER_ENTRY_DEPTH(candidate->entry);
+    uint64_t entry = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    do {
+        if (SOLVER_ENTRY_DEPTH(entry) == depth &&
+            !solver_entry_better(candidate->entry, entry))
+            return true;
+    } while (!__atomic_compare_exchange_n(slot, &entry, candidate->entry, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    return true;
+}
+
+static bool solver_table_init(SolverShared *shared, int table_bits) {
+    size_t size = (size_t)1 << (table_bits - SOLVER_SHARD_BITS);
+    for (int s = 0; s < SOLVER_SHARD_COUNT; s++) {
+        SolverShard *shard = &shared->shards[s];
+        shard->keys = calloc(size, sizeof(uint64_t));
+        shard->entries = malloc(size * sizeof(uint64_t));
+        if (!shard->keys || !shard->entries)
+            return false;
+        for (size_t i = 0; i < size; i++)
+            shard->entries[i] = SOLVER_ENTRY_NONE;
+        shard->mask = size - 1;
+        shard->limit = (size_t)(size * SOLVER_TABLE_MAX_LOAD);
+        shard->used = 0;
+        shared->memory += 2 * size * sizeof(uint64_t);
+    }
+    return true;
+}
+
+/* ----- Nodos ----- */
+
+static SolverNode *solver_node(const SolverShared *shared, uint32_t id) {
+    return &shared->chunks[id >> SOLVER_NODE_CHUNK_BITS]
+                          [id & (SOLVER_NODE_CHUNK - 1)];
+}
+
+/* Cada hilo llena su propio bloque de nodos: el id dice el bloque y al
+ * crecer no se mueve nada que otro hilo pueda estar leyendo */
+static bool solver_add_node(Solver *solver, uint32_t parent, int command,
+                            int depth, uint32_t *id) {
+    SolverShared *shared = solver->shared;
+    if (solver->chunk_used == SOLVER_NODE_CHUNK) {
+        uint32_t index =
+            __atomic_fetch_add(&shared->chunk_count, 1, __ATOMIC_RELAXED);
+        SolverNode *chunk = NULL;
+        if (index >= SOLVER_MAX_NODE_CHUNKS ||
+            !solver_grow(solver, (void **)&chunk, 0,
+                         SOLVER_NODE_CHUNK * sizeof(SolverNode)))
+            return false;
+        shared->chunks[index] = chunk;
+        solver->chunk = chunk;
+        solver->chunk_base = index << SOLVER_NODE_CHUNK_BITS;
+        solver->chunk_used = 0;
+    }
+    *id = solver->chunk_base + solver->chunk_used;
+    solver->chunk[solver->chunk_used++] =
+        (SolverNode){parent, (uint16_t)depth, (unsigned char)command};
+    solver->node_count++;
+    return true;
+}
+
+/* Comandos desde la raíz hasta `id` (sin terminar la cadena) */
+static int solver_path(const SolverShared *shared, uint32_t id, char *out,
+                       int size) {
+    int length = solver_node(shared, id)->depth;
+    if (length > size)
+        return -1;
+    int i = length;
+    for (const SolverNode *n = solver_node(shared, id);
+         n->parent != SOLVER_NO_PARENT; n = solver_node(shared, n->parent))
+        out[--i] = SOLVER_COMMAND_LETTERS[n->command];
+    return length;
+}
+
+/* ----- Colas de trabajo ----- */
+
+static bool solver_deque_push(Solver *solver, uint32_t node) {
+    SolverDeque *deque = &solver->deque;
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    if ((size_t)bottom == deque->capacity) {
+        size_t capacity = deque->capacity ? deque->capacity * 2 : 256;
+        if (!solver_grow_stable(solver, (void **)&deque->items,
+                                deque->capacity * sizeof(uint32_t),
+                                capacity * sizeof(uint32_t)))
+            return false;
+        deque->capacity = capacity;
+    }
+    __atomic_store_n(&deque->items[bottom], node, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Saca el último nodo apilado y devuelve su índice, o -1 si no queda
+ * ninguno (o un ladrón se llevó el último) */
+static int64_t solver_deque_take(SolverDeque *deque, uint32_t *node) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+    if (top > bottom) {
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    *node = __atomic_load_n(&deque->items[bottom], __ATOMIC_RELAXED);
+    if (top == bottom) {
+        bool won = __atomic_compare_exchange_n(&deque->top, &top, top + 1,
+                                               false, __ATOMIC_SEQ_CST,
+                                               __ATOMIC_RELAXED);
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        if (!won)
+            return -1;
+    }
+    return bottom;
+}
+
+/* Se lleva el nodo más antiguo y devuelve su índice, o -1 si no hay o
+ * otro ladrón (o el dueño) llegó antes */
+static int64_t solver_deque_steal(SolverDeque *deque, uint32_t *node) {
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom)
+        return -1;
+    uint32_t *items = __atomic_load_n(&deque->items, __ATOMIC_ACQUIRE);
+    *node = __atomic_load_n(&items[top], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return -1;
+    return top;
+}
+
+/* Prueba a robar un nodo de los demás hilos empezando por uno al azar */
+static bool solver_steal(Solver *solver, uint32_t *node) {
+    SolverShared *shared = solver->shared;
+    int count = shared->thread_count;
+    if (count == 1)
+        return false;
+    solver->random = solver->random * 6364136223846793005ULL +
+                     1442695040888963407ULL;
+    int first = (int)((solver->random >> 33) % (uint64_t)count);
+    for (int i = 0; i < count; i++) {
+        Solver *victim = &shared->workers[(first + i) % count];
+        if (victim == solver)
+            continue;
+        if (solver_deque_steal(&victim->deque, node) >= 0) {
+            solver->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Pasa a la cola los nodos del cubo `priority`. Va entre barreras: nadie
+ * está robando, así que los índices vuelven a empezar y lo que creció en el
+ * cubo anterior ya se puede soltar */
+static bool solver_deque_load(Solver *solver, int priority, long *loaded) {
+    SolverDeque *deque = &solver->deque;
+    deque->top = 0;
+    deque->bottom = 0;
+    solver_release_retired(solver);
+    SolverBucket *bucket = solver_bucket(solver, priority);
+    if (!bucket)
+        return false;
+    for (size_t i = 0; i < bucket->count; i++) {
+        if (!solver_deque_push(solver, bucket->ids[i]))
+            return false;
+    }
+    *loaded = (long)bucket->count;
+    return true;
+}
+
+/* ----- Hilos ----- */
+
+static int solver_core_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static void solver_yield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static void solver_barrier_init(SolverBarrier *barrier, int count,
+                                const int *watch) {
+    barrier->count = count;
+    barrier->watch = watch;
+    barrier->waiting = 0;
+    barrier->generation = 0;
+#ifdef _WIN32
+    InitializeCriticalSection(&barrier->lock);
+    InitializeConditionVariable(&barrier->wake);
+#else
+    pthread_mutex_init(&barrier->lock, NULL);
+    pthread_cond_init(&barrier->wake, NULL);
+#endif
+}
+
+static void solver_barrier_destroy(SolverBarrier *barrier) {
+#ifdef _WIN32
+    DeleteCriticalSection(&barrier->lock);
+#else
+    pthread_mutex_destroy(&barrier->lock);
+    pthread_cond_destroy(&barrier->wake);
+#endif
+}
+
+/* Con `count` ya esperando suelta a todos */
+static void solver_barrier_release(SolverBarrier *barrier) {
+    if (barrier->waiting < barrier->count)
+        return;
+    barrier->seen = __atomic_load_n(barrier->watch, __ATOMIC_ACQUIRE);
+    barrier->waiting = 0;
+    barrier->generation++;
+#ifdef _WIN32
+    WakeAllConditionVariable(&barrier->wake);
+#else
+    pthread_cond_broadcast(&barrier->wake);
+#endif
+}
+
+/* Espera a que lleguen todos. Lo que cualquiera escribió antes se ve
+ * después en todos los hilos, y todos devuelven el valor de `watch` de
+ * cuando no escribía nadie aunque otro hilo lo cambie justo después */
+static int solver_barrier_wait(SolverBarrier *barrier) {
+#ifdef _WIN32
+    EnterCriticalSection(&barrier->lock);
+#else
+    pthread_mutex_lock(&barrier->lock);
+#endif
+    unsigned generation = barrier->generation;
+    barrier->waiting++;
+    solver_barrier_release(barrier);
+    while (generation == barrier->generation) {
+#ifdef _WIN32
+        SleepConditionVariableCS(&barrier->wake, &barrier->lock, INFINITE);
+#else
+        pthread_cond_wait(&barrier->wake, &barrier->lock);
+#endif
+    }
+    int seen = barrier->seen;
+#ifdef _WIN32
+    LeaveCriticalSection(&barrier->lock);
+#else
+    pthread_mutex_unlock(&barrier->lock);
+#endif
+    return seen;
+}
+
+/* Si no se pudo crear algún hilo se sigue con los que hay */
+static void solver_barrier_resize(SolverBarrier *barrier, int count) {
+#ifdef _WIN32
+    EnterCriticalSection(&barrier->lock);
+    barrier->count = count;
+    solver_barrier_release(barrier);
+    LeaveCriticalSection(&barrier->lock);
+#else
+    pthread_mutex_lock(&barrier->lock);
+    barrier->count = count;
+    solver_barrier_release(barrier);
+    pthread_mutex_unlock(&barrier->lock);
+#endif
+}
+
+/* ----- Búsqueda ----- */
+
+/* Orden de los cubos: f y, en modo determinista, los turnos dentro de cada
+ * f (no pasan de f: índice triangular) */
+static int solver_priority(const SolverShared *shared, int f, int depth) {
+    if (!shared->deterministic)
+        return f;
+    long triangle = (long)f * (f + 1) / 2 + depth;
+    return triangle < SOLVER_MAX_BUCKETS ? (int)triangle : SOLVER_MAX_BUCKETS;
+}
+
+/* El primero que para la búsqueda pone el resultado */
+static void solver_stop(SolverShared *shared, SolverResult result,
+                        uint32_t goal) {
+    int running = 0;
+    if (__atomic_compare_exchange_n(&shared->stop, &running, 1, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        shared->result = result;
+        shared->goal = goal;
+    }
+}
+
+static bool solver_stopped(SolverShared *shared) {
+    return __atomic_load_n(&shared->stop, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* Un nodo robado: su delta es de la partida de otro hilo, así que se
+ * vuelve a jugar su camino desde la imagen inicial de este */
+static void solver_replay(Solver *solver, uint32_t node) {
+    SolverShared *shared = solver->shared;
+    GameState *game = &solver->game;
+    int length = solver_node(shared, node)->depth;
+    int i = length;
+    for (const SolverNode *n = solver_node(shared, node);
+         n->parent != SOLVER_NO_PARENT; n = solver_node(shared, n->parent))
+        solver->replay[--i] = n->command;
+
+    solver_image_restore(solver, solver->root);
+    for (i = 0; i < length; i++)
+        solver_play(game, solver_state_key(game), solver->replay[i], 0);
+    solver->replayed += length;
+
+    solver_image_read(solver, solver->parent);
+    size_t count = 0;
+    for (size_t b = 0; b < solver->block_count; b++) {
+        if (!solver_block_same(&solver->blocks[b], solver->root))
+            solver->parent_blocks[count++] = (uint32_t)b;
+    }
+    solver->parent_block_count = count;
+}
+
+/* Hijo recién jugado: a la tabla y a su cubo, o a la cola si sigue en el
+ * actual. false si hay que dejar de expandir */
+static bool solver_push_child(Solver *solver, uint32_t node, int command,
+                              int depth, int priority, int child) {
+    SolverShared *shared = solver->shared;
+    GameState *game = &solver->game;
+    int visit = solver_table_visit(shared, solver_state_key(game), depth,
+                                   solver_coherence(game));
+    if (visit < 0) {
+        solver_stop(shared, SOLVER_TABLE_FULL, 0);
+        return false;
+    }
+    if (!visit)
+        return true;
+    uint32_t id;
+    if (!solver_add_node(solver, node, command, depth, &id)) {
+        solver_stop(shared, SOLVER_NO_MEMORY, 0);
+        return false;
+    }
+    /* En el cubo actual no queda nada más barato */
+    if (depth == priority && solver_is_goal(game)) {
+        solver_stop(shared, SOLVER_SOLVED, id);
+        return false;
+    }
+    SolverBucket *bucket = solver_bucket(solver, child);
+    if (!bucket || !solver_bucket_push(solver, bucket, id)) {
+        solver_stop(shared, SOLVER_NO_MEMORY, 0);
+        return false;
+    }
+    if (child == priority) {
+        /* Antes de publicarlo: si no, otro hilo podría terminarlo y ver
+         * la cuenta a 0 con trabajo pendiente */
+        __atomic_add_fetch(&shared->pending, 1, __ATOMIC_ACQ_REL);
+        if (!solver_deque_push(solver, id)) {
+            solver_stop(shared, SOLVER_NO_MEMORY, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Modo determinista: el hijo se guarda como candidato sin tocar la tabla,
+ * que en esta fase sólo se lee */
+static bool solver_propose_child(Solver *solver, uint32_t node, int command,
+                                 int depth, uint64_t parent_key, int child) {
+    SolverShared *shared = solver->shared;
+    GameState *game = &solver->game;
+    uint64_t key = solver_state_key(game);
+    int coherence = solver_coherence(game);
+    if (solver_entry_dominates(solver_table_get(shared, key), depth,
+                               coherence))
+        return true;
+
+    if (solver->candidate_count == solver->candidate_slots) {
+        size_t slots = solver->candidate_slots ? solver->candidate_slots * 2
+                                               : 256;
+        if (!solver_grow(solver, (void **)&solver->candidates,
+                         solver->candidate_slots * sizeof(SolverCandidate),
+                         slots * sizeof(SolverCandidate))) {
+            solver_stop(shared, SOLVER_NO_MEMORY, 0);
+            return false;
+        }
+        solver->candidate_slots = slots;
+    }
+    if (!solver_bucket_push(solver, &solver->pending,
+                            (uint32_t)solver->candidate_count)) {
+        solver_stop(shared, SOLVER_NO_MEMORY, 0);
+        return false;
+    }
+    uint32_t tie = (uint32_t)solver_turn_seed(parent_key, command);
+    solver->candidates[solver->candidate_count++] = (SolverCandidate){
+        key, SOLVER_ENTRY(depth, coherence, tie), node,
+        (unsigned char)command, child};
+    return true;
+}
+
+/* Expande el estado de la partida, que es el del nodo `node` y está también
+ * en solver->parent */
+static void solver_expand(Solver *solver, uint32_t node, int priority) {
+    SolverShared *shared = solver->shared;
+    GameState *game = &solver->game;
+    uint64_t parent_key = solver_state_key(game);
+    int depth = solver_node(shared, node)->depth;
+    if (solver_table_superseded(shared, parent_key, depth,
+                                solver_coherence(game)))
+        return;
+    if (solver_is_goal(game)) {
+        if (!shared->deterministic) {
+            solver_stop(shared, SOLVER_SOLVED, node);
+        } else if (!solver->has_goal || parent_key < solver->goal_key) {
+            solver->has_goal = true;
+            solver->goal_key = parent_key;
+            solver->goal = node;
+        }
+        return;
+    }
+    if (!shared->deterministic &&
+        __atomic_load_n(&shared->expanded, __ATOMIC_RELAXED) >=
+            shared->max_nodes * shared->thread_count) {
+        solver_stop(shared, SOLVER_NODE_LIMIT, 0);
+        return;
+    }
+    if (depth >= SOLVER_MAX_DEPTH)
+        return;
+    __atomic_add_fetch(&shared->expanded, 1, __ATOMIC_RELAXED);
+    solver->expanded++;
+
+    /* Con una heurística consistente los hijos no bajan de cubo; si alguno
+     * lo hiciera se queda en el siguiente que queda por recorrer */
+    int lowest = shared->deterministic ? priority + 1 : priority;
+    int count = solver_command_count(game);
+    for (int c = 0; c < count; c++) {
+        int command = solver_command(game, c);
+        if (c > 0)
+            solver_restore_dirty(solver);
+        solver_play(game, parent_key, command, 0);
+        solver_find_dirty(solver);
+        if (game->player.dead)
+            continue;
+        int estimate = solver_estimate(solver, game);
+        if (estimate == SOLVER_UNREACHABLE)
+            continue;
+
+        int child = solver_priority(shared, depth + 1 + estimate, depth + 1);
+        if (child < lowest)
+            child = lowest;
+        bool more = shared->deterministic
+                        ? solver_propose_child(solver, node, command,
+                                               depth + 1, parent_key, child)
+                        : solver_push_child(solver, node, command, depth + 1,
+                                            priority, child);
+        if (!more)
+            return;
+    }
+}
+
+/* Expande los estados del cubo actual hasta que no quede ninguno en
+ * ninguna cola (shared->pending a 0) o se pare la búsqueda */
+static void solver_drain(Solver *solver, int priority) {
+    SolverShared *shared = solver->shared;
+    double idle_since = 0.0;
+    while (!solver_stopped(shared)) {
+        uint32_t node;
+        int64_t index = solver_deque_take(&solver->deque, &node);
+        SolverBucket *bucket = &solver->buckets[priority];
+        bucket->count =
+            (size_t)__atomic_load_n(&solver->deque.bottom, __ATOMIC_RELAXED);
+        if (index >= 0) {
+            solver_bucket_load(solver, bucket, (size_t)index);
+            solver_image_restore(solver, solver->parent);
+        } else {
+            /* Lo que queda debajo se lo llevaron otros hilos */
+            if (solver_steal(solver, &node)) {
+                solver_replay(solver, node);
+            } else {
+                if (!__atomic_load_n(&shared->pending, __ATOMIC_ACQUIRE))
+                    break;
+                if (idle_since == 0.0)
+                    idle_since = solver_now();
+                solver_yield();
+                continue;
+            }
+        }
+        if (idle_since != 0.0) {
+            solver->idle += solver_now() - idle_since;
+            idle_since = 0.0;
+        }
+        solver_expand(solver, node, priority);
+        __atomic_sub_fetch(&shared->pending, 1, __ATOMIC_ACQ_REL);
+    }
+    if (idle_since != 0.0)
+        solver->idle += solver_now() - idle_since;
+}
+
+/* Modo determinista: de las salidas vistas en la fase, la de menor clave */
+static bool solver_pick_goal(SolverShared *shared) {
+    const Solver *best = NULL;
+    for (int t = 0; t < shared->thread_count; t++) {
+        const Solver *worker = &shared->workers[t];
+        if (worker->has_goal && (!best || worker->goal_key < best->goal_key))
+            best = worker;
+    }
+    if (best)
+        solver_stop(shared, SOLVER_SOLVED, best->goal);
+    return best != NULL;
+}
+
+/* Modo determinista, tras escribir todos los candidatos: los que siguen en
+ * la tabla son los ganadores y pasan a su cubo */
+static void solver_push_winners(Solver *solver) {
+    SolverShared *shared = solver->shared;
+    for (size_t i = 0; i < solver->candidate_count; i++) {
+        const SolverCandidate *candidate = &solver->candidates[i];
+        if (solver_table_get(shared, candidate->key) != candidate->entry)
+            continue;
+        uint32_t id;
+        SolverBucket *bucket = solver_bucket(solver, candidate->priority);
+        if (!bucket ||
+            !solver_add_node(solver, candidate->parent, candidate->command,
+                             SOLVER_ENTRY_DEPTH(candidate->entry), &id) ||
+            !solver_bucket_push_delta(
+                solver, bucket, id,
+                solver->pending.words + solver->pending.offsets[i])) {
+            solver_stop(shared, SOLVER_NO_MEMORY, 0);
+            break;
+        }
+    }
+    solver->candidate_count = 0;
+    solver->pending.count = 0;
+    solver->pending.used = 0;
+}
+
+static int solver_next_priority(const Solver *solver, int priority) {
+    for (int p = priority + 1; p < solver->bucket_count; p++) {
+        if (solver->buckets[p].count)
+            return p;
+    }
+    return INT_MAX;
+}
+
+/* Cuerpo de cada hilo. Todos recorren los cubos a la vez, separados por
+ * barreras, y tras cada una deciden lo mismo: si parar lo dice la barrera
+ * y lo demás no cambia hasta la siguiente.
+ *
+ * El límite de nodos se mira al empezar cada cubo. Dentro del cubo en que
+ * está la salida, varios hilos lo recorren en otro orden que uno solo y
+ * pueden expandir más antes de dar con ella: en modo rápido el cubo sólo
+ * se corta al pasar del límite por el número de hilos, así que con más
+ * hilos no se resuelve menos que con uno */
+static void solver_run(Solver *solver) {
+    SolverShared *shared = solver->shared;
+    SolverBarrier *barrier = &shared->barrier;
+    int priority = shared->start_priority;
+    solver_barrier_wait(barrier);
+    for (;;) {
+        if (__atomic_load_n(&shared->expanded, __ATOMIC_RELAXED) >=
+            shared->max_nodes) {
+            solver_stop(shared, SOLVER_NODE_LIMIT, 0);
+            break;
+        }
+        long loaded = 0;
+        bool ok = solver_deque_load(solver, priority, &loaded);
+        __atomic_add_fetch(&shared->pending, loaded, __ATOMIC_ACQ_REL);
+        solver_barrier_wait(barrier);
+        if (!ok)
+            solver_stop(shared, SOLVER_NO_MEMORY, 0);
+        solver_drain(solver, priority);
+
+        if (shared->deterministic) {
+            if (solver_barrier_wait(barrier) || solver_pick_goal(shared))
+                break;
+            for (size_t i = 0; i < solver->candidate_count; i++) {
+                if (!solver_table_offer(shared, &solver->candidates[i])) {
+                    solver_stop(shared, SOLVER_TABLE_FULL, 0);
+                    break;
+                }
+            }
+            if (solver_barrier_wait(barrier))
+                break;
+            solver_push_winners(solver);
+        }
+
+        SolverBucket *bucket = &solver->buckets[priority];
+        bucket->count = 0;
+        bucket->used = 0;
+        solver->next_priority = solver_next_priority(solver, priority);
+        if (solver_barrier_wait(barrier))
+            break;
+        priority = INT_MAX;
+        for (int t = 0; t < shared->thread_count; t++) {
+            if (shared->workers[t].next_priority < priority)
+                priority = shared->workers[t].next_priority;
+        }
+        if (priority == INT_MAX) {
+            solver_stop(shared, SOLVER_EXHAUSTED, 0);
+            break;
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI solver_thread(LPVOID arg) {
+    solver_run((Solver *)arg);
+    return 0;
+}
+#else
+static void *solver_thread(void *arg) {
+    solver_run((Solver *)arg);
+    return NULL;
+}
+#endif
+
+static void solver_free(Solver *solver) {
+    free(solver->root);
+    free(solver->parent);
+    free(solver->blocks);
+    free(solver->word_block);
+    free(solver->parent_blocks);
+    free(solver->dirty);
+    free(solver->replay);
+    free(solver->heuristic);
+    for (int g = 0; g < solver->gate_count; g++)
+        free(solver->gates[g].closed);
+    for (int l = 0; l < solver->landmark_count; l++)
+        free(solver->landmarks[l].distance);
+    for (int f = 0; f < solver->bucket_count; f++) {
+        free(solver->buckets[f].words);
+        free(solver->buckets[f].offsets);
+        free(solver->buckets[f].ids);
+    }
+    free(solver->buckets);
+    free(solver->deque.items);
+    solver_release_retired(solver);
+    free(solver->retired);
+    free(solver->pending.words);
+    free(solver->pending.offsets);
+    free(solver->pending.ids);
+    free(solver->candidates);
+    free_level_state(&solver->game);
+
+    SolverShared *shared = solver->shared;
+    int index = solver->index;
+    memset(solver, 0, sizeof(*solver));
+    solver->shared = shared;
+    solver->index = index;
+}
+
+/* Libera lo del nivel: la tabla, los nodos y lo de cada hilo */
+static void solver_shared_free(SolverShared *shared) {
+    for (int s = 0; s < SOLVER_SHARD_COUNT; s++) {
+        free(shared->shards[s].keys);
+        free(shared->shards[s].entries);
+        shared->shards[s].keys = NULL;
+        shared->shards[s].entries = NULL;
+    }
+    uint32_t chunks = shared->chunk_count < SOLVER_MAX_NODE_CHUNKS
+                          ? shared->chunk_count
+                          : SOLVER_MAX_NODE_CHUNKS;
+    for (uint32_t c = 0; c < chunks; c++) {
+        free(shared->chunks[c]);
+        shared->chunks[c] = NULL;
+    }
+    shared->chunk_count = 0;
+    for (int t = 0; t < shared->thread_count; t++)
+        solver_free(&shared->workers[t]);
+    shared->memory = 0;
+    shared->memory_used = 0;
+}
+
+static void solver_start_level(GameState *game, int level) {
+    game->pending_next_level = -1;
+    game->state_kind = GAME_STATE_PLAYING;
+    game->current_level = level;
+    load_level(game, level);
+}
+
+/* Carga el nivel en la partida del hilo y prepara sus imágenes y su
+ * heurística */
+static bool solver_start_worker(Solver *solver, int level) {
+    GameState *game = &solver->game;
+    solver_start_level(game, level);
+    solver_build_segments(solver);
+
+    size_t image_bytes = solver->image_words * sizeof(uint64_t);
+    if (!solver_grow(solver, (void **)&solver->root, 0, image_bytes) ||
+        !solver_grow(solver, (void **)&solver->parent, 0, image_bytes) ||
+        !solver_grow(solver, (void **)&solver->replay, 0, SOLVER_MAX_DEPTH) ||
+        !solver_build_blocks(solver) || !solver_build_heuristic(solver))
+        return false;
+    /* Con el hash de las casillas ya calculado: si no, todos los deltas
+     * llevan las palabras del hash que calcula el primer turno */
+    solver_state_key(game);
+    solver_image_read(solver, solver->root);
+    solver->chunk_used = SOLVER_NODE_CHUNK;
+    solver->random = zobrist_key((uint64_t)solver->index, 1);
+    return true;
+}
+
+static SolverResult solver_search(SolverShared *shared, int level,
+                                  int table_bits, uint32_t *goal) {
+    shared->expanded = 0;
+    shared->pending = 0;
+    shared->stop = 0;
+    shared->result = SOLVER_EXHAUSTED;
+    /* load_level no es reentrante: los niveles se cargan aquí, en orden */
+    for (int t = 0; t < shared->thread_count; t++) {
+        if (!solver_start_worker(&shared->workers[t], level))
+            return SOLVER_NO_MEMORY;
+    }
+    if (!solver_table_init(shared, table_bits))
+        return SOLVER_NO_MEMORY;
+
+    Solver *first = &shared->workers[0];
+    GameState *game = &first->game;
+    uint32_t id;
+    int estimate = solver_estimate(first, game);
+    if (estimate == SOLVER_UNREACHABLE)
+        return SOLVER_EXHAUSTED;
+    solver_table_visit(shared, solver_state_key(game), 0,
+                       solver_coherence(game));
+    shared->start_priority = solver_priority(shared, estimate, 0);
+    SolverBucket *bucket = solver_bucket(first, shared->start_priority);
+    if (!bucket || !solver_add_node(first, SOLVER_NO_PARENT, 0, 0, &id) ||
+        !solver_bucket_push(first, bucket, id))
+        return SOLVER_NO_MEMORY;
+
+    int requested = shared->thread_count;
+    solver_barrier_init(&shared->barrier, requested, &shared->stop);
+#ifdef _WIN32
+    HANDLE threads[SOLVER_MAX_THREADS];
+#else
+    pthread_t threads[SOLVER_MAX_THREADS];
+#endif
+    int started = 1;
+    for (; started < requested; started++) {
+        Solver *worker = &shared->workers[started];
+#ifdef _WIN32
+        threads[started] =
+            CreateThread(NULL, 0, solver_thread, worker, 0, NULL);
+        if (!threads[started])
+            break;
+#else
+        if (pthread_create(&threads[started], NULL, solver_thread, worker))
+            break;
+#endif
+    }
+    if (started < requested) {
+        shared->thread_count = started;
+        solver_barrier_resize(&shared->barrier, started);
+    }
+    solver_run(first);
+    for (int t = 1; t < started; t++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[t], INFINITE);
+        CloseHandle(threads[t]);
+#else
+        pthread_join(threads[t], NULL);
+#endif
+    }
+    solver_barrier_destroy(&shared->barrier);
+    shared->thread_count = requested;
+    *goal = shared->goal;
+    return shared->result;
+}
+
+/* Vuelve a jugar la solución desde el nivel recién cargado con la
+ * secuencia de azar `stream` */
+static bool solver_verify(int level, const char *path, int length,
+                          unsigned stream) {
+    static GameState game;
+    solver_start_level(&game, level);
+    for (int i = 0; i < length; i++) {
+        int command = (int)(strchr(SOLVER_COMMAND_LETTERS, path[i]) -
+                            SOLVER_COMMAND_LETTERS);
+        solver_play(&game, solver_state_key(&game), command, stream);
+        if (game.player.dead)
+            break;
+    }
+    bool solved = solver_is_goal(&game);
+    free_level_state(&game);
+    return solved;
+}
+
+/* Con cuántas de las otras SOLVER_STREAMS secuencias llega también a la
+ * salida. No es una búsqueda sobre todos los resultados del azar: una
+ * solución que pasa con todas puede fallar con alguna que no se probó */
+static int solver_robust_streams(int level, const char *path, int length) {
+    int reached = 0;
+    for (unsigned stream = 1; stream <= SOLVER_STREAMS; stream++)
+        reached += solver_verify(level, path, length, stream);
+    return reached;
+}
+
+/* Lo que hizo cada hilo: nodos expandidos, robos, turnos que tuvo que
+ * volver a jugar por ellos y tiempo sin trabajo */
+static void solver_print_threads(const SolverShared *shared, double elapsed) {
+    for (int t = 0; t < shared->thread_count; t++) {
+        const Solver *worker = &shared->workers[t];
+        printf("       hilo %-3d %10ld nodos %11.0f nodos/s %8ld robos "
+               "%9ld turnos rejugados %5.1f%% en espera\n",
+               t, worker->expanded,
+               elapsed > 0.0 ? worker->expanded / elapsed : 0.0,
+               worker->steals, worker->replayed,
+               elapsed > 0.0 ? 100.0 * worker->idle / elapsed : 0.0);
+    }
+}
+
+int main(int argc, char **argv) {
+    int only_level = argc > 1 ? atoi(argv[1]) : 0;
+    long max_nodes = argc > 2 ? atol(argv[2]) : 0; // 0: SOLVER_EXPECTED
+    int table_bits = argc > 3 ? atoi(argv[3]) : SOLVER_DEFAULT_TABLE_BITS;
+    int thread_count = argc > 4 ? atoi(argv[4]) : 0;
+    bool deterministic = argc > 5 && atoi(argv[5]) != 0;
+    long memory_mb = argc > 6 ? atol(argv[6]) : SOLVER_DEFAULT_MEMORY_MB;
+    if (only_level < 0 || only_level > MAX_LEVELS)
+        only_level = 0;
+    if (max_nodes < 0)
+        max_nodes = 0;
+    if (table_bits < 10 || table_bits > 30)
+        table_bits = SOLVER_DEFAULT_TABLE_BITS;
+    if (thread_count <= 0)
+        thread_count = solver_core_count();
+    if (thread_count > SOLVER_MAX_THREADS)
+        thread_count = SOLVER_MAX_THREADS;
+    if (memory_mb <= 0)
+        memory_mb = SOLVER_DEFAULT_MEMORY_MB;
+    qiskit_set_local_only(true);
+
+    static SolverShared shared;
+    shared.deterministic = deterministic;
+    shared.thread_count = thread_count;
+    shared.workers = calloc((size_t)thread_count, sizeof(Solver));
+    shared.chunks = calloc(SOLVER_MAX_NODE_CHUNKS, sizeof(SolverNode *));
+    if (!shared.workers || !shared.chunks) {
+        fprintf(stderr, "level_solver: sin memoria\n");
+        return 1;
+    }
+    for (int t = 0; t < thread_count; t++) {
+        shared.workers[t].shared = &shared;
+        shared.workers[t].index = t;
+    }
+
+    if (max_nodes)
+        printf("A*: hasta %ld nodos por nivel", max_nodes);
+    else
+        printf("A*: nodos y resultados esperados de cada nivel");
+    printf(", tabla de %lu entradas, %d %s, %ld MB%s\n", 1ul << table_bits,
+           thread_count, thread_count == 1 ? "hilo" : "hilos", memory_mb,
+           deterministic ? ", determinista" : "");
+    printf("%-6s %-16s %7s %10s %10s %11s %9s %8s\n", "nivel", "resultado",
+           "turnos", "nodos", "estados", "nodos/s", "pico KB", "tiempo");
+
+    static char path[SOLVER_MAX_DEPTH];
+    int verified_count = 0, unverified = 0, mismatches = 0;
+    double total_time = 0.0;
+    long total_nodes = 0;
+    for (int level = 0; level < MAX_LEVELS; level++) {
+        if (only_level && level != only_level - 1)
+            continue;
+
+        const SolverExpected *expected =
+            &SOLVER_EXPECTED[deterministic][level];
+        shared.max_nodes = max_nodes ? max_nodes : expected->max_nodes;
+        shared.memory_limit = (size_t)memory_mb * 1024 * 1024;
+        uint32_t goal = 0;
+        double start = solver_now();
+        SolverResult result = solver_search(&shared, level, table_bits, &goal);
+        double elapsed = solver_now() - start;
+        total_time += elapsed;
+        total_nodes += shared.expanded;
+
+        size_t states = 0, peak_memory = shared.memory;
+        for (int t = 0; t < thread_count; t++) {
+            states += shared.workers[t].node_count;
+            peak_memory += shared.workers[t].peak_memory;
+        }
+        int length = result == SOLVER_SOLVED
+                         ? solver_path(&shared, goal, path, sizeof(path))
+                         : -1;
+        if (result == SOLVER_SOLVED &&
+            (length < 0 || !solver_verify(level, path, length, 0))) {
+            printf("%-6d la solucion no se repite al volver a jugarla\n",
+                   level + 1);
+            length = -1;
+        }
+        int reached = length >= 0
+                          ? solver_robust_streams(level, path, length)
+                          : SOLVER_STREAMS;
+        bool seeded = reached < SOLVER_STREAMS;
+        printf("%-6d %-16s %7d %10ld %10lu %11.0f %9lu %7.2fs\n", level + 1,
+               seeded ? SOLVER_SEEDED_NAME : SOLVER_RESULT_NAMES[result],
+               length, shared.expanded, (unsigned long)states,
+               elapsed > 0.0 ? shared.expanded / elapsed : 0.0,
+               (unsigned long)(peak_memory / 1024), elapsed);
+        if (length >= 0)
+            printf("       %.*s\n", length, path);
+        if (seeded)
+            printf("       llega a la salida con %d de otras %d secuencias "
+                   "de azar\n",
+                   reached, SOLVER_STREAMS);
+
+        if (length >= 0 && !seeded)
+            verified_count++;
+        else
+            unverified++;
+        if (!max_nodes && length != expected->turns) {
+            mismatches++;
+            if (expected->turns < 0)
+                printf("       esperado: sin solucion en el presupuesto\n");
+            else
+                printf("       esperado: solucion de %d turnos\n",
+                       expected->turns);
+        }
+        if (thread_count > 1)
+            solver_print_threads(&shared, elapsed);
+        solver_shared_free(&shared);
+    }
+
+    printf("total: %ld nodos en %.2f s (%.0f nodos/s), %d verificados, %d "
+           "sin verificar",
+           total_nodes, total_time,
+           total_time > 0.0 ? total_nodes / total_time : 0.0, verified_count,
+           unverified);
+    if (!max_nodes)
+        printf(", %d distintos de lo esperado", mismatches);
+    printf("\n");
+    free(shared.workers);
+    free(shared.chunks);
+    return unverified || mismatches ? 1 : 0;
+}
@@ -0,0 +1,401 @@
+/* Benchmark del pathfinding de colapsores y del flood fill: el nivel más
+ * grande (nivel 20) y mapas sintéticos grandes con pilares.
+ *
+ *   make bench-path
+ *   ./path_bench [iteraciones] [lado_mapa_sintetico] [iteraciones_sintetico]
+ *
+ * En el mapa sintético la BFS recorre casi todo el mapa en cada turno, así
+ * que ahí bastan pocas iteraciones. Las filas "antes" miden el pathing y
+ * la colisión de antes de los campos de distancias compartidos. */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "levels.h"
+#include "logic.h"
+#include "qiskit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS 2000
+#define BENCH_DEFAULT_SIDE 512
+#define BENCH_DEFAULT_BIG_ITERATIONS 4
+#define BENCH_PLAYER_SPOTS 64
+
+static double bench_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* Casillas de suelo repartidas por el mapa donde colocar al jugador; las
+ * mismas en cada llamada, para comparar con las filas "antes" */
+static int bench_player_spots(GameState *game, IVector2 *spots) {
+    int count = 0;
+    srand(1);
+    int rows = game->map->rows, cols = game->map->cols;
+    for (int i = 0; i < BENCH_PLAYER_SPOTS * 4 && count < BENCH_PLAYER_SPOTS;
+         i++) {
+        IVector2 p = ivec2(1 + rand() % (cols - 2), 1 + rand() % (rows - 2));
+        if (MAP_AT(game->map, p.x, p.y) == CELL_FLOOR)
+            spots[count++] = p;
+    }
+    return count;
+}
+
+/* Pathing de un turno: con el jugador en distintas casillas, cada colapsor
+ * vivo pide el campo con el que se movería. Devuelve microsegundos por
+ * turno. */
+static double bench_colapsor_paths(GameState *game, int iterations) {
+    IVector2 spots[BENCH_PLAYER_SPOTS];
+    int spot_count = bench_player_spots(game, spots);
+    if (spot_count == 0)
+        return 0.0;
+
+    double start = bench_now();
+    for (int it = 0; it < iterations; it++) {
+        game->player.position = spots[it % spot_count];
+        invalidate_distance_fields(game);
+        for (int i = 0; i < MAX_COLAPSORES; i++) {
+            if (!game->colapsores[i].dead)
+                colapsor_path_field(game, i);
+        }
+    }
+    return (bench_now() - start) * 1e6 / (double)iterations;
+}
+
+/* Consultas de colisión: cada colapsor vivo prueba las casillas de su
+ * alrededor, como al moverse. Devuelve nanosegundos por consulta. */
+static double bench_stand_queries(GameState *game, int iterations) {
+    long queries = 0, free_cells = 0;
+    double start = bench_now();
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 0; i < MAX_COLAPSORES; i++) {
+            ColapsarState *colapsor = &game->colapsores[i];
+            if (colapsor->dead)
+                continue;
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    IVector2 pos = ivec2_add(colapsor->position, ivec2(dx, dy));
+                    free_cells += colapsor_can_stand_here(game, pos, i);
+                    queries++;
+                }
+            }
+        }
+    }
+    double elapsed = bench_now() - start;
+    if (free_cells < 0) /* Evita que el compilador descarte las consultas */
+        printf("%ld\n", free_cells);
+    return queries > 0 ? elapsed * 1e9 / (double)queries : 0.0;
+}
+
+/* ===== ANTES: BFS POR COLAPSOR SOBRE int** =====
+ * Copia de lo que había antes de los campos de distancias compartidos (ver
+ * git log de src/logic.c): una rejilla int** por colapsor que se vuelve a
+ * poner a -1 en cada turno, una cola con malloc que desplaza todo el array
+ * en cada pop y la colisión que recorre todos los colapsores por casilla.
+ * Sólo sirve de referencia para las filas "antes". */
+
+typedef struct {
+    IVector2 *items;
+    int size;
+    int capacity;
+} BaselineQueue;
+
+static void baseline_queue_push(BaselineQueue *q, IVector2 item) {
+    if (q->size >= q->capacity) {
+        q->capacity *= 2;
+        q->items = realloc(q->items, q->capacity * sizeof(IVector2));
+    }
+    q->items[q->size++] = item;
+}
+
+static IVector2 baseline_queue_pop(BaselineQueue *q) {
+    IVector2 result = q->items[0];
+    q->size--;
+    for (int i = 0; i < q->size; i++)
+        q->items[i] = q->items[i + 1];
+    return result;
+}
+
+static int **baseline_path_create(int rows, int cols) {
+    int **path = malloc(rows * sizeof(int *));
+    for (int i = 0; i < rows; i++) {
+        path[i] = malloc(cols * sizeof(int));
+        for (int j = 0; j < cols; j++)
+            path[i][j] = -1;
+    }
+    return path;
+}
+
+static void baseline_path_free(int **path, int rows) {
+    for (int i = 0; i < rows; i++)
+        free(path[i]);
+    free(path);
+}
+
+static bool baseline_can_stand_here(GameState *game, IVector2 start,
+                                    int colapsor_idx) {
+    ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    for (int dx = 0; dx < colapsor->size.x; dx++) {
+        for (int dy = 0; dy < colapsor->size.y; dy++) {
+            IVector2 pos = ivec2(start.x + dx, start.y + dy);
+            if (!within_map(game, pos))
+                return false;
+            Cell cell = MAP_AT(game->map, pos.x, pos.y);
+            if (cell != CELL_FLOOR && cell != CELL_EXPLOSION)
+                return false;
+            for (int i = 0; i < MAX_COLAPSORES; i++) {
+                if (i == colapsor_idx || game->colapsores[i].dead)
+                    continue;
+                ColapsarState *other = &game->colapsores[i];
+                if (inside_of_rect(other->position, other->size, pos))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void baseline_recompute_path(GameState *game, int **path,
+                                    int colapsor_idx) {
+    ColapsarState *colapsor = &game->colapsores[colapsor_idx];
+    int rows = game->map->rows, cols = game->map->cols;
+    BaselineQueue q = {malloc(256 * sizeof(IVector2)), 0, 256};
+
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            path[i][j] = -1;
+
+    for (int dy = 0; dy < colapsor->size.y; dy++) {
+        for (int dx = 0; dx < colapsor->size.x; dx++) {
+            IVector2 pos = ivec2_sub(game->player.position, ivec2(dx, dy));
+            if (baseline_can_stand_here(game, pos, colapsor_idx)) {
+                path[pos.y][pos.x] = 0;
+                baseline_queue_push(&q, pos);
+            }
+        }
+    }
+
+    while (q.size > 0) {
+        IVector2 pos = baseline_queue_pop(&q);
+        if (ivec2_eq(pos, colapsor->position))
+            break;
+        if (path[pos.y][pos.x] >= 10)
+            break;
+        for (int dir = 0; dir < 4; dir++) {
+            IVector2 new_pos = ivec2_add(pos, DIRECTION_VECTORS[dir]);
+            for (int step = 1; step <= 100; step++) {
+                if (!baseline_can_stand_here(game, new_pos, colapsor_idx))
+                    break;
+                if (path[new_pos.y][new_pos.x] >= 0)
+                    break;
+                path[new_pos.y][new_pos.x] = path[pos.y][pos.x] + 1;
+                baseline_queue_push(&q, new_pos);
+                new_pos = ivec2_add(new_pos, DIRECTION_VECTORS[dir]);
+            }
+        }
+    }
+    free(q.items);
+}
+
+/* Lo mismo que bench_colapsor_paths, con las mismas casillas del jugador:
+ * cada colapsor vivo rehace su BFS */
+static double bench_baseline_paths(GameState *game, int iterations) {
+    IVector2 spots[BENCH_PLAYER_SPOTS];
+    int spot_count = bench_player_spots(game, spots);
+    if (spot_count == 0)
+        return 0.0;
+
+    int rows = game->map->rows, cols = game->map->cols;
+    int **paths[MAX_COLAPSORES] = {0};
+    for (int i = 0; i < MAX_COLAPSORES; i++) {
+        if (!game->colapsores[i].dead)
+            paths[i] = baseline_path_create(rows, cols);
+    }
+
+    double start = bench_now();
+    for (int it = 0; it < iterations; it++) {
+        game->player.position = spots[it % spot_count];
+        for (int i = 0; i < MAX_COLAPSORES; i++) {
+            if (paths[i])
+                baseline_recompute_path(game, paths[i], i);
+        }
+    }
+    double elapsed = bench_now() - start;
+
+    for (int i = 0; i < MAX_COLAPSORES; i++) {
+        if (paths[i])
+            baseline_path_free(paths[i], rows);
+    }
+    return elapsed * 1e6 / (double)iterations;
+}
+
+/* Lo mismo que bench_stand_queries con la colisión de antes */
+static double bench_baseline_stand_queries(GameState *game, int iterations) {
+    long queries = 0, free_cells = 0;
+    double start = bench_now();
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 0; i < MAX_COLAPSORES; i++) {
+            ColapsarState *colapsor = &game->colapsores[i];
+            if (colapsor->dead)
+                continue;
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    IVector2 pos = ivec2_add(colapsor->position, ivec2(dx, dy));
+                    free_cells += baseline_can_stand_here(game, pos, i);
+                    queries++;
+                }
+            }
+        }
+    }
+    double elapsed = bench_now() - start;
+    if (free_cells < 0)
+        printf("%ld\n", free_cells);
+    return queries > 0 ? elapsed * 1e9 / (double)queries : 0.0;
+}
+
+static int bench_live_colapsores(GameState *game) {
+    int count = 0;
+    for (int i = 0; i < MAX_COLAPSORES; i++)
+        count += !game->colapsores[i].dead;
+    return count;
+}
+
+/* Rellena todo el suelo conectado con la casilla (1,1) y lo devuelve a su
+ * estado. Devuelve microsegundos por relleno. */
+static double bench_flood_fill(GameState *game, int iterations) {
+    IVector2 start = ivec2(1, 1);
+    if (MAP_AT(game->map, start.x, start.y) != CELL_FLOOR)
+        return 0.0;
+
+    double t0 = bench_now();
+    for (int it = 0; it < iterations; it++) {
+        flood_fill(game, start, CELL_EXPLOSION);
+        flood_fill(game, start, CELL_FLOOR);
+    }
+    return (bench_now() - t0) * 1e6 / (double)(2 * iterations);
+}
+
+/* Limpieza de explosiones de un turno en el que no ha estallado nada.
+ * Devuelve microsegundos por turno. */
+static double bench_explosions_turn(GameState *game, int iterations) {
+    game_explosions_turn(game); /* Descarta lo que dejó el flood fill */
+    double t0 = bench_now();
+    for (int it = 0; it < iterations; it++)
+        game_explosions_turn(game);
+    return (bench_now() - t0) * 1e6 / (double)iterations;
+}
+
+static void bench_synthetic_map(GameState *game, int side);
+
+/* Reinicio del nivel cargado (ENTER al morir) o, con side > 0, del mapa
+ * sintético, con los caminos del primer turno. Devuelve microsegundos por
+ * reinicio. */
+static double bench_restart(GameState *game, int side, int iterations) {
+    double t0 = bench_now();
+    for (int it = 0; it < iterations; it++) {
+        if (side > 0)
+            bench_synthetic_map(game, side);
+        else
+            load_level(game, game->current_level);
+        for (int i = 0; i < MAX_COLAPSORES; i++) {
+            if (!game->colapsores[i].dead)
+                colapsor_path_field(game, i);
+        }
+    }
+    return (bench_now() - t0) * 1e6 / (double)iterations;
+}
+
+/* Sala cuadrada con pilares cada 6 casillas, un guardia por cuadrante y
+ * una fila de gnomos */
+static void bench_synthetic_map(GameState *game, int side) {
+    init_game_state(game, side, side);
+    make_room(game);
+    for (int y = 6; y < side - 1; y += 6)
+        for (int x = 6; x < side - 1; x += 6)
+            MAP_AT(game->map, x, y) = CELL_WALL;
+    map_rebuild_passability(game);
+
+    spawn_guard(game, ivec2(side / 4, side / 4));
+    spawn_guard(game, ivec2(3 * side / 4, side / 4));
+    spawn_guard(game, ivec2(side / 4, 3 * side / 4));
+    spawn_guard(game, ivec2(3 * side / 4, 3 * side / 4));
+    for (int i = 0; i < 8; i++)
+        spawn_gnome(game, ivec2(side / 2 + 2 * i - 8, side / 2 + 1));
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    int side = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_SIDE;
+    int big_iterations =
+        argc > 3 ? atoi(argv[3]) : BENCH_DEFAULT_BIG_ITERATIONS;
+    if (iterations <= 0)
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    if (side < 16)
+        side = BENCH_DEFAULT_SIDE;
+    if (big_iterations <= 0)
+        big_iterations = BENCH_DEFAULT_BIG_ITERATIONS;
+    srand(1);
+    qiskit_set_local_only(true);
+
+    static GameState game;
+    game.pending_next_level = -1;
+
+    game.current_level = MAX_LEVELS - 1;
+    load_level(&game, game.current_level);
+    printf("Nivel 20 (%dx%d, %d colapsores), %d iteraciones\n",
+           game.map->cols, game.map->rows, bench_live_colapsores(&game),
+           iterations);
+    printf("  caminos por turno: %10.2f us\n",
+           bench_colapsor_paths(&game, iterations));
+    printf("    antes:           %10.2f us\n",
+           bench_baseline_paths(&game, iterations));
+    printf("  colision:          %10.2f ns\n",
+           bench_stand_queries(&game, iterations));
+    printf("    antes:           %10.2f ns\n",
+           bench_baseline_stand_queries(&game, iterations));
+    printf("  flood fill:        %10.2f us\n",
+           bench_flood_fill(&game, iterations));
+    printf("  turno explosiones: %10.2f us\n",
+           bench_explosions_turn(&game, iterations));
+    printf("  reinicio:          %10.2f us\n",
+           bench_restart(&game, 0, iterations));
+    fflush(stdout);
+
+    bench_synthetic_map(&game, side);
+    printf("Sintetico %dx%d (%d colapsores), %d iteraciones\n", side, side,
+           bench_live_colapsores(&game), big_iterations);
+    printf("  caminos por turno: %10.2f us\n",
+           bench_colapsor_paths(&game, big_iterations));
+    fflush(stdout);
+    /* La BFS de antes tarda segundos por turno en este mapa: basta una */
+    printf("    antes:           %10.2f us\n", bench_baseline_paths(&game, 1));
+    printf("  colision:          %10.2f ns\n",
+           bench_stand_queries(&game, iterations));
+    printf("    antes:           %10.2f ns\n",
+           bench_baseline_stand_queries(&game, iterations));
+    printf("  flood fill:        %10.2f us\n",
+           bench_flood_fill(&game, big_iterations));
+    printf("  turno explosiones: %10.2f us\n",
+           bench_explosions_turn(&game, iterations));
+    printf("  reinicio:          %10.2f us\n",
+           bench_restart(&game, side, big_iterations));
+
+    free_level_state(&game);
+    qiskit_shutdown();
+    return 0;
+}
@@ -0,0 +1,179 @@
+/* Benchmark del simulador cuántico: vector de estado denso frente al tableau
+ * de estabilizadores (CHP) con circuitos Clifford aleatorios.
+ *
+ *   make bench-quantum
+ *   ./quantum_bench [puertas] [max_qubits_denso]
+ *
+ * Enlaza sólo libphaseshift_core: no necesita raylib ni audio. */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "qiskit.h"
+#include "quantum.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define BENCH_DEFAULT_GATES 2000
+#define BENCH_DEFAULT_MAX_DENSE 22
+#define BENCH_MAX_MEASURES 64
+
+static const QGate QGATE_PHASE_S = {{1.0f, 0.0f, 0.0f, 0.0f},
+                                    {0.0f, 0.0f, 0.0f, 1.0f}};
+
+typedef struct {
+    unsigned char kind; /* 0 = H, 1 = S, 2 = X, 3 = CNOT */
+    int a, b;
+} BenchGate;
+
+static double bench_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static void bench_random_circuit(BenchGate *gates, int count, int n) {
+    for (int i = 0; i < count; i++) {
+        gates[i].kind = (unsigned char)(rand() % (n > 1 ? 4 : 3));
+        gates[i].a = rand() % n;
+        gates[i].b = rand() % n;
+        if (gates[i].kind == 3 && gates[i].a == gates[i].b)
+            gates[i].b = (gates[i].a + 1) % n;
+    }
+}
+
+/* Tiempos por puerta (ns) y por medida (us) del vector de estado */
+static bool bench_dense(const BenchGate *gates, int count, int n,
+                        double *gate_ns, double *measure_us) {
+    StateVector *sv = statevector_create(n);
+    if (!sv)
+        return false;
+
+    double t0 = bench_now();
+    for (int i = 0; i < count; i++) {
+        const BenchGate *g = &gates[i];
+        switch (g->kind) {
+        case 0:
+            statevector_apply_gate(sv, g->a, &QGATE_HADAMARD);
+            break;
+        case 1:
+            statevector_apply_gate(sv, g->a, &QGATE_PHASE_S);
+            break;
+        case 2:
+            statevector_apply_gate(sv, g->a, &QGATE_PAULI_X);
+            break;
+        default:
+            statevector_apply_controlled_gate(sv, g->a, g->b, &QGATE_PAULI_X);
+            break;
+        }
+    }
+    double t1 = bench_now();
+
+    int measures = n < BENCH_MAX_MEASURES ? n : BENCH_MAX_MEASURES;
+    for (int q = 0; q < measures; q++) {
+        statevector_measure(sv, q);
+    }
+    double t2 = bench_now();
+
+    *gate_ns = (t1 - t0) / count * 1e9;
+    *measure_us = (t2 - t1) / measures * 1e6;
+    statevector_free(sv);
+    return true;
+}
+
+static bool bench_stabilizer(const BenchGate *gates, int count, int n,
+                             double *gate_ns, double *measure_us) {
+    StabilizerState *st = stabilizer_create(n);
+    if (!st)
+        return false;
+
+    double t0 = bench_now();
+    for (int i = 0; i < count; i++) {
+        const BenchGate *g = &gates[i];
+        switch (g->kind) {
+        case 0:
+            stabilizer_hadamard(st, g->a);
+            break;
+        case 1:
+            stabilizer_phase(st, g->a);
+            break;
+        case 2:
+            stabilizer_pauli_x(st, g->a);
+            break;
+        default:
+            stabilizer_cnot(st, g->a, g->b);
+            break;
+        }
+    }
+    double t1 = bench_now();
+
+    int measures = n < BENCH_MAX_MEASURES ? n : BENCH_MAX_MEASURES;
+    for (int q = 0; q < measures; q++) {
+        stabilizer_measure(st, q);
+    }
+    double t2 = bench_now();
+
+    *gate_ns = (t1 - t0) / count * 1e9;
+    *measure_us = (t2 - t1) / measures * 1e6;
+    stabilizer_free(st);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    static const int sizes[] = {5, 10, 16, 20, 22, 24, 100, 500, 1000, 2000};
+    int gate_count = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_GATES;
+    int max_dense = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_MAX_DENSE;
+    if (gate_count <= 0)
+        gate_count = BENCH_DEFAULT_GATES;
+
+    /* Simulador local con semilla: sin red en el benchmark */
+    qiskit_set_local_only(true);
+    srand(1234);
+
+    BenchGate *gates = malloc(sizeof(BenchGate) * (size_t)gate_count);
+    if (!gates)
+        return 1;
+
+    printf("%d random Clifford gates (H/S/X/CNOT), then up to %d "
+           "measurements\n\n",
+           gate_count, BENCH_MAX_MEASURES);
+    printf("%7s | %14s %14s | %14s %14s\n", "qubits", "dense ns/gate",
+           "dense us/meas", "tableau ns/gate", "tableau us/meas");
+    printf("--------+-------------------------------+--------------------"
+           "-----------\n");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        int n = sizes[i];
+        bench_random_circuit(gates, gate_count, n);
+
+        char dense_gate[32] = "-", dense_meas[32] = "-";
+        double g_ns, m_us;
+        if (n <= max_dense && bench_dense(gates, gate_count, n, &g_ns, &m_us)) {
+            snprintf(dense_gate, sizeof(dense_gate), "%.1f", g_ns);
+            snprintf(dense_meas, sizeof(dense_meas), "%.2f", m_us);
+        }
+
+        if (!bench_stabilizer(gates, gate_count, n, &g_ns, &m_us)) {
+            printf("%7d | out of memory\n", n);
+            continue;
+        }
+        printf("%7d | %14s %14s | %14.1f %14.2f\n", n, dense_gate, dense_meas,
+               g_ns, m_us);
+    }
+
+    free(gates);
+    return 0;
+}
@@ -0,0 +1,121 @@
+"""Prueba de carga del servidor cuántico.
+
+Lanza muchos clientes simulados en localhost, cada uno con su conexión
+HTTP/1.1 persistente, y mide peticiones por segundo y latencias de cola.
+
+    python3 quantum_server.py --async --port 8609 &
+    python3 tools/quantum_load_test.py --clients 200 --duration 10
+
+Sólo usa la biblioteca estándar. Con --endpoint mix cada cliente alterna
+/generate_bit, /measure y /generate_bits como hace el juego.
+"""
+
+import argparse
+import asyncio
+import time
+
+ENDPOINTS = {
+    "bit": ["/generate_bit"],
+    "measure": ["/measure?p=0.95"],
+    "bits": ["/generate_bits?n=4096"],
+    "mix": ["/generate_bit", "/measure?p=0.95", "/generate_bits?n=4096"],
+}
+
+
+async def read_response(reader):
+    """Lee una respuesta con Content-Length. Devuelve (estado, keep_alive)."""
+    status_line = await reader.readline()
+    if not status_line:
+        raise ConnectionError("conexión cerrada")
+    status = int(status_line.split()[1])
+
+    length = 0
+    keep_alive = status_line.startswith(b"HTTP/1.1")
+    while True:
+        line = await reader.readline()
+        if line in (b"\r\n", b"\n", b""):
+            break
+        name, _, value = line.decode("latin-1").partition(":")
+        name = name.strip().lower()
+        if name == "content-length":
+            length = int(value)
+        elif name == "connection":
+            keep_alive = value.strip().lower() != "close"
+
+    await reader.readexactly(length)
+    return status, keep_alive
+
+
+async def client(host, port, paths, deadline, timeout, latencies, errors):
+    reader = writer = None
+    i = 0
+    while time.perf_counter() < deadline:
+        path = paths[i % len(paths)]
+        i += 1
+        try:
+            if writer is None:
+                reader, writer = await asyncio.wait_for(
+                    asyncio.open_connection(host, port), timeout)
+
+            start = time.perf_counter()
+            writer.write(f"GET {path} HTTP/1.1\r\nHost: {host}:{port}\r\n"
+                         f"Connection: keep-alive\r\n\r\n".encode("latin-1"))
+            status, keep_alive = await asyncio.wait_for(read_response(reader),
+                                                        timeout)
+            latencies.append(time.perf_counter() - start)
+
+            if status != 200:
+                errors[0] += 1
+            if not keep_alive:
+                writer.close()
+                writer = None
+        except (OSError, ConnectionError, asyncio.IncompleteReadError,
+                asyncio.TimeoutError, ValueError):
+            errors[0] += 1
+            if writer is not None:
+                writer.close()
+            writer = None
+            await asyncio.sleep(0.01)
+
+    if writer is not None:
+        writer.close()
+
+
+def percentile(sorted_values, q):
+    if not sorted_values:
+        return 0.0
+    index = min(len(sorted_values) - 1, int(q * (len(sorted_values) - 1) + 0.5))
+    return sorted_values[index]
+
+
+async def run(args):
+    latencies = []
+    errors = [0]
+    paths = ENDPOINTS[args.endpoint]
+
+    start = time.perf_counter()
+    deadline = start + args.duration
+    await asyncio.gather(*(client(args.host, args.port, paths, deadline,
+                                  args.timeout, latencies, errors)
+                           for _ in range(args.clients)))
+    elapsed = time.perf_counter() - start
+
+    latencies.sort()
+    ms = [1000.0 * percentile(latencies, q) for q in (0.50, 0.95, 0.99)]
+    print(f"{args.clients} clientes, {args.duration:.0f} s, endpoint {args.endpoint}")
+    print(f"peticiones: {len(latencies)} ({errors[0]} errores)")
+    print(f"rendimiento: {len(latencies) / elapsed:.0f} peticiones/s")
+    print(f"latencia ms: p50 {ms[0]:.2f}  p95 {ms[1]:.2f}  p99 {ms[2]:.2f}  "
+          f"max {1000.0 * (latencies[-1] if latencies else 0.0):.2f}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8609)
+    parser.add_argument("--clients", type=int, default=100)
+    parser.add_argument("--duration", type=float, default=10.0)
+    parser.add_argument("--endpoint", choices=sorted(ENDPOINTS), default="mix")
+    parser.add_argument("--timeout", type=float, default=5.0,
+                        help="segundos por petición antes de contarla como error")
+    asyncio.run(run(parser.parse_args()))